@@ -42,7 +42,7 @@ namespace Audio {
  */
 class Channel {
 public:
-	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent);
+	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent, RateConverterQuality quality);
 	~Channel();
 
 	/**
@@ -59,7 +59,7 @@ public:
 	/**
 	 * Queries whether the channel is still playing or not.
 	 */
-	bool isFinished() const { return _stream->endOfStream(); }
+	bool isFinished() const { return _stream->endOfStream() && _converter->isDrained(); }
 
 	/**
 	 * Queries whether the channel is a permanent channel.
@@ -173,12 +173,16 @@ private:
 
 
 MixerImpl::MixerImpl(OSystem *system, uint sampleRate)
-	: _syst(system), _mutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings() {
+	: _syst(system), _mutex(), _commandMutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0),
+	  _converterQuality(kRateConverterQualityLow), _soundTypeSettings(),
+	  _numActiveChannels(0), _numPendingCommands(0) {
 
 	assert(sampleRate > 0);
 
-	for (int i = 0; i != NUM_CHANNELS; i++)
+	for (int i = 0; i != NUM_CHANNELS; i++) {
 		_channels[i] = 0;
+		_activeChannels[i] = 0;
+	}
 }
 
 MixerImpl::~MixerImpl() {
@@ -194,6 +198,31 @@ uint MixerImpl::getOutputRate() const {
 	return _sampleRate;
 }
 
+Channel *MixerImpl::findChannel(SoundHandle handle) const {
+	const int index = handle._val % NUM_CHANNELS;
+	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+		return 0;
+
+	return _channels[index];
+}
+
+Channel *MixerImpl::unlinkChannel(int index) {
+	Channel *chan = _channels[index];
+	assert(chan);
+	_channels[index] = 0;
+
+	// Keep the active list packed and in slot order; the order in which
+	// the channels are mixed affects clipping, so it must not change.
+	uint pos = 0;
+	while (_activeChannels[pos] != chan)
+		pos++;
+	for (; pos + 1 < _numActiveChannels; pos++)
+		_activeChannels[pos] = _activeChannels[pos + 1];
+	_activeChannels[--_numActiveChannels] = 0;
+
+	return chan;
+}
+
 void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 	int index = -1;
 	for (int i = 0; i != NUM_CHANNELS; i++) {
@@ -210,6 +239,14 @@ void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 
 	_channels[index] = chan;
 
+	uint pos = _numActiveChannels;
+	while (pos > 0 && (_activeChannels[pos - 1]->getHandle()._val % NUM_CHANNELS) > (uint)index) {
+		_activeChannels[pos] = _activeChannels[pos - 1];
+		pos--;
+	}
+	_activeChannels[pos] = chan;
+	_numActiveChannels++;
+
 	SoundHandle chanHandle;
 	chanHandle._val = index + (_handleSeed * NUM_CHANNELS);
 
@@ -219,6 +256,72 @@ void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 		*handle = chanHandle;
 }
 
+bool MixerImpl::queueCommand(ChannelCommand::Type type, SoundHandle handle, int value) {
+	Common::StackLock lock(_commandMutex);
+
+	for (uint i = 0; i < _numPendingCommands; i++) {
+		ChannelCommand &cmd = _pendingCommands[i];
+		if (cmd.type == type && cmd.handle._val == handle._val) {
+			cmd.value = value;
+			return true;
+		}
+	}
+
+	if (_numPendingCommands == MAX_PENDING_COMMANDS)
+		return false;
+
+	ChannelCommand &cmd = _pendingCommands[_numPendingCommands++];
+	cmd.type = type;
+	cmd.handle = handle;
+	cmd.value = value;
+	return true;
+}
+
+bool MixerImpl::findPendingCommand(ChannelCommand::Type type, SoundHandle handle, int &value) {
+	Common::StackLock lock(_commandMutex);
+
+	for (uint i = 0; i < _numPendingCommands; i++) {
+		const ChannelCommand &cmd = _pendingCommands[i];
+		if (cmd.type == type && cmd.handle._val == handle._val) {
+			value = cmd.value;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void MixerImpl::applyPendingCommands() {
+	ChannelCommand commands[MAX_PENDING_COMMANDS];
+	uint numCommands;
+
+	// Grab the queue and release the lock right away, so that the engine
+	// side can keep queueing while we process the commands.
+	{
+		Common::StackLock lock(_commandMutex);
+		numCommands = _numPendingCommands;
+		for (uint i = 0; i < numCommands; i++)
+			commands[i] = _pendingCommands[i];
+		_numPendingCommands = 0;
+	}
+
+	for (uint i = 0; i < numCommands; i++) {
+		// Commands for sounds that terminated in the meantime are dropped
+		Channel *chan = findChannel(commands[i].handle);
+		if (!chan)
+			continue;
+
+		switch (commands[i].type) {
+		case ChannelCommand::kSetVolume:
+			chan->setVolume((byte)commands[i].value);
+			break;
+		case ChannelCommand::kSetBalance:
+			chan->setBalance((int8)commands[i].value);
+			break;
+		}
+	}
+}
+
 void MixerImpl::playStream(
 			SoundType type,
 			SoundHandle *handle,
@@ -227,8 +330,6 @@ void MixerImpl::playStream(
 			DisposeAfterUse::Flag autofreeStream,
 			bool permanent,
 			bool reverseStereo) {
-	Common::StackLock lock(_mutex);
-
 	if (stream == 0) {
 		warning("stream is 0");
 		return;
@@ -237,97 +338,136 @@ void MixerImpl::playStream(
 
 	assert(_mixerReady);
 
+#ifdef AUDIO_REVERSE_STEREO
+	reverseStereo = !reverseStereo;
+#endif
+
+	// Create the channel. This sets up the rate converter, so we do it
+	// before taking the lock to keep the audio callback from waiting on it.
+	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent, _converterQuality);
+	chan->setVolume(volume);
+	chan->setBalance(balance);
+
+	Common::StackLock lock(_mutex);
+
 	// Prevent duplicate sounds
 	if (id != -1) {
-		for (int i = 0; i != NUM_CHANNELS; i++)
-			if (_channels[i] != 0 && _channels[i]->getId() == id) {
+		for (uint i = 0; i != _numActiveChannels; i++)
+			if (_activeChannels[i]->getId() == id) {
 				// Delete the stream if were asked to auto-dispose it.
 				// Note: This could cause trouble if the client code does not
 				// yet expect the stream to be gone. The primary example to
 				// keep in mind here is QueuingAudioStream.
 				// Thus, as a quick rule of thumb, you should never, ever,
 				// try to play QueuingAudioStreams with a sound id.
-				if (autofreeStream == DisposeAfterUse::YES)
-					delete stream;
+				// Deleting the channel takes care of that.
+				delete chan;
 				return;
 			}
 	}
 
-#ifdef AUDIO_REVERSE_STEREO
-	reverseStereo = !reverseStereo;
-#endif
-
-	// Create the channel
-	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent);
-	chan->setVolume(volume);
-	chan->setBalance(balance);
 	insertChannel(handle, chan);
 }
 
 int MixerImpl::mixCallback(byte *samples, uint len) {
 	assert(samples);
 
-	Common::StackLock lock(_mutex);
-
 	int16 *buf = (int16 *)samples;
 	// we store stereo, 16-bit samples
 	assert(len % 4 == 0);
 	len >>= 2;
 
-	// Since the mixer callback has been called, the mixer must be ready...
-	_mixerReady = true;
-
-	//  zero the buf
-	memset(buf, 0, 2 * len * sizeof(int16));
+	// Channels which finished playing are only destroyed after the lock
+	// has been released, since disposing of their streams may be slow.
+	Channel *finished[NUM_CHANNELS];
+	uint numFinished = 0;
 
-	// mix all channels
 	int res = 0, tmp;
-	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i]) {
-			if (_channels[i]->isFinished()) {
-				delete _channels[i];
-				_channels[i] = 0;
-			} else if (!_channels[i]->isPaused()) {
-				tmp = _channels[i]->mix(buf, len);
+
+	{
+		Common::StackLock lock(_mutex);
+
+		// Since the mixer callback has been called, the mixer must be ready...
+		_mixerReady = true;
+
+		applyPendingCommands();
+
+		//  zero the buf
+		memset(buf, 0, 2 * len * sizeof(int16));
+
+		// mix all channels
+		for (uint i = 0; i < _numActiveChannels; ) {
+			Channel *chan = _activeChannels[i];
+
+			if (chan->isFinished()) {
+				// Unlinking shifts the following channels down by one
+				finished[numFinished++] = unlinkChannel(chan->getHandle()._val % NUM_CHANNELS);
+				continue;
+			}
+
+			if (!chan->isPaused()) {
+				tmp = chan->mix(buf, len);
 
 				if (tmp > res)
 					res = tmp;
 			}
+
+			i++;
 		}
+	}
+
+	for (uint i = 0; i < numFinished; i++)
+		delete finished[i];
 
 	return res;
 }
 
 void MixerImpl::stopAll() {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && !_channels[i]->isPermanent()) {
-			delete _channels[i];
-			_channels[i] = 0;
+	Channel *stopped[NUM_CHANNELS];
+	uint numStopped = 0;
+
+	{
+		Common::StackLock lock(_mutex);
+		for (int i = 0; i != NUM_CHANNELS; i++) {
+			if (_channels[i] != 0 && !_channels[i]->isPermanent())
+				stopped[numStopped++] = unlinkChannel(i);
 		}
 	}
+
+	for (uint i = 0; i < numStopped; i++)
+		delete stopped[i];
 }
 
 void MixerImpl::stopID(int id) {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && _channels[i]->getId() == id) {
-			delete _channels[i];
-			_channels[i] = 0;
+	Channel *stopped[NUM_CHANNELS];
+	uint numStopped = 0;
+
+	{
+		Common::StackLock lock(_mutex);
+		for (int i = 0; i != NUM_CHANNELS; i++) {
+			if (_channels[i] != 0 && _channels[i]->getId() == id)
+				stopped[numStopped++] = unlinkChannel(i);
 		}
 	}
+
+	for (uint i = 0; i < numStopped; i++)
+		delete stopped[i];
 }
 
 void MixerImpl::stopHandle(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	Channel *chan;
 
-	// Simply ignore stop requests for handles of sounds that already terminated
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return;
+	{
+		Common::StackLock lock(_mutex);
 
-	delete _channels[index];
-	_channels[index] = 0;
+		// Simply ignore stop requests for handles of sounds that already terminated
+		if (!findChannel(handle))
+			return;
+
+		chan = unlinkChannel(handle._val % NUM_CHANNELS);
+	}
+
+	delete chan;
 }
 
 void MixerImpl::muteSoundType(SoundType type, bool mute) {
@@ -346,39 +486,51 @@ bool MixerImpl::isSoundTypeMuted(SoundType type) const {
 }
 
 void MixerImpl::setChannelVolume(SoundHandle handle, byte volume) {
-	Common::StackLock lock(_mutex);
-
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	// Volume changes are frequent (fades), so they are handed to the audio
+	// callback instead of waiting for it to finish mixing.
+	if (queueCommand(ChannelCommand::kSetVolume, handle, volume))
 		return;
 
-	_channels[index]->setVolume(volume);
+	Common::StackLock lock(_mutex);
+
+	Channel *chan = findChannel(handle);
+	if (chan)
+		chan->setVolume(volume);
 }
 
 byte MixerImpl::getChannelVolume(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	int volume;
+	if (findPendingCommand(ChannelCommand::kSetVolume, handle, volume))
+		return (byte)volume;
+
+	Channel *chan = findChannel(handle);
+	if (!chan)
 		return 0;
 
-	return _channels[index]->getVolume();
+	return chan->getVolume();
 }
 
 void MixerImpl::setChannelBalance(SoundHandle handle, int8 balance) {
-	Common::StackLock lock(_mutex);
-
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	if (queueCommand(ChannelCommand::kSetBalance, handle, balance))
 		return;
 
-	_channels[index]->setBalance(balance);
+	Common::StackLock lock(_mutex);
+
+	Channel *chan = findChannel(handle);
+	if (chan)
+		chan->setBalance(balance);
 }
 
 int8 MixerImpl::getChannelBalance(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	int balance;
+	if (findPendingCommand(ChannelCommand::kSetBalance, handle, balance))
+		return (int8)balance;
+
+	Channel *chan = findChannel(handle);
+	if (!chan)
 		return 0;
 
-	return _channels[index]->getBalance();
+	return chan->getBalance();
 }
 
 uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
@@ -388,20 +540,17 @@ uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
 Timestamp MixerImpl::getElapsedTime(SoundHandle handle) {
 	Common::StackLock lock(_mutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Channel *chan = findChannel(handle);
+	if (!chan)
 		return Timestamp(0, _sampleRate);
 
-	return _channels[index]->getElapsedTime();
+	return chan->getElapsedTime();
 }
 
 void MixerImpl::pauseAll(bool paused) {
 	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0) {
-			_channels[i]->pause(paused);
-		}
-	}
+	for (uint i = 0; i != _numActiveChannels; i++)
+		_activeChannels[i]->pause(paused);
 }
 
 void MixerImpl::pauseID(int id, bool paused) {
@@ -418,39 +567,38 @@ void MixerImpl::pauseHandle(SoundHandle handle, bool paused) {
 	Common::StackLock lock(_mutex);
 
 	// Simply ignore (un)pause requests for sounds that already terminated
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Channel *chan = findChannel(handle);
+	if (!chan)
 		return;
 
-	_channels[index]->pause(paused);
+	chan->pause(paused);
 }
 
 bool MixerImpl::isSoundIDActive(int id) {
 	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i] && _channels[i]->getId() == id)
+	for (uint i = 0; i != _numActiveChannels; i++)
+		if (_activeChannels[i]->getId() == id)
 			return true;
 	return false;
 }
 
 int MixerImpl::getSoundID(SoundHandle handle) {
 	Common::StackLock lock(_mutex);
-	const int index = handle._val % NUM_CHANNELS;
-	if (_channels[index] && _channels[index]->getHandle()._val == handle._val)
-		return _channels[index]->getId();
+	Channel *chan = findChannel(handle);
+	if (chan)
+		return chan->getId();
 	return 0;
 }
 
 bool MixerImpl::isSoundHandleActive(SoundHandle handle) {
 	Common::StackLock lock(_mutex);
-	const int index = handle._val % NUM_CHANNELS;
-	return _channels[index] && _channels[index]->getHandle()._val == handle._val;
+	return findChannel(handle) != 0;
 }
 
 bool MixerImpl::hasActiveChannelOfType(SoundType type) {
 	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i] && _channels[i]->getType() == type)
+	for (uint i = 0; i != _numActiveChannels; i++)
+		if (_activeChannels[i]->getType() == type)
 			return true;
 	return false;
 }
@@ -470,9 +618,9 @@ void MixerImpl::setVolumeForSoundType(SoundType type, int volume) {
 	Common::StackLock lock(_mutex);
 	_soundTypeSettings[type].volume = volume;
 
-	for (int i = 0; i != NUM_CHANNELS; ++i) {
-		if (_channels[i] && _channels[i]->getType() == type)
-			_channels[i]->notifyGlobalVolChange();
+	for (uint i = 0; i != _numActiveChannels; ++i) {
+		if (_activeChannels[i]->getType() == type)
+			_activeChannels[i]->notifyGlobalVolChange();
 	}
 }
 
@@ -488,7 +636,8 @@ int MixerImpl::getVolumeForSoundType(SoundType type) const {
 #pragma mark -
 
 Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
-                 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent)
+                 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent,
+                 RateConverterQuality quality)
     : _type(type), _mixer(mixer), _id(id), _permanent(permanent), _volume(Mixer::kMaxChannelVolume),
       _balance(0), _pauseLevel(0), _samplesConsumed(0), _samplesDecoded(0), _mixerTimeStamp(0),
       _pauseStartTime(0), _pauseTime(0), _converter(0),
@@ -497,7 +646,7 @@ Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
 	assert(stream);
 
 	// Get a rate converter instance
-	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), reverseStereo);
+	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), reverseStereo, quality);
 }
 
 Channel::~Channel() {
@@ -601,7 +750,12 @@ int Channel::mix(int16 *data, uint len) {
 	int res = 0;
 
 	if (_stream->endOfData()) {
-		// TODO: call drain method
+		// Output what the converter still holds back, once no more data
+		// will appear in the stream
+		if (_stream->endOfStream()) {
+			res = _converter->drain(data, len, _volL, _volR);
+			_samplesDecoded += res;
+		}
 	} else {
 		assert(_converter);
 		_samplesConsumed = _samplesDecoded;
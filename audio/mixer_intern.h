@@ -26,6 +26,7 @@
 #include "common/scummsys.h"
 #include "common/mutex.h"
 #include "audio/mixer.h"
+#include "audio/rate.h"
 
 namespace Audio {
 
@@ -51,15 +52,23 @@ namespace Audio {
 class MixerImpl : public Mixer {
 private:
 	enum {
-		NUM_CHANNELS = 16
+		NUM_CHANNELS = 16,
+		MAX_PENDING_COMMANDS = 64
 	};
 
 	OSystem *_syst;
 	Common::Mutex _mutex;
 
+	/**
+	 * Protects _pendingCommands. Unlike _mutex, this is never held while
+	 * mixing, so queueing a command never waits for the audio callback.
+	 */
+	Common::Mutex _commandMutex;
+
 	const uint _sampleRate;
 	bool _mixerReady;
 	uint32 _handleSeed;
+	RateConverterQuality _converterQuality;
 
 	struct SoundTypeSettings {
 		SoundTypeSettings() : mute(false), volume(kMaxMixerVolume) {}
@@ -69,8 +78,69 @@ private:
 	};
 
 	SoundTypeSettings _soundTypeSettings[4];
+
+	/** Channel slots, indexed by handle value modulo NUM_CHANNELS. */
 	Channel *_channels[NUM_CHANNELS];
 
+	/**
+	 * The occupied slots of _channels, packed and kept in slot order, so
+	 * that the mixer callback only visits channels which actually exist.
+	 */
+	Channel *_activeChannels[NUM_CHANNELS];
+	uint _numActiveChannels;
+
+	/**
+	 * A deferred channel property change. These are queued by the engine
+	 * side and applied at the start of the next mixCallback() run.
+	 */
+	struct ChannelCommand {
+		enum Type {
+			kSetVolume,
+			kSetBalance
+		};
+
+		Type type;
+		SoundHandle handle;
+		int value;
+	};
+
+	ChannelCommand _pendingCommands[MAX_PENDING_COMMANDS];
+	uint _numPendingCommands;
+
+	/**
+	 * Queue a channel property change. A pending command of the same type
+	 * for the same handle is overwritten.
+	 *
+	 * @return false if the queue is full and the caller has to apply the
+	 *         change directly
+	 */
+	bool queueCommand(ChannelCommand::Type type, SoundHandle handle, int value);
+
+	/**
+	 * Look up the most recently queued value of a channel property.
+	 *
+	 * @return true if such a command is still pending
+	 */
+	bool findPendingCommand(ChannelCommand::Type type, SoundHandle handle, int &value);
+
+	/**
+	 * Apply all queued commands. Must be called with _mutex held.
+	 */
+	void applyPendingCommands();
+
+	/**
+	 * Look up the channel belonging to a handle. Must be called with
+	 * _mutex held.
+	 *
+	 * @return the channel, or 0 if the sound already terminated
+	 */
+	Channel *findChannel(SoundHandle handle) const;
+
+	/**
+	 * Remove the channel in the given slot from the channel tables,
+	 * without destroying it. Must be called with _mutex held.
+	 */
+	Channel *unlinkChannel(int index);
 
 public:
 
@@ -119,6 +189,13 @@ public:
 
 	virtual uint getOutputRate() const;
 
+	/**
+	 * Set the quality of the sample rate conversion used for sounds
+	 * started after this call. Defaults to kRateConverterQualityLow.
+	 */
+	void setRateConverterQuality(RateConverterQuality quality) { _converterQuality = quality; }
+	RateConverterQuality getRateConverterQuality() const { return _converterQuality; }
+
 protected:
 	void insertChannel(SoundHandle *handle, Channel *chan);
 
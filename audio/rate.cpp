@@ -32,9 +32,20 @@
 #include "audio/rate.h"
 #include "audio/mixer.h"
 #include "common/frac.h"
+#include "common/list.h"
+#include "common/math.h"
+#include "common/singleton.h"
+#include "common/system.h"
 #include "common/textconsole.h"
 #include "common/util.h"
 
+#include <math.h>
+
+#if defined(__SSE2__) && !defined(OUTPUT_UNSIGNED_AUDIO)
+#include <emmintrin.h>
+#define RATE_USE_SSE2
+#endif
+
 namespace Audio {
 
 
@@ -47,6 +58,69 @@ namespace Audio {
 #define INTERMEDIATE_BUFFER_SIZE 512
 
 
+/**
+ * Scale a run of frames by the channel volumes and mix them into the
+ * (stereo) output buffer, clipping the result. This is the innermost loop
+ * of all rate converters below.
+ *
+ * @param obuf    output buffer, receives 2 * frames samples
+ * @param ibuf    input frames; 1 sample per frame if mono, 2 if stereo
+ * @param frames  number of frames to mix
+ * @param vol_l   volume for the left input channel
+ * @param vol_r   volume for the right input channel
+ */
+template<bool stereo, bool reverseStereo>
+static void mixFrames(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t frames, st_volume_t vol_l, st_volume_t vol_r) {
+#ifdef RATE_USE_SSE2
+	// Handle four frames per iteration. The volume scaling has to round
+	// towards zero like the division in the scalar code, and the saturated
+	// add matches clampedAdd(). kMaxMixerVolume is 256, hence the shift.
+	const st_volume_t vol0 = reverseStereo ? vol_r : vol_l;
+	const st_volume_t vol1 = reverseStereo ? vol_l : vol_r;
+	const __m128i vol = _mm_set_epi16(vol1, vol0, vol1, vol0, vol1, vol0, vol1, vol0);
+
+	for (; frames >= 4; frames -= 4) {
+		__m128i in;
+		if (stereo) {
+			in = _mm_loadu_si128((const __m128i *)ibuf);
+			if (reverseStereo)
+				in = _mm_shufflehi_epi16(_mm_shufflelo_epi16(in, 0xB1), 0xB1);
+			ibuf += 8;
+		} else {
+			in = _mm_loadl_epi64((const __m128i *)ibuf);
+			in = _mm_unpacklo_epi16(in, in);
+			ibuf += 4;
+		}
+
+		const __m128i lo = _mm_mullo_epi16(in, vol);
+		const __m128i hi = _mm_mulhi_epi16(in, vol);
+		__m128i prod0 = _mm_unpacklo_epi16(lo, hi);
+		__m128i prod1 = _mm_unpackhi_epi16(lo, hi);
+		prod0 = _mm_add_epi32(prod0, _mm_srli_epi32(_mm_srai_epi32(prod0, 31), 24));
+		prod1 = _mm_add_epi32(prod1, _mm_srli_epi32(_mm_srai_epi32(prod1, 31), 24));
+		const __m128i out = _mm_packs_epi32(_mm_srai_epi32(prod0, 8), _mm_srai_epi32(prod1, 8));
+
+		_mm_storeu_si128((__m128i *)obuf, _mm_adds_epi16(_mm_loadu_si128((const __m128i *)obuf), out));
+		obuf += 8;
+	}
+#endif
+
+	for (; frames > 0; frames--) {
+		st_sample_t out0, out1;
+		out0 = *ibuf++;
+		out1 = (stereo ? *ibuf++ : out0);
+
+		// output left channel
+		clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+
+		// output right channel
+		clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+
+		obuf += 2;
+	}
+}
+
+
 /**
  * Audio rate converter based on simple resampling. Used when no
  * interpolation is required.
@@ -67,10 +141,17 @@ protected:
 	/** fractional position increment in the output stream */
 	long opos_inc;
 
+public:
+	/**
+	 * Resample up to maxFrames stereo frames into frameBuf.
+	 * @return the number of frames produced, less than maxFrames at the end of the input
+	 */
+	st_size_t resample(AudioStream &input, st_sample_t *frameBuf, st_size_t maxFrames);
+
 public:
 	SimpleRateConverter(st_rate_t inrate, st_rate_t outrate);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
-	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		return ST_SUCCESS;
 	}
 };
@@ -102,13 +183,10 @@ SimpleRateConverter<stereo, reverseStereo>::SimpleRateConverter(st_rate_t inrate
  * Return number of sample pairs processed.
  */
 template<bool stereo, bool reverseStereo>
-int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
-	st_sample_t *ostart, *oend;
-
-	ostart = obuf;
-	oend = obuf + osamp * 2;
+st_size_t SimpleRateConverter<stereo, reverseStereo>::resample(AudioStream &input, st_sample_t *frameBuf, st_size_t maxFrames) {
+	st_size_t frames = 0;
 
-	while (obuf < oend) {
+	while (frames < maxFrames) {
 
 		// read enough input samples so that opos >= 0
 		do {
@@ -117,7 +195,7 @@ int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 				inPtr = inBuf;
 				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
 				if (inLen <= 0)
-					return (obuf - ostart) / 2;
+					return frames;
 			}
 			inLen -= (stereo ? 2 : 1);
 			opos--;
@@ -130,18 +208,37 @@ int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 		out0 = *inPtr++;
 		out1 = (stereo ? *inPtr++ : out0);
 
+		*frameBuf++ = out0;
+		*frameBuf++ = out1;
+
 		// Increment output position
 		opos += opos_inc;
 
-		// output left channel
-		clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+		frames++;
+	}
+	return frames;
+}
 
-		// output right channel
-		clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+/*
+ * Processed signed long samples from ibuf to obuf.
+ * Return number of sample pairs processed.
+ */
+template<bool stereo, bool reverseStereo>
+int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_sample_t frameBuf[INTERMEDIATE_BUFFER_SIZE];
+	st_size_t done = 0;
 
-		obuf += 2;
+	while (done < osamp) {
+		const st_size_t chunk = MIN<st_size_t>(osamp - done, ARRAYSIZE(frameBuf) / 2);
+		const st_size_t frames = resample(input, frameBuf, chunk);
+
+		mixFrames<true, reverseStereo>(obuf + done * 2, frameBuf, frames, vol_l, vol_r);
+		done += frames;
+
+		if (frames < chunk)
+			break;
 	}
-	return (obuf - ostart) / 2;
+	return done;
 }
 
 /**
@@ -173,10 +270,16 @@ protected:
 	/** current sample(s) in the input stream (left/right channel) */
 	st_sample_t icur0, icur1;
 
+	/**
+	 * Interpolate up to maxFrames stereo frames into frameBuf.
+	 * @return the number of frames produced, less than maxFrames at the end of the input
+	 */
+	st_size_t interpolate(AudioStream &input, st_sample_t *frameBuf, st_size_t maxFrames);
+
 public:
 	LinearRateConverter(st_rate_t inrate, st_rate_t outrate);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
-	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		return ST_SUCCESS;
 	}
 };
@@ -211,13 +314,10 @@ LinearRateConverter<stereo, reverseStereo>::LinearRateConverter(st_rate_t inrate
  * Return number of sample pairs processed.
  */
 template<bool stereo, bool reverseStereo>
-int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
-	st_sample_t *ostart, *oend;
-
-	ostart = obuf;
-	oend = obuf + osamp * 2;
+st_size_t LinearRateConverter<stereo, reverseStereo>::interpolate(AudioStream &input, st_sample_t *frameBuf, st_size_t maxFrames) {
+	st_size_t frames = 0;
 
-	while (obuf < oend) {
+	while (frames < maxFrames) {
 
 		// read enough input samples so that opos < 0
 		while ((frac_t)FRAC_ONE <= opos) {
@@ -226,7 +326,7 @@ int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 				inPtr = inBuf;
 				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
 				if (inLen <= 0)
-					return (obuf - ostart) / 2;
+					return frames;
 			}
 			inLen -= (stereo ? 2 : 1);
 			ilast0 = icur0;
@@ -240,7 +340,7 @@ int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 
 		// Loop as long as the outpos trails behind, and as long as there is
 		// still space in the output buffer.
-		while (opos < (frac_t)FRAC_ONE && obuf < oend) {
+		while (opos < (frac_t)FRAC_ONE && frames < maxFrames) {
 			// interpolate
 			st_sample_t out0, out1;
 			out0 = (st_sample_t)(ilast0 + (((icur0 - ilast0) * opos + FRAC_HALF) >> FRAC_BITS));
@@ -248,19 +348,382 @@ int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 						  (st_sample_t)(ilast1 + (((icur1 - ilast1) * opos + FRAC_HALF) >> FRAC_BITS)) :
 						  out0);
 
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
-
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
-
-			obuf += 2;
+			*frameBuf++ = out0;
+			*frameBuf++ = out1;
+			frames++;
 
 			// Increment output position
 			opos += opos_inc;
 		}
 	}
-	return (obuf - ostart) / 2;
+	return frames;
+}
+
+/*
+ * Processed signed long samples from ibuf to obuf.
+ * Return number of sample pairs processed.
+ */
+template<bool stereo, bool reverseStereo>
+int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_sample_t frameBuf[INTERMEDIATE_BUFFER_SIZE];
+	st_size_t done = 0;
+
+	while (done < osamp) {
+		const st_size_t chunk = MIN<st_size_t>(osamp - done, ARRAYSIZE(frameBuf) / 2);
+		const st_size_t frames = interpolate(input, frameBuf, chunk);
+
+		mixFrames<true, reverseStereo>(obuf + done * 2, frameBuf, frames, vol_l, vol_r);
+		done += frames;
+
+		if (frames < chunk)
+			break;
+	}
+	return done;
+}
+
+
+#pragma mark -
+
+
+/**
+ * Polyphase windowed sinc filter table for one rate pair and quality.
+ *
+ * The fractional position of an output sample between two input samples
+ * is quantized to one of 'phases' steps. For every phase the table holds
+ * 'taps' coefficients in 2.14 fixed point, normalized so that each phase
+ * has unity gain.
+ */
+struct SincFilter {
+	st_rate_t inrate, outrate;
+	RateConverterQuality quality;
+	int taps;
+	int phases;
+	int16 *coeffs;
+	int refCount;
+
+	SincFilter(st_rate_t in, st_rate_t out, RateConverterQuality q);
+	~SincFilter() { delete[] coeffs; }
+
+	const int16 *getPhase(int phase) const { return coeffs + phase * taps; }
+};
+
+enum {
+	SINC_COEFF_BITS = 14,
+	/** Input frames buffered in addition to the filter history */
+	SINC_BUFFER_FRAMES = INTERMEDIATE_BUFFER_SIZE / 2,
+	/** Output rates from this on would overflow the phase computation */
+	SINC_MAX_OUTRATE = 1 << 23
+};
+
+SincFilter::SincFilter(st_rate_t in, st_rate_t out, RateConverterQuality q)
+	: inrate(in), outrate(out), quality(q), refCount(0) {
+	taps = (quality == kRateConverterQualityHigh) ? 32 : 16;
+	phases = (quality == kRateConverterQualityHigh) ? 256 : 128;
+	coeffs = new int16[taps * phases];
+
+	// Low pass just below the lower of both Nyquist frequencies, relative
+	// to the input Nyquist frequency.
+	double cutoff = 0.92;
+	if (outrate < inrate)
+		cutoff = cutoff * outrate / inrate;
+
+	const int center = taps / 2 - 1;
+	double *window = new double[taps];
+
+	for (int phase = 0; phase < phases; phase++) {
+		double sum = 0;
+		for (int k = 0; k < taps; k++) {
+			// Distance of this tap from the interpolated position
+			const double x = (k - center) - (double)phase / phases;
+
+			// Blackman window over the filter span
+			const double w = (x + taps / 2) / taps;
+			const double blackman = 0.42 - 0.5 * cos(2 * M_PI * w) + 0.08 * cos(4 * M_PI * w);
+
+			const double arg = M_PI * cutoff * x;
+			const double sinc = (fabs(arg) < 1e-9) ? 1.0 : sin(arg) / arg;
+
+			window[k] = cutoff * sinc * blackman;
+			sum += window[k];
+		}
+
+		int16 *c = coeffs + phase * taps;
+		for (int k = 0; k < taps; k++)
+			c[k] = (int16)floor(window[k] / sum * (1 << SINC_COEFF_BITS) + 0.5);
+	}
+
+	delete[] window;
+}
+
+/**
+ * Registry of the SincFilter tables currently in use, so that channels
+ * playing at the same rate share their tables.
+ */
+class SincFilterCache : public Common::Singleton<SincFilterCache> {
+public:
+	SincFilter *acquire(st_rate_t inrate, st_rate_t outrate, RateConverterQuality quality) {
+		lock();
+
+		for (Common::List<SincFilter *>::iterator i = _filters.begin(); i != _filters.end(); ++i) {
+			if ((*i)->inrate == inrate && (*i)->outrate == outrate && (*i)->quality == quality) {
+				(*i)->refCount++;
+				unlock();
+				return *i;
+			}
+		}
+
+		SincFilter *filter = new SincFilter(inrate, outrate, quality);
+		filter->refCount = 1;
+		_filters.push_back(filter);
+		unlock();
+		return filter;
+	}
+
+	void release(SincFilter *filter) {
+		lock();
+
+		if (--filter->refCount == 0) {
+			_filters.remove(filter);
+			delete filter;
+		}
+
+		unlock();
+	}
+
+private:
+	friend class Common::Singleton<SincFilterCache>;
+
+	// Without a backend (e.g. in the unit tests), there are no other
+	// threads to guard against
+	SincFilterCache() : _mutex(g_system ? g_system->createMutex() : 0) {}
+	~SincFilterCache() {
+		if (_mutex)
+			g_system->deleteMutex(_mutex);
+	}
+
+	void lock() {
+		if (_mutex)
+			g_system->lockMutex(_mutex);
+	}
+
+	void unlock() {
+		if (_mutex)
+			g_system->unlockMutex(_mutex);
+	}
+
+	OSystem::MutexRef _mutex;
+	Common::List<SincFilter *> _filters;
+};
+
+/**
+ * Audio rate converter based on bandlimited (windowed sinc) interpolation,
+ * using a polyphase filter table.
+ *
+ * Unlike the simple and linear converters there is no limit on the input
+ * rate, since the position is tracked as an exact fraction of the output
+ * rate. At the end of the input, the filter is fed with silence, so that
+ * the last input frames are output, too.
+ */
+template<bool stereo, bool reverseStereo>
+class SincRateConverter : public RateConverter {
+protected:
+	enum {
+		CHANNELS = stereo ? 2 : 1
+	};
+
+	SincFilter *_filter;
+	const st_rate_t _outrate;
+
+	/** Input frames, the first one being the oldest tap of the next output */
+	st_sample_t *_inBuf;
+	int _inBufSize;
+	int _inFrames;
+	int _inPos;
+
+	/** Position increment per output frame, as integer and fraction of outrate */
+	int _incInt;
+	st_rate_t _incFrac;
+	/** Fractional position of the next output frame, in units of 1/outrate */
+	st_rate_t _frac;
+
+	/** No more data will appear in the input */
+	bool _inputEnded;
+	/** Frames of silence still to be fed to the filter after the end of the input */
+	int _silenceLeft;
+	/** All frames up to the end of the input have been output */
+	bool _drained;
+
+	/**
+	 * Make sure the taps for the next output frame are buffered.
+	 * @param input the stream to read from, or 0 after the end of the input
+	 * @return false if there is no more input for now
+	 */
+	bool fillBuffer(AudioStream *input);
+
+	/**
+	 * Resample up to maxFrames stereo frames into frameBuf.
+	 * @return the number of frames produced, less than maxFrames at the end of the input
+	 */
+	st_size_t resample(AudioStream *input, st_sample_t *frameBuf, st_size_t maxFrames);
+
+	/**
+	 * Resample up to osamp frames and mix them into obuf.
+	 */
+	int mix(AudioStream *input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+
+	/**
+	 * Mark the end of the input, so that the filter tail gets output.
+	 */
+	void endInput() {
+		// Enough silence for the last input frame to reach the center of
+		// the filter
+		_inputEnded = true;
+		_silenceLeft = _filter->taps / 2;
+	}
+
+public:
+	SincRateConverter(st_rate_t inrate, st_rate_t outrate, RateConverterQuality quality);
+	~SincRateConverter();
+
+	/**
+	 * Whether the sinc converter supports the given rates.
+	 */
+	static bool canConvert(st_rate_t inrate, st_rate_t outrate) {
+		return outrate < SINC_MAX_OUTRATE && inrate / outrate < SINC_BUFFER_FRAMES;
+	}
+
+	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+		return mix(&input, obuf, osamp, vol_l, vol_r);
+	}
+
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+		if (!_inputEnded)
+			endInput();
+		return mix(0, obuf, osamp, vol_l, vol_r);
+	}
+
+	bool isDrained() const { return _drained; }
+};
+
+template<bool stereo, bool reverseStereo>
+SincRateConverter<stereo, reverseStereo>::SincRateConverter(st_rate_t inrate, st_rate_t outrate, RateConverterQuality quality)
+	: _outrate(outrate), _inputEnded(false), _silenceLeft(0), _drained(false) {
+	// makeRateConverter() only picks this converter for supported rates
+	assert(canConvert(inrate, outrate));
+
+	_filter = SincFilterCache::instance().acquire(inrate, outrate, quality);
+
+	_inBufSize = _filter->taps + SINC_BUFFER_FRAMES;
+	_inBuf = new st_sample_t[_inBufSize * CHANNELS];
+
+	// Start with silence in the history, so that the first output frame
+	// is centered on the first input frame.
+	_inFrames = _filter->taps / 2 - 1;
+	memset(_inBuf, 0, _inFrames * CHANNELS * sizeof(st_sample_t));
+	_inPos = 0;
+
+	_incInt = inrate / outrate;
+	_incFrac = inrate % outrate;
+	_frac = 0;
+}
+
+template<bool stereo, bool reverseStereo>
+SincRateConverter<stereo, reverseStereo>::~SincRateConverter() {
+	SincFilterCache::instance().release(_filter);
+	delete[] _inBuf;
+}
+
+template<bool stereo, bool reverseStereo>
+bool SincRateConverter<stereo, reverseStereo>::fillBuffer(AudioStream *input) {
+	while (_inFrames < _inPos + _filter->taps) {
+		if (_inputEnded && _silenceLeft == 0) {
+			// The last input frame has been output
+			_drained = true;
+			return false;
+		}
+
+		// Drop the frames we are done with. When downsampling by a large
+		// factor, the position may point past the buffered frames.
+		const int consumed = MIN(_inPos, _inFrames);
+		if (consumed > 0) {
+			memmove(_inBuf, _inBuf + consumed * CHANNELS, (_inFrames - consumed) * CHANNELS * sizeof(st_sample_t));
+			_inFrames -= consumed;
+			_inPos -= consumed;
+		}
+
+		const int room = _inBufSize - _inFrames;
+		if (_inputEnded) {
+			// Feed the filter with silence after the end of the input
+			const int len = MIN(_silenceLeft, room);
+			memset(_inBuf + _inFrames * CHANNELS, 0, len * CHANNELS * sizeof(st_sample_t));
+			_inFrames += len;
+			_silenceLeft -= len;
+		} else {
+			const int len = input->readBuffer(_inBuf + _inFrames * CHANNELS, room * CHANNELS);
+			if (len > 0)
+				_inFrames += len / CHANNELS;
+			else if (input->endOfStream())
+				endInput();
+			else
+				return false;
+		}
+	}
+	return true;
+}
+
+template<bool stereo, bool reverseStereo>
+st_size_t SincRateConverter<stereo, reverseStereo>::resample(AudioStream *input, st_sample_t *frameBuf, st_size_t maxFrames) {
+	const int taps = _filter->taps;
+	st_size_t frames = 0;
+
+	while (frames < maxFrames) {
+		if (!fillBuffer(input))
+			return frames;
+
+		const int16 *coeff = _filter->getPhase((_frac * _filter->phases) / _outrate);
+		const st_sample_t *in = _inBuf + _inPos * CHANNELS;
+
+		int acc0 = 0, acc1 = 0;
+		for (int k = 0; k < taps; k++) {
+			acc0 += coeff[k] * in[0];
+			if (stereo)
+				acc1 += coeff[k] * in[1];
+			in += CHANNELS;
+		}
+
+		const int out0 = CLIP<int>((acc0 + (1 << (SINC_COEFF_BITS - 1))) >> SINC_COEFF_BITS, ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+		const int out1 = stereo ? CLIP<int>((acc1 + (1 << (SINC_COEFF_BITS - 1))) >> SINC_COEFF_BITS, ST_SAMPLE_MIN, ST_SAMPLE_MAX) : out0;
+		*frameBuf++ = out0;
+		*frameBuf++ = out1;
+		frames++;
+
+		// Advance the input position
+		_inPos += _incInt;
+		_frac += _incFrac;
+		if (_frac >= _outrate) {
+			_frac -= _outrate;
+			_inPos++;
+		}
+	}
+	return frames;
+}
+
+template<bool stereo, bool reverseStereo>
+int SincRateConverter<stereo, reverseStereo>::mix(AudioStream *input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_sample_t frameBuf[INTERMEDIATE_BUFFER_SIZE];
+	st_size_t done = 0;
+
+	while (done < osamp) {
+		const st_size_t chunk = MIN<st_size_t>(osamp - done, ARRAYSIZE(frameBuf) / 2);
+		const st_size_t frames = resample(input, frameBuf, chunk);
+
+		mixFrames<true, reverseStereo>(obuf + done * 2, frameBuf, frames, vol_l, vol_r);
+		done += frames;
+
+		if (frames < chunk)
+			break;
+	}
+	return done;
 }
 
 
@@ -283,11 +746,8 @@ public:
 	virtual int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		assert(input.isStereo() == stereo);
 
-		st_sample_t *ptr;
 		st_size_t len;
 
-		st_sample_t *ostart = obuf;
-
 		if (stereo)
 			osamp *= 2;
 
@@ -305,24 +765,12 @@ public:
 		len = input.readBuffer(_buffer, osamp);
 
 		// Mix the data into the output buffer
-		ptr = _buffer;
-		for (; len > 0; len -= (stereo ? 2 : 1)) {
-			st_sample_t out0, out1;
-			out0 = *ptr++;
-			out1 = (stereo ? *ptr++ : out0);
-
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
-
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
-
-			obuf += 2;
-		}
-		return (obuf - ostart) / 2;
+		const st_size_t frames = len / (stereo ? 2 : 1);
+		mixFrames<stereo, reverseStereo>(obuf, _buffer, frames, vol_l, vol_r);
+		return frames;
 	}
 
-	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		return ST_SUCCESS;
 	}
 };
@@ -331,9 +779,11 @@ public:
 #pragma mark -
 
 template<bool stereo, bool reverseStereo>
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, RateConverterQuality quality) {
 	if (inrate != outrate) {
-		if ((inrate % outrate) == 0) {
+		if (quality != kRateConverterQualityLow && SincRateConverter<stereo, reverseStereo>::canConvert(inrate, outrate)) {
+			return new SincRateConverter<stereo, reverseStereo>(inrate, outrate, quality);
+		} else if ((inrate % outrate) == 0) {
 			return new SimpleRateConverter<stereo, reverseStereo>(inrate, outrate);
 		} else {
 			return new LinearRateConverter<stereo, reverseStereo>(inrate, outrate);
@@ -343,17 +793,18 @@ RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
 	}
 }
 
-/**
- * Create and return a RateConverter object for the specified input and output rates.
- */
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, RateConverterQuality quality) {
 	if (stereo) {
 		if (reverseStereo)
-			return makeRateConverter<true, true>(inrate, outrate);
+			return makeRateConverter<true, true>(inrate, outrate, quality);
 		else
-			return makeRateConverter<true, false>(inrate, outrate);
+			return makeRateConverter<true, false>(inrate, outrate, quality);
 	} else
-		return makeRateConverter<false, false>(inrate, outrate);
+		return makeRateConverter<false, false>(inrate, outrate, quality);
 }
 
 } // End of namespace Audio
+
+namespace Common {
+DECLARE_SINGLETON(Audio::SincFilterCache);
+}
@@ -75,10 +75,41 @@ public:
 	 */
 	virtual int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) = 0;
 
-	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) = 0;
+	/**
+	 * Mix the samples the converter still holds back after the end of the
+	 * input stream.
+	 *
+	 * @return Number of sample pairs written into the buffer.
+	 */
+	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) = 0;
+
+	/**
+	 * @return true if drain() has no more samples to output.
+	 */
+	virtual bool isDrained() const { return true; }
 };
 
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false);
+/**
+ * Quality tiers for sample rate conversion.
+ */
+enum RateConverterQuality {
+	/** Nearest neighbour or linear interpolation; cheapest, but aliases. */
+	kRateConverterQualityLow,
+	/** Windowed sinc interpolation with a short (16 tap) filter. */
+	kRateConverterQualityMedium,
+	/** Windowed sinc interpolation with a long (32 tap) filter. */
+	kRateConverterQualityHigh
+};
+
+/**
+ * Create and return a RateConverter object for the specified input and output rates.
+ *
+ * The medium and high quality converters share their precomputed filter
+ * tables with all other converters for the same rate pair and quality.
+ * If input and output rate are equal, no resampling is done regardless of
+ * the requested quality.
+ */
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false, RateConverterQuality quality = kRateConverterQualityLow);
 
 } // End of namespace Audio
 
@@ -134,6 +134,7 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 	_overlayVisible(false),
 	_overlayscreen(0), _tmpscreen2(0),
 	_scalerProc(0), _screenChangeCount(0),
+	_numScalerThreads(0), _scalerThreadsDone(0),
 	_mouseVisible(false), _mouseNeedsRedraw(false), _mouseData(0), _mouseSurface(0),
 	_mouseOrigSurface(0), _cursorTargetScale(1), _cursorPaletteDisabled(true),
 	_currentShakePos(0), _newShakePos(0),
@@ -193,6 +194,9 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 #else
 	_videoMode.fullscreen = true;
 #endif
+
+	if (ConfMan.hasKey("scaler_threads"))
+		startScalerThreads(ConfMan.getInt("scaler_threads"));
 }
 
 SurfaceSdlGraphicsManager::~SurfaceSdlGraphicsManager() {
@@ -200,6 +204,7 @@ SurfaceSdlGraphicsManager::~SurfaceSdlGraphicsManager() {
 	if (g_system->getEventManager()->getEventDispatcher() != NULL)
 		g_system->getEventManager()->getEventDispatcher()->unregisterObserver(this);
 
+	stopScalerThreads();
 	unloadGFXMode();
 	if (_mouseSurface)
 		SDL_FreeSurface(_mouseSurface);
@@ -1088,8 +1093,8 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 					dst_y = real2Aspect(dst_y);
 
 				assert(scalerProc != NULL);
-				scalerProc((byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
-					(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h);
+				scaleRect(scalerProc, (byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
+					(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h, scale1);
 			}
 
 			r->x = rx1;
@@ -1201,6 +1206,119 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 	_mouseNeedsRedraw = false;
 }
 
+void SurfaceSdlGraphicsManager::startScalerThreads(int count) {
+	stopScalerThreads();
+
+	count = CLIP<int>(count, 0, MAX_SCALER_THREADS);
+	if (count == 0)
+		return;
+
+	_scalerThreadsDone = SDL_CreateSemaphore(0);
+	if (!_scalerThreadsDone) {
+		warning("Could not create scaler threads: %s", SDL_GetError());
+		return;
+	}
+
+	for (int i = 0; i < count; i++) {
+		ScalerThread &t = _scalerThreads[i];
+
+		t.manager = this;
+		t.band.scalerProc = 0;
+		t.start = SDL_CreateSemaphore(0);
+		t.thread = t.start ? SDL_CreateThread(scalerThreadEntry, &t) : 0;
+
+		if (!t.thread) {
+			warning("Could not create scaler thread: %s", SDL_GetError());
+			if (t.start)
+				SDL_DestroySemaphore(t.start);
+			break;
+		}
+
+		_numScalerThreads++;
+	}
+}
+
+void SurfaceSdlGraphicsManager::stopScalerThreads() {
+	// Hand out empty bands to signal the threads to end, and wait for them
+	// to actually finish
+	for (int i = 0; i < _numScalerThreads; i++) {
+		_scalerThreads[i].band.scalerProc = 0;
+		SDL_SemPost(_scalerThreads[i].start);
+	}
+
+	for (int i = 0; i < _numScalerThreads; i++) {
+		SDL_WaitThread(_scalerThreads[i].thread, NULL);
+		SDL_DestroySemaphore(_scalerThreads[i].start);
+	}
+
+	if (_scalerThreadsDone)
+		SDL_DestroySemaphore(_scalerThreadsDone);
+
+	_scalerThreadsDone = 0;
+	_numScalerThreads = 0;
+}
+
+int SDLCALL SurfaceSdlGraphicsManager::scalerThreadEntry(void *arg) {
+	ScalerThread *t = (ScalerThread *)arg;
+	assert(t);
+
+	while (true) {
+		SDL_SemWait(t->start);
+
+		const ScalerBand &b = t->band;
+		if (!b.scalerProc)
+			break;
+
+		b.scalerProc(b.src, b.srcPitch, b.dst, b.dstPitch, b.width, b.height);
+
+		SDL_SemPost(t->manager->_scalerThreadsDone);
+	}
+
+	return 0;
+}
+
+void SurfaceSdlGraphicsManager::scaleRect(ScalerProc *scalerProc, const byte *src, uint32 srcPitch, byte *dst, uint32 dstPitch, int width, int height, int scale) {
+	// Every scaler only writes the destination rows of the source rows it
+	// is given, and only reads the source buffer, including the rows around
+	// the given ones. So any split into bands gives the same result, as
+	// long as the bands start on even rows, which DotMatrix relies on.
+	int bands = MIN(_numScalerThreads + 1, height / MIN_SCALER_BAND_HEIGHT);
+
+#if defined(USE_NASM) && defined(USE_HQ_SCALERS)
+	// The assembly versions of the HQ scalers keep their state in globals
+	if (scalerProc == HQ2x || scalerProc == HQ3x)
+		bands = 1;
+#endif
+
+	if (bands <= 1) {
+		scalerProc(src, srcPitch, dst, dstPitch, width, height);
+		return;
+	}
+
+	// Hand the bands but the first one to the scaler threads...
+	for (int i = 1; i < bands; i++) {
+		const int y1 = (height * i / bands) & ~1;
+		const int y2 = (i == bands - 1) ? height : ((height * (i + 1) / bands) & ~1);
+		ScalerBand &b = _scalerThreads[i - 1].band;
+
+		b.scalerProc = scalerProc;
+		b.src = src + y1 * srcPitch;
+		b.srcPitch = srcPitch;
+		b.dst = dst + y1 * scale * dstPitch;
+		b.dstPitch = dstPitch;
+		b.width = width;
+		b.height = y2 - y1;
+
+		SDL_SemPost(_scalerThreads[i - 1].start);
+	}
+
+	// ...scale the first one ourselves, and wait for the others
+	scalerProc(src, srcPitch, dst, dstPitch, width, (height / bands) & ~1);
+
+	for (int i = 1; i < bands; i++)
+		SDL_SemWait(_scalerThreadsDone);
+}
+
 bool SurfaceSdlGraphicsManager::saveScreenshot(const char *filename) {
 	assert(_hwscreen != NULL);
 
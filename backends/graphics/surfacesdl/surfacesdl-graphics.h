@@ -246,6 +246,33 @@ protected:
 	SDL_Rect _dirtyRectList[NUM_DIRTY_RECT];
 	int _numDirtyRects;
 
+	enum {
+		MAX_SCALER_THREADS = 8,
+		MIN_SCALER_BAND_HEIGHT = 16
+	};
+
+	/** A band of rows of a dirty rect, to be scaled by one of the scaler threads. */
+	struct ScalerBand {
+		ScalerProc *scalerProc; ///< The scaler to use, or 0 if the thread should quit.
+		const byte *src;
+		uint32 srcPitch;
+		byte *dst;
+		uint32 dstPitch;
+		int width, height;
+	};
+
+	struct ScalerThread {
+		SurfaceSdlGraphicsManager *manager;
+		SDL_Thread *thread;
+		SDL_sem *start; ///< Posted when the band is ready to be scaled.
+		ScalerBand band;
+	};
+
+	// Scaler threads, helping the main thread to scale large dirty rects
+	ScalerThread _scalerThreads[MAX_SCALER_THREADS];
+	int _numScalerThreads;
+	SDL_sem *_scalerThreadsDone; ///< Posted by each scaler thread when its band is done.
+
 	struct MousePos {
 		// The mouse position, using either virtual (game) or real
 		// (overlay) coordinates.
@@ -320,6 +347,24 @@ protected:
 
 	virtual void internUpdateScreen();
 
+	/**
+	 * Start the given number of scaler threads. With none, all scaling is
+	 * done by the main thread.
+	 */
+	void startScalerThreads(int count);
+	void stopScalerThreads();
+
+	/**
+	 * Scale a rect, splitting it into bands of rows which are scaled in
+	 * parallel when scaler threads are running.
+	 */
+	void scaleRect(ScalerProc *scalerProc, const byte *src, uint32 srcPitch, byte *dst, uint32 dstPitch, int width, int height, int scale);
+
+	/**
+	 * Entry point of the scaler threads
+	 */
+	static int SDLCALL scalerThreadEntry(void *arg);
+
 	virtual bool loadGFXMode();
 	virtual void unloadGFXMode();
 	virtual bool hotswapGFXMode();
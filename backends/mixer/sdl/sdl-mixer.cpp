@@ -97,6 +97,17 @@ void SdlMixerManager::init() {
 
 		startAudio();
 	}
+
+	// Determine the desired sample rate conversion quality
+	if (ConfMan.hasKey("resampler_quality")) {
+		const Common::String quality = ConfMan.get("resampler_quality");
+		if (quality == "high")
+			_mixer->setRateConverterQuality(Audio::kRateConverterQualityHigh);
+		else if (quality == "medium")
+			_mixer->setRateConverterQuality(Audio::kRateConverterQualityMedium);
+		else if (quality != "low")
+			warning("Unknown resampler quality '%s'", quality.c_str());
+	}
 }
 
 SDL_AudioSpec SdlMixerManager::getAudioSpec(uint32 outputRate) {
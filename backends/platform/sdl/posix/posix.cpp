@@ -93,6 +93,73 @@ Common::String OSystem_POSIX::getDefaultConfigFileName() {
 	return configFile;
 }
 
+Common::String OSystem_POSIX::getCachePath() {
+	Common::String cachePath;
+
+#ifdef MACOSX
+	const char *home = getenv("HOME");
+	if (home == NULL)
+		return Common::String();
+
+	cachePath = home;
+	cachePath += "/Library/Caches";
+#else
+	// Follow the XDG Base Directory Specification, and keep the cache out
+	// of ~/.scummvm, which is the default save path
+	const char *cacheHome = getenv("XDG_CACHE_HOME");
+	if (cacheHome != NULL && cacheHome[0] == '/') {
+		cachePath = cacheHome;
+	} else {
+		const char *home = getenv("HOME");
+		if (home == NULL)
+			return Common::String();
+
+		cachePath = home;
+		cachePath += "/.cache";
+	}
+#endif
+
+	struct stat sb;
+
+	// Check whether the dir exists
+	if (stat(cachePath.c_str(), &sb) == -1) {
+		// The dir does not exist, or stat failed for some other reason.
+		if (errno != ENOENT)
+			return Common::String();
+
+		// If the problem was that the path pointed to nothing, try
+		// to create the dir.
+		if (mkdir(cachePath.c_str(), 0755) != 0)
+			return Common::String();
+	} else if (!S_ISDIR(sb.st_mode)) {
+		// Path is no directory. Oops
+		return Common::String();
+	}
+
+#ifdef MACOSX
+	cachePath += "/ScummVM";
+#else
+	cachePath += "/scummvm";
+#endif
+
+	// Check whether the dir exists
+	if (stat(cachePath.c_str(), &sb) == -1) {
+		// The dir does not exist, or stat failed for some other reason.
+		if (errno != ENOENT)
+			return Common::String();
+
+		// If the problem was that the path pointed to nothing, try
+		// to create the dir.
+		if (mkdir(cachePath.c_str(), 0755) != 0)
+			return Common::String();
+	} else if (!S_ISDIR(sb.st_mode)) {
+		// Path is no directory. Oops
+		return Common::String();
+	}
+
+	return cachePath;
+}
+
 Common::WriteStream *OSystem_POSIX::createLogFile() {
 	// Start out by resetting _logFilePath, so that in case
 	// of a failure, we know that no log file is open.
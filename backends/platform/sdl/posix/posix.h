@@ -38,6 +38,8 @@ public:
 	virtual void init();
 	virtual void initBackend();
 
+	virtual Common::String getCachePath();
+
 protected:
 	/**
 	 * Base string for creating the default path and filename for the
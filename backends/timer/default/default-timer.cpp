@@ -23,6 +23,8 @@
 #include "backends/timer/default/default-timer.h"
 #include "common/util.h"
 #include "common/system.h"
+#include "common/config-manager.h"
+#include "common/debug.h"
 
 struct TimerSlot {
 	Common::TimerManager::TimerProc callback;
@@ -33,82 +35,231 @@ struct TimerSlot {
 	uint32 nextFireTime;	// in milliseconds
 	uint32 nextFireTimeMicro;	// microseconds part of nextFire
 
-	TimerSlot *next;
+	uint32 sequence;	// keeps timers with equal fire times in insertion order
+	uint index;			// position in the heap
+
+	DefaultTimerQueue::Stats stats;
 };
 
-void insertPrioQueue(TimerSlot *head, TimerSlot *newSlot) {
-	// The head points to a fake anchor TimerSlot; this common
-	// trick allows us to get rid of many special cases.
+DefaultTimerQueue::DefaultTimerQueue() :
+	_sequence(0),
+	_maxCatchUp(kCatchUpAll),
+	_current(0),
+	_currentRemoved(false) {
+}
 
-	const uint32 nextFireTime = newSlot->nextFireTime;
-	TimerSlot *slot = head;
-	newSlot->next = 0;
+DefaultTimerQueue::~DefaultTimerQueue() {
+	for (uint i = 0; i < _heap.size(); i++)
+		delete _heap[i];
+}
+
+uint32 DefaultTimerQueue::getMillis() const {
+	return g_system->getMillis();
+}
+
+bool DefaultTimerQueue::isBefore(const TimerSlot *a, const TimerSlot *b) const {
+	if (a->nextFireTime != b->nextFireTime)
+		return a->nextFireTime < b->nextFireTime;
+	return a->sequence < b->sequence;
+}
+
+void DefaultTimerQueue::siftUp(uint index) {
+	TimerSlot *slot = _heap[index];
+	while (index > 0) {
+		const uint parent = (index - 1) / 2;
+		if (!isBefore(slot, _heap[parent]))
+			break;
+		_heap[index] = _heap[parent];
+		_heap[index]->index = index;
+		index = parent;
+	}
+	_heap[index] = slot;
+	slot->index = index;
+}
 
-	// Insert the new slot into the sorted list of already scheduled
-	// timers in such a way that the list stays sorted...
+void DefaultTimerQueue::siftDown(uint index) {
+	TimerSlot *slot = _heap[index];
+	const uint size = _heap.size();
 	while (true) {
-		assert(slot);
-		if (slot->next == 0 || nextFireTime < slot->next->nextFireTime) {
-			newSlot->next = slot->next;
-			slot->next = newSlot;
-			return;
-		}
-		slot = slot->next;
+		uint child = index * 2 + 1;
+		if (child >= size)
+			break;
+		if (child + 1 < size && isBefore(_heap[child + 1], _heap[child]))
+			child++;
+		if (!isBefore(_heap[child], slot))
+			break;
+		_heap[index] = _heap[child];
+		_heap[index]->index = index;
+		index = child;
 	}
+	_heap[index] = slot;
+	slot->index = index;
 }
 
+void DefaultTimerQueue::push(TimerSlot *slot) {
+	slot->sequence = _sequence++;
+	_heap.push_back(slot);
+	siftUp(_heap.size() - 1);
+}
 
-DefaultTimerManager::DefaultTimerManager() :
-	_timerHandler(0),
-	_head(0) {
+void DefaultTimerQueue::removeAt(uint index) {
+	TimerSlot *last = _heap.back();
+	_heap.pop_back();
+	if (index == _heap.size())
+		return;
 
-	_head = new TimerSlot();
-	memset(_head, 0, sizeof(TimerSlot));
+	_heap[index] = last;
+	last->index = index;
+	if (index > 0 && isBefore(last, _heap[(index - 1) / 2]))
+		siftUp(index);
+	else
+		siftDown(index);
 }
 
-DefaultTimerManager::~DefaultTimerManager() {
-	Common::StackLock lock(_mutex);
+void DefaultTimerQueue::reschedule(TimerSlot *slot, uint32 curTime) {
+	// Advance from the scheduled time, not from the current one, so that
+	// late fires do not shift the following ones
+	slot->nextFireTime += slot->interval / 1000;
+	slot->nextFireTimeMicro += slot->interval % 1000;
+	if (slot->nextFireTimeMicro >= 1000) {
+		slot->nextFireTime += slot->nextFireTimeMicro / 1000;
+		slot->nextFireTimeMicro %= 1000;
+	}
+
+	if (_maxCatchUp == kCatchUpAll || slot->nextFireTime >= curTime)
+		return;
+
+	// Count the periods which are still due. Anything more than a few
+	// seconds behind is not worth making up for.
+	const uint32 behind = curTime - slot->nextFireTime;
+	uint32 missed = 0xFFFFFFFF;
+	if (behind < 4000)
+		missed = (behind * 1000 - slot->nextFireTimeMicro) / slot->interval + 1;
 
-	TimerSlot *slot = _head;
-	while (slot) {
-		TimerSlot *next = slot->next;
-		delete slot;
-		slot = next;
+	if (missed > _maxCatchUp) {
+		slot->nextFireTime = curTime + slot->interval / 1000;
+		slot->nextFireTimeMicro = slot->interval % 1000;
+		slot->stats.resyncs++;
 	}
-	_head = 0;
 }
 
-void DefaultTimerManager::handler() {
-	Common::StackLock lock(_mutex);
+void DefaultTimerQueue::install(TimerProc callback, uint32 interval, void *refCon, const Common::String &id) {
+	assert(interval > 0);
 
-	const uint32 curTime = g_system->getMillis();
+	TimerSlot *slot = new TimerSlot;
+	slot->callback = callback;
+	slot->refCon = refCon;
+	slot->id = id;
+	slot->interval = interval;
+	slot->nextFireTime = getMillis() + interval / 1000;
+	slot->nextFireTimeMicro = interval % 1000;
+	memset(&slot->stats, 0, sizeof(slot->stats));
+
+	push(slot);
+}
+
+void DefaultTimerQueue::remove(TimerProc callback) {
+	// There are only ever a few timers, so a linear search is good enough
+	// to find them. Removing one can move a slot which has not been looked
+	// at yet in front of the current index, so start over after each match.
+	bool found;
+	do {
+		found = false;
+		for (uint i = 0; i < _heap.size(); i++) {
+			TimerSlot *slot = _heap[i];
+			if (slot->callback != callback)
+				continue;
+
+			removeAt(i);
+
+			// A callback removing its own timer is still running
+			if (slot == _current)
+				_currentRemoved = true;
+			else
+				delete slot;
+
+			found = true;
+			break;
+		}
+	} while (found);
+}
+
+void DefaultTimerQueue::fire() {
+	const uint32 curTime = getMillis();
 
 	// Repeat as long as there is a TimerSlot that is scheduled to fire.
-	TimerSlot *slot = _head->next;
-	while (slot && slot->nextFireTime < curTime) {
-		// Remove the slot from the priority queue
-		_head->next = slot->next;
+	while (!_heap.empty() && _heap[0]->nextFireTime < curTime) {
+		TimerSlot *slot = _heap[0];
+
+		Stats &stats = slot->stats;
+		const uint32 lateness = curTime - 1 - slot->nextFireTime;
+		uint bucket = 0;
+		while (bucket < kLateBuckets - 1 && (lateness >> bucket) != 0)
+			bucket++;
+		stats.fires++;
+		stats.lateFires[bucket]++;
+		stats.maxLateness = MAX(stats.maxLateness, lateness);
 
-		// Update the fire time and reinsert the TimerSlot into the priority
-		// queue.
+		// Update the fire time and move the TimerSlot to its new place in
+		// the priority queue.
 		assert(slot->interval > 0);
-		slot->nextFireTime += (slot->interval / 1000);
-		slot->nextFireTimeMicro += (slot->interval % 1000);
-		if (slot->nextFireTimeMicro > 1000) {
-			slot->nextFireTime += slot->nextFireTimeMicro / 1000;
-			slot->nextFireTimeMicro %= 1000;
-		}
-		insertPrioQueue(_head, slot);
+		reschedule(slot, curTime);
+		slot->sequence = _sequence++;
+		siftDown(0);
 
 		// Invoke the timer callback
 		assert(slot->callback);
+		_current = slot;
+		_currentRemoved = false;
+		const uint32 start = getMillis();
 		slot->callback(slot->refCon);
+		_current = 0;
+
+		if (_currentRemoved) {
+			delete slot;
+		} else {
+			const uint32 duration = getMillis() - start;
+			stats.totalDuration += duration;
+			stats.maxDuration = MAX(stats.maxDuration, duration);
+		}
+	}
+}
+
+bool DefaultTimerQueue::getStats(const Common::String &id, Stats &stats) const {
+	for (uint i = 0; i < _heap.size(); i++) {
+		if (_heap[i]->id.equalsIgnoreCase(id)) {
+			stats = _heap[i]->stats;
+			return true;
+		}
+	}
+	return false;
+}
+
+void DefaultTimerQueue::resetStats() {
+	for (uint i = 0; i < _heap.size(); i++)
+		memset(&_heap[i]->stats, 0, sizeof(Stats));
+}
+
+
+DefaultTimerManager::DefaultTimerManager() :
+	_timerHandler(0) {
 
-		// Look at the next scheduled timer
-		slot = _head->next;
+	if (ConfMan.hasKey("timer_max_catchup")) {
+		const int periods = ConfMan.getInt("timer_max_catchup");
+		if (periods >= 0)
+			_queue.setMaxCatchUp(periods);
 	}
 }
 
+DefaultTimerManager::~DefaultTimerManager() {
+}
+
+void DefaultTimerManager::handler() {
+	Common::StackLock lock(_mutex);
+
+	_queue.fire();
+}
+
 bool DefaultTimerManager::installTimerProc(TimerProc callback, int32 interval, void *refCon, const Common::String &id) {
 	assert(interval > 0);
 	Common::StackLock lock(_mutex);
@@ -127,16 +278,7 @@ bool DefaultTimerManager::installTimerProc(TimerProc callback, int32 interval, v
 	}
 	_callbacks[id] = callback;
 
-	TimerSlot *slot = new TimerSlot;
-	slot->callback = callback;
-	slot->refCon = refCon;
-	slot->id = id;
-	slot->interval = interval;
-	slot->nextFireTime = g_system->getMillis() + interval / 1000;
-	slot->nextFireTimeMicro = interval % 1000;
-	slot->next = 0;
-
-	insertPrioQueue(_head, slot);
+	_queue.install(callback, interval, refCon, id);
 
 	return true;
 }
@@ -144,18 +286,23 @@ bool DefaultTimerManager::installTimerProc(TimerProc callback, int32 interval, v
 void DefaultTimerManager::removeTimerProc(TimerProc callback) {
 	Common::StackLock lock(_mutex);
 
-	TimerSlot *slot = _head;
+	// Report how well the timer kept to its schedule
+	if (gDebugLevel >= 2) {
+		for (TimerSlotMap::const_iterator i = _callbacks.begin(); i != _callbacks.end(); ++i) {
+			DefaultTimerQueue::Stats stats;
+			if (i->_value != callback || !_queue.getStats(i->_key, stats))
+				continue;
 
-	while (slot->next) {
-		if (slot->next->callback == callback) {
-			TimerSlot *next = slot->next->next;
-			delete slot->next;
-			slot->next = next;
-		} else {
-			slot = slot->next;
+			debug(2, "Timer '%s': %u fires, late by 0/1/2-3/4-7/8-15/16+ ms: %u/%u/%u/%u/%u/%u, max %u ms late, "
+				"callbacks took %u ms (max %u ms), %u resyncs", i->_key.c_str(), stats.fires,
+				stats.lateFires[0], stats.lateFires[1], stats.lateFires[2], stats.lateFires[3],
+				stats.lateFires[4], stats.lateFires[5], stats.maxLateness, stats.totalDuration,
+				stats.maxDuration, stats.resyncs);
 		}
 	}
 
+	_queue.remove(callback);
+
 	// We need to remove all names referencing the timer proc here.
 	// 
 	// Else we run into troubles, when the client code removes and readds timer
@@ -22,6 +22,7 @@
 #ifndef BACKENDS_TIMER_DEFAULT_H
 #define BACKENDS_TIMER_DEFAULT_H
 
+#include "common/array.h"
 #include "common/str.h"
 #include "common/hash-str.h"
 #include "common/timer.h"
@@ -29,13 +30,94 @@
 
 struct TimerSlot;
 
+/**
+ * The timers of a DefaultTimerManager, kept in a binary heap ordered by
+ * their next fire time. The queue does no locking of its own, and reads
+ * the current time through getMillis(), which a test can override to run
+ * it on a fake clock.
+ */
+class DefaultTimerQueue {
+public:
+	typedef Common::TimerManager::TimerProc TimerProc;
+
+	enum {
+		/** Make up for all missed periods of a timer that fell behind. */
+		kCatchUpAll = 0xFFFFFFFF,
+
+		/**
+		 * Number of buckets in the late fire histogram. Bucket 0 counts the
+		 * fires in the scheduled millisecond, bucket i > 0 the fires which
+		 * were 2^(i-1) to 2^i - 1 ms late, the last bucket all later ones.
+		 */
+		kLateBuckets = 6
+	};
+
+	struct Stats {
+		uint32 fires;
+		uint32 lateFires[kLateBuckets];
+		uint32 maxLateness;		///< in milliseconds
+		uint32 totalDuration;	///< time spent in the callback, in milliseconds
+		uint32 maxDuration;		///< in milliseconds
+		uint32 resyncs;			///< number of times missed periods were dropped
+	};
+
+	DefaultTimerQueue();
+	virtual ~DefaultTimerQueue();
+
+	void install(TimerProc callback, uint32 interval, void *refCon, const Common::String &id);
+	void remove(TimerProc callback);
+
+	/**
+	 * Invoke the callbacks of all timers which are due, in the order of
+	 * their fire times.
+	 */
+	void fire();
+
+	/**
+	 * Set how many missed periods a timer may make up for. A timer that
+	 * falls further behind, e.g. because the handler was not called for a
+	 * while, fires once and is then rescheduled relative to the current
+	 * time. Otherwise timers keep to their original schedule, so periodic
+	 * callbacks do not drift.
+	 */
+	void setMaxCatchUp(uint32 periods) { _maxCatchUp = periods; }
+
+	/**
+	 * Retrieve the statistics of the timer with the given id.
+	 * @return false if there is no such timer
+	 */
+	bool getStats(const Common::String &id, Stats &stats) const;
+	void resetStats();
+
+	uint size() const { return _heap.size(); }
+
+protected:
+	virtual uint32 getMillis() const;
+
+private:
+	Common::Array<TimerSlot *> _heap;
+	uint32 _sequence;
+	uint32 _maxCatchUp;
+
+	// The slot whose callback is running, and whether it was removed by it
+	TimerSlot *_current;
+	bool _currentRemoved;
+
+	bool isBefore(const TimerSlot *a, const TimerSlot *b) const;
+	void push(TimerSlot *slot);
+	void removeAt(uint index);
+	void siftUp(uint index);
+	void siftDown(uint index);
+	void reschedule(TimerSlot *slot, uint32 curTime);
+};
+
 class DefaultTimerManager : public Common::TimerManager {
 private:
 	typedef Common::HashMap<Common::String, TimerProc, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> TimerSlotMap;
 
 	Common::Mutex _mutex;
 	void *_timerHandler;
-	TimerSlot *_head;
+	DefaultTimerQueue _queue;
 	TimerSlotMap _callbacks;
 
 public:
@@ -542,6 +542,7 @@ void PluginManager::addToPluginsInMemList(Plugin *plugin) {
 
 // Engine plugins
 
+#include "engines/advancedDetector.h"
 #include "engines/metaengine.h"
 
 namespace Common {
@@ -616,6 +617,10 @@ GameList EngineManager::detectGames(const Common::FSList &fslist) const {
 	GameList candidates;
 	EnginePlugin::List plugins;
 	EnginePlugin::List::const_iterator iter;
+
+	// Let the engines share the hashes of the files they check
+	ADHashCacheScope hashCache;
+
 	PluginManager::instance().loadFirstPlugin();
 	do {
 		plugins = getPlugins();
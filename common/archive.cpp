@@ -98,6 +98,7 @@ void SearchSet::add(const String &name, Archive *archive, int priority, bool aut
 	if (find(name) == _list.end()) {
 		Node node(priority, name, archive, autoFree);
 		insert(node);
+		_nameIndex.clear();
 	} else {
 		if (autoFree)
 			delete archive;
@@ -174,6 +175,7 @@ void SearchSet::remove(const String &name) {
 		if (it->_autoFree)
 			delete it->_arc;
 		_list.erase(it);
+		_nameIndex.clear();
 	}
 }
 
@@ -188,6 +190,7 @@ void SearchSet::clear() {
 	}
 
 	_list.clear();
+	_nameIndex.clear();
 }
 
 void SearchSet::setPriority(const String &name, int priority) {
@@ -204,19 +207,43 @@ void SearchSet::setPriority(const String &name, int priority) {
 	_list.erase(it);
 	node._priority = priority;
 	insert(node);
+	_nameIndex.clear();
 }
 
-bool SearchSet::hasFile(const String &name) const {
-	if (name.empty())
-		return false;
+void SearchSet::setUseNameIndex(bool useNameIndex) {
+	_useNameIndex = useNameIndex;
+	_nameIndex.clear();
+}
+
+Archive *SearchSet::findArchiveForFile(const String &name) const {
+	if (_useNameIndex) {
+		// Make sure the file is still there, it might have been removed
+		// from a directory since it was found
+		NameIndex::iterator i = _nameIndex.find(name);
+		if (i != _nameIndex.end()) {
+			if (i->_value->hasFile(name))
+				return i->_value;
+			_nameIndex.erase(i);
+		}
+	}
 
 	ArchiveNodeList::const_iterator it = _list.begin();
 	for ( ; it != _list.end(); ++it) {
-		if (it->_arc->hasFile(name))
-			return true;
+		if (it->_arc->hasFile(name)) {
+			if (_useNameIndex)
+				_nameIndex[name] = it->_arc;
+			return it->_arc;
+		}
 	}
 
-	return false;
+	return 0;
+}
+
+bool SearchSet::hasFile(const String &name) const {
+	if (name.empty())
+		return false;
+
+	return findArchiveForFile(name) != 0;
 }
 
 int SearchSet::listMatchingMembers(ArchiveMemberList &list, const String &pattern) const {
@@ -243,11 +270,9 @@ const ArchiveMemberPtr SearchSet::getMember(const String &name) const {
 	if (name.empty())
 		return ArchiveMemberPtr();
 
-	ArchiveNodeList::const_iterator it = _list.begin();
-	for ( ; it != _list.end(); ++it) {
-		if (it->_arc->hasFile(name))
-			return it->_arc->getMember(name);
-	}
+	Archive *arc = findArchiveForFile(name);
+	if (arc)
+		return arc->getMember(name);
 
 	return ArchiveMemberPtr();
 }
@@ -256,11 +281,24 @@ SeekableReadStream *SearchSet::createReadStreamForMember(const String &name) con
 	if (name.empty())
 		return 0;
 
+	if (_useNameIndex) {
+		NameIndex::const_iterator i = _nameIndex.find(name);
+		if (i != _nameIndex.end()) {
+			SeekableReadStream *stream = i->_value->createReadStreamForMember(name);
+			if (stream)
+				return stream;
+			_nameIndex.erase(name);
+		}
+	}
+
 	ArchiveNodeList::const_iterator it = _list.begin();
 	for ( ; it != _list.end(); ++it) {
 		SeekableReadStream *stream = it->_arc->createReadStreamForMember(name);
-		if (stream)
+		if (stream) {
+			if (_useNameIndex)
+				_nameIndex[name] = it->_arc;
 			return stream;
+		}
 	}
 
 	return 0;
@@ -269,6 +307,7 @@ SeekableReadStream *SearchSet::createReadStreamForMember(const String &name) con
 
 SearchManager::SearchManager() {
 	clear();	// Force a reset
+	setUseNameIndex(true);
 }
 
 void SearchManager::clear() {
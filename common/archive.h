@@ -24,6 +24,8 @@
 #define COMMON_ARCHIVE_H
 
 #include "common/str.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
 #include "common/list.h"
 #include "common/ptr.h"
 #include "common/singleton.h"
@@ -140,15 +142,38 @@ class SearchSet : public Archive {
 	typedef List<Node> ArchiveNodeList;
 	ArchiveNodeList _list;
 
+	// Maps the names of files found before to the archive they were found in.
+	typedef HashMap<String, Archive *> NameIndex;
+	bool _useNameIndex;
+	mutable NameIndex _nameIndex;
+
 	ArchiveNodeList::iterator find(const String &name);
 	ArchiveNodeList::const_iterator find(const String &name) const;
 
 	// Add an archive keeping the list sorted by descending priority.
 	void insert(const Node& node);
 
+	// Find the archive with the highest priority containing the file.
+	Archive *findArchiveForFile(const String &name) const;
+
 public:
+	SearchSet() : _useNameIndex(false) {}
 	virtual ~SearchSet() { clear(); }
 
+	/**
+	 * Enable or disable the name index. When enabled, the archive a file was
+	 * found in is remembered, so that further look ups of the same name take
+	 * a single hash look up instead of asking every archive in turn. The
+	 * index is reset whenever archives are added, removed or reprioritized.
+	 *
+	 * Hits are checked against the archive they point to, so a file that
+	 * has been removed from it is looked up again. A file that appears in
+	 * an archive with a higher priority is not noticed, though. Note that
+	 * with the index, look ups modify the search set, so they must not be
+	 * done from several threads at once.
+	 */
+	void setUseNameIndex(bool useNameIndex);
+
 	/**
 	 * Add a new archive to the searchable set.
 	 */
@@ -28,6 +28,7 @@
 #include "common/scummsys.h"
 #include "common/textconsole.h"
 #include "common/stream.h"
+#include "common/util.h"
 
 namespace Common {
 
@@ -67,6 +68,16 @@ public:
 	/** Add a bit to the value x, making it an n+1-bit value. */
 	virtual void addBit(uint32 &x, uint32 n) = 0;
 
+	/**
+	 * Are the bits handed out from the MSB to the LSB of the data values?
+	 *
+	 * If true, getBits() and peekBits() return the first bit read in the
+	 * most significant bit of the value, otherwise in the least significant
+	 * one. Decoders can use this to look up several bits at once, see
+	 * Huffman::getSymbol().
+	 */
+	virtual bool isMSBFirst() const = 0;
+
 protected:
 	BitStream() {
 	}
@@ -115,7 +126,8 @@ private:
 
 	/** Read the next data value. */
 	inline void readValue() {
-		if ((size() - pos()) < valueBits)
+		// We're at the start of a value, so the position in bits is simply the stream position
+		if ((size() - _stream->pos() * 8) < valueBits)
 			error("BitStreamImpl::readValue(): End of bit stream reached");
 
 		_value = readData();
@@ -191,17 +203,33 @@ public:
 		if (n > 32)
 			error("BitStreamImpl::getBits(): Too many bits requested to be read");
 
-		// Read the number of bits
+		// Read the number of bits, taking as many as possible from each value
 		uint32 v = 0;
+		uint8 got = 0;
 
-		if (isMSB2LSB) {
-			while (n-- > 0)
-				v = (v << 1) | getBit();
-		} else {
-			for (uint32 i = 0; i < n; i++)
-				v = (v >> 1) | (((uint32) getBit()) << 31);
+		while (n > 0) {
+			// Check if we need the next value
+			if (_inValue == 0)
+				readValue();
+
+			const uint8 take = MIN<uint8>(n, valueBits - _inValue);
+
+			if (isMSB2LSB) {
+				const uint32 b = _value >> (32 - take);
+
+				v = (take == 32) ? b : ((v << take) | b);
+				_value = (take == 32) ? 0 : (_value << take);
+			} else {
+				const uint32 b = (take == 32) ? _value : (_value & ((1U << take) - 1));
+
+				v |= b << got;
+				_value = (take == 32) ? 0 : (_value >> take);
+				got += take;
+			}
 
-			v >>= (32 - n);
+			// Increase the position within the current value
+			_inValue = (_inValue + take) % valueBits;
+			n -= take;
 		}
 
 		return v;
@@ -228,17 +256,51 @@ public:
 	 * The bit order is the same as in getBits().
 	 */
 	uint32 peekBits(uint8 n) {
-		uint32 value   = _value;
-		uint8  inValue = _inValue;
-		uint32 curPos  = _stream->pos();
+		if (n == 0)
+			return 0;
 
-		uint32 v = getBits(n);
+		if (n > 32)
+			error("BitStreamImpl::peekBits(): Too many bits requested to be read");
+
+		// If the bits are all in the current value, we don't need to touch the stream
+		if ((_inValue != 0) && (n <= valueBits - _inValue)) {
+			if (isMSB2LSB)
+				return _value >> (32 - n);
+			else
+				return _value & ((1U << n) - 1);
+		}
 
-		_stream->seek(curPos);
-		_inValue = inValue;
-		_value   = value;
+		// Otherwise, add the bits of the following values, reading them directly
+		// from the stream and going back afterwards
+		const uint32 curPos = _stream->pos();
+		const uint32 end    = _stream->size();
 
-		return v;
+		uint32 v     = (_inValue == 0) ? 0 : _value;
+		uint8  vBits = (_inValue == 0) ? 0 : (valueBits - _inValue);
+
+		uint32 p = curPos;
+		while ((vBits < n) && ((p + (valueBits >> 3)) <= end)) {
+			const uint32 next = readData();
+
+			if (isMSB2LSB)
+				v |= (next << (32 - valueBits)) >> vBits;
+			else
+				v |= next << vBits;
+
+			vBits += valueBits;
+			p += valueBits >> 3;
+		}
+
+		if (p != curPos)
+			_stream->seek(curPos);
+
+		if (vBits < n)
+			error("BitStreamImpl::peekBits(): End of bit stream reached");
+
+		if (isMSB2LSB)
+			return v >> (32 - n);
+
+		return (n == 32) ? v : (v & ((1U << n) - 1));
 	}
 
 	/**
@@ -272,8 +334,12 @@ public:
 
 	/** Skip the specified amount of bits. */
 	void skip(uint32 n) {
-		while (n-- > 0)
-			getBit();
+		while (n > 0) {
+			const uint8 take = MIN<uint32>(n, 32);
+
+			getBits(take);
+			n -= take;
+		}
 	}
 
 	/** Return the stream position in bits. */
@@ -293,6 +359,10 @@ public:
 	bool eos() const {
 		return _stream->eos() || (pos() >= size());
 	}
+
+	bool isMSBFirst() const {
+		return isMSB2LSB;
+	}
 };
 
 // typedefs for various memory layouts.
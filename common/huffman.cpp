@@ -58,6 +58,11 @@ Huffman::Huffman(uint8 maxLength, uint32 codeCount, const uint32 *codes, const u
 		// And put the pointer to the symbol/code struct into the symbol list.
 		_symbols[i] = &_codes[lengths[i] - 1].back();
 	}
+
+	_lookupBits = MIN<uint8>(maxLength, kLookupBits);
+
+	buildTable(_tableMSB, true);
+	buildTable(_tableLSB, false);
 }
 
 Huffman::~Huffman() {
@@ -68,7 +73,111 @@ void Huffman::setSymbols(const uint32 *symbols) {
 		_symbols[i]->symbol = symbols ? *symbols++ : i;
 }
 
+void Huffman::buildTable(Table &table, bool msbFirst) {
+	table.resize(1 << _lookupBits);
+
+	// Add the codes in the order getSymbolSlow() would find them, so that
+	// the first code matching some bits ends up in the table
+	for (uint32 i = 0; i < _codes.size(); i++)
+		for (CodeList::const_iterator cCode = _codes[i].begin(); cCode != _codes[i].end(); ++cCode)
+			addToTable(table, msbFirst, *cCode, i + 1);
+}
+
+void Huffman::addToTable(Table &table, bool msbFirst, const Symbol &symbol, uint8 length) {
+	// Codes with bits set beyond their length can never be read
+	if ((length < 32) && (symbol.code >> length))
+		return;
+
+	uint32 offset = 0;
+	uint8 tableBits = _lookupBits;
+	uint8 consumed = 0;
+
+	while (true) {
+		const uint8 remaining = length - consumed;
+		const uint8 n = MIN(remaining, tableBits);
+
+		// Gather the bits of the code that index this table, in the
+		// order the bitstream hands them out
+		uint32 index = 0;
+		for (uint8 i = 0; i < n; i++) {
+			const uint8 k = consumed + i;
+			const uint32 bit = msbFirst ? ((symbol.code >> (length - 1 - k)) & 1) : ((symbol.code >> k) & 1);
+
+			index |= msbFirst ? (bit << (tableBits - 1 - i)) : (bit << i);
+		}
+
+		if (remaining <= tableBits) {
+			// The code ends in this table. Fill all entries starting with it,
+			// unless an earlier code already took them.
+			const uint32 count = 1 << (tableBits - remaining);
+			for (uint32 i = 0; i < count; i++) {
+				TableEntry &entry = table[offset + index + (msbFirst ? i : (i << remaining))];
+
+				if (!entry.length && !entry.subTableBits) {
+					entry.symbol = &symbol;
+					entry.length = length;
+				}
+			}
+
+			return;
+		}
+
+		const uint32 pos = offset + index;
+
+		// A shorter code is a prefix of this one, so it will never be read
+		if (table[pos].length)
+			return;
+
+		if (!table[pos].subTableBits) {
+			const uint8 subTableBits = MIN<uint8>(_codes.size() - consumed - tableBits, kLookupBits);
+
+			table[pos].subTable = table.size();
+			table[pos].subTableBits = subTableBits;
+			table.resize(table.size() + (1 << subTableBits));
+		}
+
+		offset = table[pos].subTable;
+		consumed += tableBits;
+		tableBits = table[pos].subTableBits;
+	}
+}
+
 uint32 Huffman::getSymbol(BitStream &bits) const {
+	const bool msbFirst = bits.isMSBFirst();
+	const Table &table = msbFirst ? _tableMSB : _tableLSB;
+
+	// Bits can only be peeked while the stream has them, so close to its
+	// end, codes are read bit by bit instead
+	const uint32 bitsLeft = bits.size() - bits.pos();
+
+	uint32 offset = 0;
+	uint8 tableBits = _lookupBits;
+	uint8 consumed = 0;
+
+	while (consumed + tableBits <= bitsLeft) {
+		const uint32 value = bits.peekBits(consumed + tableBits);
+		const uint32 index = msbFirst ? (value & ((1 << tableBits) - 1)) : (value >> consumed);
+		const TableEntry &entry = table[offset + index];
+
+		if (entry.length) {
+			bits.skip(entry.length);
+			return entry.symbol->symbol;
+		}
+
+		if (!entry.subTableBits)
+			break;
+
+		offset = entry.subTable;
+		consumed += tableBits;
+		tableBits = entry.subTableBits;
+	}
+
+	// No code matches, or the stream ends within the lookup width. Read the
+	// bits one by one, which also fails the same way as ever on bad data.
+	return getSymbolSlow(bits);
+}
+
+uint32 Huffman::getSymbolSlow(BitStream &bits) const {
 	uint32 code = 0;
 
 	for (uint32 i = 0; i < _codes.size(); i++) {
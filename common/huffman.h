@@ -70,11 +70,42 @@ private:
 	typedef Array<CodeList> CodeLists;
 	typedef Array<Symbol *> SymbolList;
 
+	/**
+	 * Entry of a lookup table. The tables are indexed with the next bits of
+	 * the bitstream; an entry either holds the symbol of the code these bits
+	 * start with, or points to a table for the following bits.
+	 */
+	struct TableEntry {
+		const Symbol *symbol; ///< The symbol, or 0 if this isn't a leaf.
+		uint32 subTable;      ///< Offset of the next table, if this isn't a leaf.
+		uint8 length;         ///< Total length of the code, 0 if no code starts with these bits.
+		uint8 subTableBits;   ///< Number of bits indexing the next table, 0 if there is none.
+	};
+
+	typedef Array<TableEntry> Table;
+
+	/** Number of bits used to index the first lookup table. */
+	enum {
+		kLookupBits = 9
+	};
+
 	/** Lists of codes and their symbols, sorted by code length. */
 	CodeLists _codes;
 
 	/** Sorted list of pointers to the symbols. */
 	SymbolList _symbols;
+
+	/** Bits indexing the first lookup table. */
+	uint8 _lookupBits;
+
+	/** Lookup tables for bitstreams handing out their bits MSB to LSB, and LSB to MSB. */
+	Table _tableMSB, _tableLSB;
+
+	void buildTable(Table &table, bool msbFirst);
+	void addToTable(Table &table, bool msbFirst, const Symbol &symbol, uint8 length);
+
+	/** Decode a symbol one bit at a time. */
+	uint32 getSymbolSlow(BitStream &bits) const;
 };
 
 } // End of namespace Common
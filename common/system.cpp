@@ -149,6 +149,10 @@ Common::String OSystem::getDefaultConfigFileName() {
 	return "scummvm.ini";
 }
 
+Common::String OSystem::getCachePath() {
+	return Common::String();
+}
+
 Common::String OSystem::getSystemLanguage() const {
 	return "en_US";
 }
@@ -1173,6 +1173,13 @@ public:
 	 */
 	virtual Common::String getDefaultConfigFileName();
 
+	/**
+	 * Get the path of a directory where data which can be recreated at any
+	 * time, like the parsed GUI theme, may be stored. Returns an empty
+	 * string if there is no such directory, which disables these caches.
+	 */
+	virtual Common::String getCachePath();
+
 	/**
 	 * Logs a given message.
 	 *
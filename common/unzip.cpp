@@ -104,7 +104,11 @@ typedef struct {
 
 #include "common/fs.h"
 #include "common/unzip.h"
-#include "common/memstream.h"
+#include "common/mutex.h"
+#include "common/ptr.h"
+#include "common/substream.h"
+#include "common/zlib.h"
+#include "common/textconsole.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
@@ -1417,11 +1421,140 @@ int unzGetGlobalComment(unzFile file, char *szComment, uLong uSizeBuf) {
 namespace Common {
 
 
+/**
+ * The stream of a ZIP file, shared by the archive and all streams opened for
+ * its members.
+ */
+struct ZipFileData {
+	ScopedPtr<SeekableReadStream> stream;
+	Mutex mutex;
+	int32 pos;	///< Position of stream after the last read, -1 if unknown
+
+	ZipFileData(SeekableReadStream *s) : stream(s), pos(-1) {}
+};
+
+/**
+ * A view of the shared ZIP file stream with its own position. Every read
+ * happens with the mutex locked, so that any number of member streams can be
+ * used at the same time, also from different threads. The file stream is
+ * only seeked when another view has moved it, so sequential reads of a
+ * single member don't pay for a seek each.
+ */
+class ZipFileStream : public SeekableReadStream {
+	SharedPtr<ZipFileData> _data;
+	int32 _pos;
+	bool _eos;
+	bool _err;
+
+public:
+	ZipFileStream(const SharedPtr<ZipFileData> &data) : _data(data), _pos(0), _eos(false), _err(false) {}
+
+	virtual bool eos() const { return _eos; }
+	virtual bool err() const { return _err; }
+	virtual void clearErr() { _eos = _err = false; }
+
+	virtual uint32 read(void *dataPtr, uint32 dataSize) {
+		StackLock lock(_data->mutex);
+
+		SeekableReadStream &stream = *_data->stream;
+		if (_data->pos != _pos)
+			stream.seek(_pos, SEEK_SET);
+		const uint32 count = stream.read(dataPtr, dataSize);
+		_pos += count;
+		_data->pos = _pos;
+
+		if (stream.eos())
+			_eos = true;
+		if (stream.err())
+			_err = true;
+		if (_eos || _err)
+			_data->pos = -1;
+		stream.clearErr();
+
+		return count;
+	}
+
+	virtual int32 pos() const { return _pos; }
+
+	virtual int32 size() const {
+		StackLock lock(_data->mutex);
+		return _data->stream->size();
+	}
+
+	virtual bool seek(int32 offset, int whence = SEEK_SET) {
+		switch (whence) {
+		case SEEK_END:
+			offset = size() + offset;
+			// fallthrough
+		case SEEK_SET:
+			_pos = offset;
+			break;
+		case SEEK_CUR:
+			_pos += offset;
+			break;
+		}
+
+		assert(_pos >= 0);
+		_eos = false;
+		return true;
+	}
+};
+
+#ifdef USE_ZLIB
+/**
+ * Verifies the CRC-32 of a ZIP member while it is being read. The checksum
+ * is updated as long as the data is read in order. Data read again after a
+ * seek backwards is skipped, and seeking forward over unread data stops the
+ * check until the reader comes back to it. Once the whole member has been
+ * seen and the checksum doesn't match, a warning is printed and err() is
+ * set, like unzCloseCurrentFile() reporting UNZ_CRCERROR.
+ */
+class ZipCrcStream : public SeekableReadStream {
+	ScopedPtr<SeekableReadStream> _parentStream;
+	String _name;
+	uLong _expected;
+	uLong _crc;
+	uint32 _checked;	///< Number of bytes included in _crc
+	bool _crcErr;
+
+public:
+	ZipCrcStream(SeekableReadStream *parentStream, const String &name, uLong expected)
+		: _parentStream(parentStream), _name(name), _expected(expected), _crc(crc32(0, Z_NULL, 0)), _checked(0), _crcErr(false) {}
+
+	virtual bool eos() const { return _parentStream->eos(); }
+	virtual bool err() const { return _crcErr || _parentStream->err(); }
+	virtual void clearErr() { _parentStream->clearErr(); }
+
+	virtual uint32 read(void *dataPtr, uint32 dataSize) {
+		const uint32 start = _parentStream->pos();
+		const uint32 count = _parentStream->read(dataPtr, dataSize);
+
+		if (start <= _checked && start + count > _checked) {
+			const uint32 skip = _checked - start;
+			_crc = crc32(_crc, (const Bytef *)dataPtr + skip, count - skip);
+			_checked = start + count;
+
+			if (_checked == (uint32)size() && _crc != _expected) {
+				warning("ZipCrcStream: CRC error in '%s'", _name.c_str());
+				_crcErr = true;
+			}
+		}
+
+		return count;
+	}
+
+	virtual int32 pos() const { return _parentStream->pos(); }
+	virtual int32 size() const { return _parentStream->size(); }
+	virtual bool seek(int32 offset, int whence = SEEK_SET) { return _parentStream->seek(offset, whence); }
+};
+#endif
+
 class ZipArchive : public Archive {
 	unzFile _zipFile;
+	SharedPtr<ZipFileData> _data;
 
 public:
-	ZipArchive(unzFile zipFile);
+	ZipArchive(unzFile zipFile, const SharedPtr<ZipFileData> &data);
 
 
 	~ZipArchive();
@@ -1450,7 +1583,7 @@ public:
 };
 */
 
-ZipArchive::ZipArchive(unzFile zipFile) : _zipFile(zipFile) {
+ZipArchive::ZipArchive(unzFile zipFile, const SharedPtr<ZipFileData> &data) : _zipFile(zipFile), _data(data) {
 	assert(_zipFile);
 }
 
@@ -1458,24 +1591,21 @@ ZipArchive::~ZipArchive() {
 	unzClose(_zipFile);
 }
 
+// The member lookups only use the file list cached by unzOpen(). Unlike
+// unzLocateFile() and friends, they leave the current file of _zipFile
+// alone, so that members can be looked up and opened concurrently.
+
 bool ZipArchive::hasFile(const String &name) const {
-	return (unzLocateFile(_zipFile, name.c_str(), 2) == UNZ_OK);
+	return ((unz_s *)_zipFile)->_hash.contains(name);
 }
 
 int ZipArchive::listMembers(ArchiveMemberList &list) const {
+	const ZipHash &hash = ((unz_s *)_zipFile)->_hash;
 	int matches = 0;
-	int err = unzGoToFirstFile(_zipFile);
 
-	while (err == UNZ_OK) {
-		char szCurrentFileName[UNZ_MAXFILENAMEINZIP+1];
-		if (unzGetCurrentFileInfo(_zipFile, NULL,
-		                          szCurrentFileName, sizeof(szCurrentFileName)-1,
-		                          NULL, 0, NULL, 0) == UNZ_OK) {
-			list.push_back(ArchiveMemberList::value_type(new GenericArchiveMember(szCurrentFileName, this)));
-			matches++;
-		}
-
-		err = unzGoToNextFile(_zipFile);
+	for (ZipHash::const_iterator i = hash.begin(); i != hash.end(); ++i) {
+		list.push_back(ArchiveMemberList::value_type(new GenericArchiveMember(i->_key, this)));
+		matches++;
 	}
 
 	return matches;
@@ -1489,35 +1619,47 @@ const ArchiveMemberPtr ZipArchive::getMember(const String &name) const {
 }
 
 SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) const {
-	if (unzLocateFile(_zipFile, name.c_str(), 2) != UNZ_OK)
-		return 0;
+	const unz_s *s = (const unz_s *)_zipFile;
 
-	unz_file_info fileInfo;
-	if (unzOpenCurrentFile(_zipFile) != UNZ_OK)
+	ZipHash::const_iterator i = s->_hash.find(name);
+	if (i == s->_hash.end())
 		return 0;
 
-	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK)
+	const unz_file_info &fileInfo = i->_value.cur_file_info;
+	if (fileInfo.compression_method != 0 && fileInfo.compression_method != Z_DEFLATED)
 		return 0;
 
-	byte *buffer = (byte *)malloc(fileInfo.uncompressed_size);
-	assert(buffer);
+	// The data follows the local header, whose extra field does not need
+	// to match the one in the central directory
+	ZipFileStream *stream = new ZipFileStream(_data);
+	stream->seek(i->_value.cur_file_info_internal.offset_curfile + s->byte_before_the_zipfile, SEEK_SET);
 
-	if (unzReadCurrentFile(_zipFile, buffer, fileInfo.uncompressed_size) != (int)fileInfo.uncompressed_size) {
-		free(buffer);
-		return 0;
-	}
+	const uint32 magic = stream->readUint32LE();
+	stream->skip(SIZEZIPLOCALHEADER - 8);
+	const uint32 sizeFilename = stream->readUint16LE();
+	const uint32 sizeExtraField = stream->readUint16LE();
 
-	if (unzCloseCurrentFile(_zipFile) != UNZ_OK) {
-		free(buffer);
+	if (stream->err() || stream->eos() || magic != 0x04034b50) {
+		delete stream;
 		return 0;
 	}
 
-	return new MemoryReadStream(buffer, fileInfo.uncompressed_size, DisposeAfterUse::YES);
+	// Stored members are read straight from the ZIP file, deflated ones
+	// are decompressed while being read
+	const uint32 begin = stream->pos() + sizeFilename + sizeExtraField;
+	SeekableReadStream *data = new SeekableSubReadStream(stream, begin, begin + fileInfo.compressed_size, DisposeAfterUse::YES);
+
+	if (fileInfo.compression_method != 0)
+		data = wrapDeflateReadStream(data, fileInfo.uncompressed_size);
+
+#ifdef USE_ZLIB
+	// Only verify the CRC when zlib is linked in, because otherwise crc32()
+	// is not defined
+	if (data)
+		data = new ZipCrcStream(data, name, fileInfo.crc);
+#endif
 
-	// FIXME: instead of reading all into a memory stream, we could
-	// instead create a new ZipStream class. But then we have to be
-	// careful to handle the case where the client code opens multiple
-	// files in the archive and tries to use them independently.
+	return data;
 }
 
 Archive *makeZipArchive(const String &name) {
@@ -1531,13 +1673,14 @@ Archive *makeZipArchive(const FSNode &node) {
 Archive *makeZipArchive(SeekableReadStream *stream) {
 	if (!stream)
 		return 0;
-	unzFile zipFile = unzOpen(stream);
+	SharedPtr<ZipFileData> data(new ZipFileData(stream));
+	unzFile zipFile = unzOpen(new ZipFileStream(data));
 	if (!zipFile) {
-		// stream gets deleted by unzOpen() call if something
-		// goes wrong.
+		// The ZipFileStream gets deleted by unzOpen() call if something
+		// goes wrong, and stream with the last reference to data.
 		return 0;
 	}
-	return new ZipArchive(zipFile);
+	return new ZipArchive(zipFile, data);
 }
 
 }	// End of namespace Common
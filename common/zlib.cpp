@@ -24,6 +24,7 @@
 #define FORBIDDEN_SYMBOL_ALLOW_ALL
 
 #include "common/zlib.h"
+#include "common/array.h"
 #include "common/ptr.h"
 #include "common/util.h"
 #include "common/stream.h"
@@ -88,12 +89,28 @@ bool inflateZlibHeaderless(byte *dst, uint dstLen, const byte *src, uint srcLen,
 /**
  * A simple wrapper class which can be used to wrap around an arbitrary
  * other SeekableReadStream and will then provide on-the-fly decompression support.
- * Assumes the compressed data to be in gzip format.
+ * Assumes the compressed data to be in gzip or zlib format, or to be raw
+ * deflate data without any header.
+ *
+ * While reading, a copy of the decompressor state is kept every
+ * CHECKPOINT_INTERVAL bytes. Seeking continues from the last such
+ * checkpoint before the target, if it is closer than the current position,
+ * so once the data has been read a seek never has to decompress more than
+ * one checkpoint interval.
  */
 class GZipReadStream : public SeekableReadStream {
 protected:
 	enum {
-		BUFSIZE = 16384		// 1 << MAX_WBITS
+		BUFSIZE = 16384,		// 1 << MAX_WBITS
+		CHECKPOINT_INTERVAL = 256 * 1024,
+		MAX_CHECKPOINTS = 32,	// Each one takes about 40 KB
+		NO_CHECKPOINTS = 0xFFFFFFFF
+	};
+
+	struct Checkpoint {
+		uint32 pos;			// Position in the uncompressed data
+		int32 wrappedPos;	// Position in the wrapped stream of the next input byte
+		z_stream *stream;	// Copy of the decompressor state
 	};
 
 	byte	_buf[BUFSIZE];
@@ -105,35 +122,149 @@ protected:
 	uint32 _origSize;
 	bool _eos;
 
+	// Checkpoints are only created once the stream has been seeked
+	// backwards, so that sequential readers don't pay for them. Until then
+	// _nextCheckpointPos is NO_CHECKPOINTS.
+	Array<Checkpoint> _checkpoints;
+	uint32 _checkpointInterval;
+	uint32 _nextCheckpointPos;
+
+	/**
+	 * Decompress up to dataSize bytes, without updating the position.
+	 */
+	uint32 inflateData(byte *dataPtr, uint32 dataSize) {
+		_stream.next_out = dataPtr;
+		_stream.avail_out = dataSize;
+
+		// Keep going while we get no error
+		while (_zlibErr == Z_OK && _stream.avail_out) {
+			if (_stream.avail_in == 0 && !_wrapped->eos()) {
+				// If we are out of input data: Read more data, if available.
+				_stream.next_in = _buf;
+				_stream.avail_in = _wrapped->read(_buf, BUFSIZE);
+			}
+			_zlibErr = inflate(&_stream, Z_NO_FLUSH);
+		}
+
+		return dataSize - _stream.avail_out;
+	}
+
+	void addCheckpoint() {
+		// When there are too many checkpoints, drop every other one and
+		// continue with twice the interval
+		if (_checkpoints.size() >= MAX_CHECKPOINTS) {
+			uint kept = 0;
+			for (uint i = 0; i < _checkpoints.size(); i++) {
+				if (i % 2 == 0) {
+					inflateEnd(_checkpoints[i].stream);
+					delete _checkpoints[i].stream;
+				} else {
+					_checkpoints[kept++] = _checkpoints[i];
+				}
+			}
+			_checkpoints.resize(kept);
+			_checkpointInterval *= 2;
+
+			if (_pos % _checkpointInterval != 0)
+				return;
+		}
+
+		Checkpoint checkpoint;
+		checkpoint.stream = new z_stream;
+		if (inflateCopy(checkpoint.stream, &_stream) != Z_OK) {
+			delete checkpoint.stream;
+			return;
+		}
+
+		// The input still buffered has to be read again when the
+		// checkpoint is restored
+		checkpoint.pos = _pos;
+		checkpoint.wrappedPos = _wrapped->pos() - _stream.avail_in;
+		_checkpoints.push_back(checkpoint);
+	}
+
+	/**
+	 * Find the last checkpoint at or before the given position.
+	 * Returns -1 if there is none.
+	 */
+	int findCheckpoint(uint32 pos) const {
+		// The checkpoints are sorted by position
+		int lo = 0, hi = _checkpoints.size() - 1, found = -1;
+		while (lo <= hi) {
+			const int mid = (lo + hi) / 2;
+			if (_checkpoints[mid].pos <= pos) {
+				found = mid;
+				lo = mid + 1;
+			} else {
+				hi = mid - 1;
+			}
+		}
+		return found;
+	}
+
+	/**
+	 * Continue decompressing from the given checkpoint, or from the start
+	 * if it is -1.
+	 */
+	bool restoreCheckpoint(int i) {
+		if (i >= 0) {
+			inflateEnd(&_stream);
+			_zlibErr = inflateCopy(&_stream, _checkpoints[i].stream);
+			_pos = _checkpoints[i].pos;
+			_wrapped->seek(_checkpoints[i].wrappedPos, SEEK_SET);
+		} else {
+			// Before the first checkpoint, restart the decompression from
+			// the start of the file
+			_pos = 0;
+			_wrapped->seek(0, SEEK_SET);
+			_zlibErr = inflateReset(&_stream);
+		}
+
+		_stream.next_in = _buf;
+		_stream.avail_in = 0;
+		return _zlibErr == Z_OK;
+	}
+
 public:
 
-	GZipReadStream(SeekableReadStream *w) : _wrapped(w), _stream() {
+	GZipReadStream(SeekableReadStream *w, uint32 knownSize = 0, bool raw = false) : _wrapped(w), _stream() {
 		assert(w != 0);
 
-		// Verify file header is correct
-		w->seek(0, SEEK_SET);
-		uint16 header = w->readUint16BE();
-		assert(header == 0x1F8B ||
-		       ((header & 0x0F00) == 0x0800 && header % 31 == 0));
-
-		if (header == 0x1F8B) {
-			// Retrieve the original file size
-			w->seek(-4, SEEK_END);
-			_origSize = w->readUint32LE();
+		int windowBits;
+		if (raw) {
+			// Negative MAX_WBITS tells zlib there's no header
+			_origSize = knownSize;
+			windowBits = -MAX_WBITS;
 		} else {
-			// Original size not available in zlib format
-			_origSize = 0;
+			// Verify file header is correct
+			w->seek(0, SEEK_SET);
+			uint16 header = w->readUint16BE();
+			assert(header == 0x1F8B ||
+			       ((header & 0x0F00) == 0x0800 && header % 31 == 0));
+
+			if (header == 0x1F8B) {
+				// Retrieve the original file size
+				w->seek(-4, SEEK_END);
+				_origSize = w->readUint32LE();
+			} else {
+				// Original size not available in zlib format
+				_origSize = knownSize;
+			}
+
+			// Adding 32 to windowBits indicates to zlib that it is supposed to
+			// automatically detect whether gzip or zlib headers are used for
+			// the compressed file. This feature was added in zlib 1.2.0.4,
+			// released 10 August 2003.
+			// Note: This is *crucial* for savegame compatibility, do *not* remove!
+			windowBits = MAX_WBITS + 32;
 		}
 		_pos = 0;
 		w->seek(0, SEEK_SET);
 		_eos = false;
+		_checkpointInterval = CHECKPOINT_INTERVAL;
+		_nextCheckpointPos = NO_CHECKPOINTS;
 
-		// Adding 32 to windowBits indicates to zlib that it is supposed to
-		// automatically detect whether gzip or zlib headers are used for
-		// the compressed file. This feature was added in zlib 1.2.0.4,
-		// released 10 August 2003.
-		// Note: This is *crucial* for savegame compatibility, do *not* remove!
-		_zlibErr = inflateInit2(&_stream, MAX_WBITS + 32);
+		_zlibErr = inflateInit2(&_stream, windowBits);
 		if (_zlibErr != Z_OK)
 			return;
 
@@ -143,6 +274,10 @@ public:
 	}
 
 	~GZipReadStream() {
+		for (uint i = 0; i < _checkpoints.size(); i++) {
+			inflateEnd(_checkpoints[i].stream);
+			delete _checkpoints[i].stream;
+		}
 		inflateEnd(&_stream);
 	}
 
@@ -153,26 +288,27 @@ public:
 	}
 
 	uint32 read(void *dataPtr, uint32 dataSize) {
-		_stream.next_out = (byte *)dataPtr;
-		_stream.avail_out = dataSize;
-
-		// Keep going while we get no error
-		while (_zlibErr == Z_OK && _stream.avail_out) {
-			if (_stream.avail_in == 0 && !_wrapped->eos()) {
-				// If we are out of input data: Read more data, if available.
-				_stream.next_in = _buf;
-				_stream.avail_in = _wrapped->read(_buf, BUFSIZE);
+		byte *out = (byte *)dataPtr;
+		uint32 remaining = dataSize;
+
+		// Stop at the next checkpoint position, if it has not been
+		// reached before
+		while (_zlibErr == Z_OK && remaining) {
+			if (_pos == _nextCheckpointPos) {
+				addCheckpoint();
+				_nextCheckpointPos = (_pos / _checkpointInterval + 1) * _checkpointInterval;
 			}
-			_zlibErr = inflate(&_stream, Z_NO_FLUSH);
-		}
 
-		// Update the position counter
-		_pos += dataSize - _stream.avail_out;
+			const uint32 count = inflateData(out, MIN(remaining, _nextCheckpointPos - _pos));
+			_pos += count;
+			out += count;
+			remaining -= count;
+		}
 
-		if (_zlibErr == Z_STREAM_END && _stream.avail_out > 0)
+		if (_zlibErr == Z_STREAM_END && remaining > 0)
 			_eos = true;
 
-		return dataSize - _stream.avail_out;
+		return dataSize - remaining;
 	}
 
 	bool eos() const {
@@ -197,27 +333,23 @@ public:
 
 		assert(newPos >= 0);
 
-		if ((uint32)newPos < _pos) {
-			// To search backward, we have to restart the whole decompression
-			// from the start of the file. A rather wasteful operation, best
-			// to avoid it. :/
-#if DEBUG
-			warning("Backward seeking in GZipReadStream detected");
-#endif
-			_pos = 0;
-			_wrapped->seek(0, SEEK_SET);
-			_zlibErr = inflateReset(&_stream);
-			if (_zlibErr != Z_OK)
+		// Start creating checkpoints on the first backward seek. There are
+		// none yet, so this seek restarts from the start of the stream.
+		if ((uint32)newPos < _pos && _nextCheckpointPos == NO_CHECKPOINTS)
+			_nextCheckpointPos = _checkpointInterval;
+
+		// Jump to the closest checkpoint before the target, when seeking
+		// backwards or forward over data that has been read before
+		const int checkpoint = findCheckpoint(newPos);
+		if ((uint32)newPos < _pos || (checkpoint >= 0 && _checkpoints[checkpoint].pos > _pos)) {
+			if (!restoreCheckpoint(checkpoint))
 				return false;	// FIXME: STREAM REWRITE
-			_stream.next_in = _buf;
-			_stream.avail_in = 0;
 		}
 
 		offset = newPos - _pos;
 
-		// Skip the given amount of data (very inefficient if one tries to skip
-		// huge amounts of data, but usually client code will only skip a few
-		// bytes, so this should be fine.
+		// Skip the remaining data. Unless the target lies beyond what has
+		// been read so far, this is less than one checkpoint interval.
 		byte tmpBuf[1024];
 		while (!err() && offset > 0) {
 			offset -= read(tmpBuf, MIN((int32)sizeof(tmpBuf), offset));
@@ -351,6 +483,16 @@ SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped) {
 	return toBeWrapped;
 }
 
+SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped, uint32 knownSize) {
+#if defined(USE_ZLIB)
+	if (toBeWrapped)
+		return new GZipReadStream(toBeWrapped, knownSize, true);
+#else
+	delete toBeWrapped;
+#endif
+	return 0;
+}
+
 WriteStream *wrapCompressedWriteStream(WriteStream *toBeWrapped) {
 #if defined(USE_ZLIB)
 	if (toBeWrapped)
@@ -91,6 +91,20 @@ bool inflateZlibHeaderless(byte *dst, uint dstLen, const byte *src, uint srcLen,
  */
 SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped);
 
+/**
+ * Take an arbitrary SeekableReadStream containing raw deflate data, i.e.
+ * without any gzip or zlib header, as found in ZIP files, and wrap it in a
+ * custom stream which provides transparent on-the-fly decompression.
+ *
+ * The wrapper takes ownership of the given stream. If ZLIB support has been
+ * disabled, the stream is deleted and NULL is returned. It is safe to call
+ * this with a NULL parameter (in this case, NULL is returned).
+ *
+ * @param toBeWrapped   the stream with the compressed data
+ * @param knownSize     the size of the uncompressed data
+ */
+SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped, uint32 knownSize);
+
 /**
  * Take an arbitrary WriteStream and wrap it in a custom stream which provides
  * transparent on-the-fly compression. The compressed data is written in the
@@ -287,6 +287,51 @@ struct SizeMD5 {
 
 typedef Common::HashMap<Common::String, SizeMD5, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> SizeMD5Map;
 
+/**
+ * Sizes and MD5 sums of the files hashed while an ADHashCacheScope exists,
+ * keyed by path and number of hashed bytes.
+ */
+typedef Common::HashMap<Common::String, SizeMD5> HashCache;
+
+static HashCache *s_hashCache = 0;
+static int s_hashCacheScopes = 0;
+
+ADHashCacheScope::ADHashCacheScope() {
+	if (s_hashCacheScopes++ == 0)
+		s_hashCache = new HashCache();
+}
+
+ADHashCacheScope::~ADHashCacheScope() {
+	if (--s_hashCacheScopes == 0) {
+		delete s_hashCache;
+		s_hashCache = 0;
+	}
+}
+
+static void computeSizeMD5(const Common::FSNode &node, uint32 md5Bytes, SizeMD5 &result) {
+	Common::String key;
+	if (s_hashCache) {
+		key = Common::String::format("%s:%u", node.getPath().c_str(), md5Bytes);
+		HashCache::const_iterator cached = s_hashCache->find(key);
+		if (cached != s_hashCache->end()) {
+			result = cached->_value;
+			return;
+		}
+	}
+
+	Common::File testFile;
+
+	if (testFile.open(node)) {
+		result.size = (int32)testFile.size();
+		result.md5 = Common::computeStreamMD5AsString(testFile, md5Bytes);
+	} else {
+		result.size = -1;
+	}
+
+	if (s_hashCache)
+		(*s_hashCache)[key] = result;
+}
+
 static void reportUnknown(const Common::FSNode &path, const SizeMD5Map &filesSizeMD5) {
 	// TODO: This message should be cleaned up / made more specific.
 	// For example, we should specify at least which engine triggered this.
@@ -384,14 +429,7 @@ ADGameDescList AdvancedMetaEngine::detectGame(const Common::FSNode &parent, cons
 				if (allFiles.contains(fname)) {
 					debug(3, "+ %s", fname.c_str());
 
-					Common::File testFile;
-
-					if (testFile.open(allFiles[fname])) {
-						tmp.size = (int32)testFile.size();
-						tmp.md5 = Common::computeStreamMD5AsString(testFile, _md5Bytes);
-					} else {
-						tmp.size = -1;
-					}
+					computeSizeMD5(allFiles[fname], _md5Bytes, tmp);
 
 					debug(3, "> '%s': '%s'", fname.c_str(), tmp.md5.c_str());
 					filesSizeMD5[fname] = tmp;
@@ -133,6 +133,20 @@ enum ADFlags {
 };
 
 
+/**
+ * While at least one instance of this class exists, the file sizes and MD5
+ * sums computed by the advanced detector are cached and shared by all
+ * engines. A file checked by several engines, or by detection runs over
+ * overlapping directories, is then only read once. The cache is dropped
+ * together with the last instance, so changes to the files between two
+ * scans are picked up.
+ */
+class ADHashCacheScope {
+public:
+	ADHashCacheScope();
+	~ADHashCacheScope();
+};
+
 /**
  * A MetaEngine implementation based around the advanced detector code.
  */
@@ -72,7 +72,7 @@ bool g_debug_track_mouse_clicks = false;
 static int parse_reg_t(EngineState *s, const char *str, reg_t *dest, bool mayBeValue);
 
 Console::Console(SciEngine *engine) : GUI::Debugger(),
-	_engine(engine), _debugState(engine->_debugState) {
+	_engine(engine), _debugState(engine->_debugState), _lastScriptSteps(0), _lastScriptStepsTime(0) {
 
 	assert(_engine);
 	assert(_engine->_gamestate);
@@ -108,6 +108,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	DCmd_Register("resource_id",		WRAP_METHOD(Console, cmdResourceId));
 	DCmd_Register("resource_info",		WRAP_METHOD(Console, cmdResourceInfo));
 	DCmd_Register("resource_types",		WRAP_METHOD(Console, cmdResourceTypes));
+	DCmd_Register("resource_cache",		WRAP_METHOD(Console, cmdResourceCache));
 	DCmd_Register("list",				WRAP_METHOD(Console, cmdList));
 	DCmd_Register("hexgrep",			WRAP_METHOD(Console, cmdHexgrep));
 	DCmd_Register("verify_scripts",		WRAP_METHOD(Console, cmdVerifyScripts));
@@ -146,6 +147,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	DCmd_Register("gc_reachable",		WRAP_METHOD(Console, cmdGCShowReachable));
 	DCmd_Register("gc_freeable",		WRAP_METHOD(Console, cmdGCShowFreeable));
 	DCmd_Register("gc_normalize",		WRAP_METHOD(Console, cmdGCNormalize));
+	DCmd_Register("gc_stats",			WRAP_METHOD(Console, cmdGCStats));
 	// Music/SFX
 	DCmd_Register("songlib",			WRAP_METHOD(Console, cmdSongLib));
 	DCmd_Register("songinfo",			WRAP_METHOD(Console, cmdSongInfo));
@@ -201,6 +203,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	DCmd_Register("bpe",				WRAP_METHOD(Console, cmdBreakpointFunction));		// alias
 	// VM
 	DCmd_Register("script_steps",		WRAP_METHOD(Console, cmdScriptSteps));
+	DCmd_Register("selector_cache",		WRAP_METHOD(Console, cmdSelectorCache));
 	DCmd_Register("vm_varlist",			WRAP_METHOD(Console, cmdVMVarlist));
 	DCmd_Register("vmvarlist",			WRAP_METHOD(Console, cmdVMVarlist));				// alias
 	DCmd_Register("vl",					WRAP_METHOD(Console, cmdVMVarlist));				// alias
@@ -344,6 +347,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	DebugPrintf(" resource_id - Identifies a resource number by splitting it up in resource type and resource number\n");
 	DebugPrintf(" resource_info - Shows info about a resource\n");
 	DebugPrintf(" resource_types - Shows the valid resource types\n");
+	DebugPrintf(" resource_cache - Shows the resource cache statistics, or changes its size\n");
 	DebugPrintf(" list - Lists all the resources of a given type\n");
 	DebugPrintf(" hexgrep - Searches some resources for a particular sequence of bytes, represented as hexadecimal numbers\n");
 	DebugPrintf(" verify_scripts - Performs sanity checks on SCI1.1-SCI2.1 game scripts (e.g. if they're up to 64KB in total)\n");
@@ -380,6 +384,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	DebugPrintf(" gc_reachable - Lists all addresses directly reachable from a given memory object\n");
 	DebugPrintf(" gc_freeable - Lists all addresses freeable in a given segment\n");
 	DebugPrintf(" gc_normalize - Prints the \"normal\" address of a given address\n");
+	DebugPrintf(" gc_stats - Shows or resets garbage collector pause times and freed objects\n");
 	DebugPrintf("\n");
 	DebugPrintf("Music/SFX:\n");
 	DebugPrintf(" songlib - Shows the song library\n");
@@ -420,7 +425,8 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	DebugPrintf(" bp_function / bpe - Sets a breakpoint on the execution of the specified exported function\n");
 	DebugPrintf("\n");
 	DebugPrintf("VM:\n");
-	DebugPrintf(" script_steps - Shows the number of executed SCI operations\n");
+	DebugPrintf(" script_steps - Shows the number of executed SCI operations, and their rate since the last call\n");
+	DebugPrintf(" selector_cache - Shows or resets the selector lookup cache statistics\n");
 	DebugPrintf(" vm_varlist / vmvarlist / vl - Shows the addresses of variables in the VM\n");
 	DebugPrintf(" vm_vars / vmvars / vv - Displays or changes variables in the VM\n");
 	DebugPrintf(" stack - Lists the specified number of stack elements\n");
@@ -1097,6 +1103,36 @@ bool Console::cmdMapInstrument(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdResourceCache(int argc, const char **argv) {
+	ResourceManager *resMan = _engine->getResMan();
+	ResourceCacheStats &stats = resMan->getCacheStats();
+
+	if (argc == 2 && !scumm_stricmp(argv[1], "reset")) {
+		stats.reset();
+		DebugPrintf("Resource cache statistics reset\n");
+		return true;
+	} else if ((argc == 3 || argc == 4) && !scumm_stricmp(argv[1], "size")) {
+		const int maxPacked = (argc == 4) ? atoi(argv[3]) : resMan->getPackedCacheSize() / 1024;
+		resMan->setCacheSize(atoi(argv[2]) * 1024, maxPacked * 1024);
+		DebugPrintf("Resource cache size set to %d KB, compressed data %d KB\n", resMan->getCacheSize() / 1024, resMan->getPackedCacheSize() / 1024);
+		return true;
+	} else if (argc != 1) {
+		DebugPrintf("Shows the resource cache statistics, resets them, or sets the cache size.\n");
+		DebugPrintf("Usage: %s [reset | size <KB> [<compressed KB>]]\n", argv[0]);
+		return true;
+	}
+
+	const uint32 total = stats.hits + stats.misses;
+
+	DebugPrintf("Unlocked resources: %d, %d of %d KB\n", resMan->getLRUCount(), resMan->getLRUMemory() / 1024, resMan->getCacheSize() / 1024);
+	DebugPrintf("Locked resources: %d KB\n", resMan->getLockedMemory() / 1024);
+	DebugPrintf("Compressed data: %d resources, %d of %d KB\n", resMan->getPackedCount(), resMan->getPackedMemory() / 1024, resMan->getPackedCacheSize() / 1024);
+	DebugPrintf("Hits: %d, misses: %d (%d%% hit rate), restored from compressed data: %d\n", stats.hits, stats.misses, total ? (int)(100.0 * stats.hits / total) : 0, stats.packedHits);
+	DebugPrintf("Evictions: %d\n", stats.evictions);
+	DebugPrintf("Decompressions: %d, taking %d ms\n", stats.decompressions, stats.decompressTime);
+	return true;
+}
+
 bool Console::cmdList(int argc, const char **argv) {
 	if (argc < 2) {
 		DebugPrintf("Lists all the resources of a given type\n");
@@ -2176,6 +2212,26 @@ bool Console::cmdGCObjects(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdGCStats(int argc, const char **argv) {
+	GCState &gc = _engine->_gamestate->_segMan->getGCState();
+
+	if (argc == 2 && !scumm_stricmp(argv[1], "reset")) {
+		gc.resetStats();
+		DebugPrintf("Garbage collector statistics reset\n");
+		return true;
+	} else if (argc != 1) {
+		DebugPrintf("Shows pause times and freed objects of the garbage collector.\n");
+		DebugPrintf("Usage: %s [reset]\n", argv[0]);
+		return true;
+	}
+
+	DebugPrintf("Collections: %d%s\n", gc.collections, gc.isSweeping() ? " (sweep in progress)" : "");
+	DebugPrintf("Mark: last %d ms, max %d ms, total %d ms\n", gc.lastMarkTime, gc.maxMarkTime, gc.totalMarkTime);
+	DebugPrintf("Sweep: %d steps, max %d ms per step, last collection %d ms\n", gc.sweepSteps, gc.maxSweepStepTime, gc.lastSweepTime);
+	DebugPrintf("Objects freed: last collection %d, total %d\n", gc.lastFreed, gc.totalFreed);
+	return true;
+}
+
 bool Console::cmdGCShowReachable(int argc, const char **argv) {
 	if (argc != 2) {
 		DebugPrintf("Prints all addresses directly reachable from the memory object specified as parameter.\n");
@@ -2633,18 +2689,47 @@ bool Console::cmdViewAccumulatorObject(int argc, const char **argv) {
 }
 
 bool Console::cmdScriptSteps(int argc, const char **argv) {
-	DebugPrintf("Number of executed SCI operations: %d\n", _engine->_gamestate->scriptStepCounter);
+	const int steps = _engine->_gamestate->scriptStepCounter;
+	DebugPrintf("Number of executed SCI operations: %d\n", steps);
+
+	// Play time excludes the time spent in the debugger
+	const uint32 time = _engine->getTotalPlayTime();
+	if (_lastScriptStepsTime && time > _lastScriptStepsTime && steps >= _lastScriptSteps) {
+		DebugPrintf("Operations per second since the last call: %d\n",
+			(int)((steps - _lastScriptSteps) * 1000.0 / (time - _lastScriptStepsTime)));
+	}
+
+	_lastScriptSteps = steps;
+	_lastScriptStepsTime = time;
+	return true;
+}
+
+bool Console::cmdSelectorCache(int argc, const char **argv) {
+	SegManager *segMan = _engine->_gamestate->_segMan;
+
+	if (argc == 2 && !scumm_stricmp(argv[1], "reset")) {
+		segMan->resetSelectorCacheStats();
+		DebugPrintf("Selector cache statistics reset\n");
+		return true;
+	} else if (argc != 1) {
+		DebugPrintf("Shows the hit/miss statistics of the selector lookup cache.\n");
+		DebugPrintf("Usage: %s [reset]\n", argv[0]);
+		return true;
+	}
+
+	const uint32 hits = segMan->getSelectorCacheHits();
+	const uint32 misses = segMan->getSelectorCacheMisses();
+	const uint32 total = hits + misses;
+
+	DebugPrintf("Cached selector lookups: %d\n", segMan->getSelectorCacheSize());
+	DebugPrintf("Hits: %d, misses: %d (%d%% hit rate)\n", hits, misses, total ? (int)(100.0 * hits / total) : 0);
 	return true;
 }
 
 bool Console::cmdBacktrace(int argc, const char **argv) {
 	DebugPrintf("Call stack (current base: 0x%x):\n", _engine->_gamestate->executionStackBase);
-	Common::List<ExecStack>::const_iterator iter;
-	uint i = 0;
-
-	for (iter = _engine->_gamestate->_executionStack.begin();
-	     iter != _engine->_gamestate->_executionStack.end(); ++iter, ++i) {
-		const ExecStack &call = *iter;
+	for (uint i = 0; i < _engine->_gamestate->_executionStack.size(); ++i) {
+		const ExecStack &call = _engine->_gamestate->_executionStack[i];
 		const char *objname = _engine->_gamestate->_segMan->getObjectName(call.sendp);
 		int paramc, totalparamc;
 
@@ -22,6 +22,7 @@
 
 #include "sci/engine/gc.h"
 #include "common/array.h"
+#include "common/system.h"
 #include "sci/graphics/ports.h"
 
 namespace Sci {
@@ -44,6 +45,11 @@ const char *segmentTypeNames[] = {
 	"array",     // 11: SCI32 arrays
 	"string"     // 12: SCI32 strings
 };
+
+// Objects freed by type during the current collection, which may be swept
+// over several steps
+static const char *segnames[SEG_TYPE_MAX + 1];
+static int segcount[SEG_TYPE_MAX + 1];
 #endif
 
 void WorklistManager::push(reg_t reg) {
@@ -106,15 +112,15 @@ AddrSet *findAllActiveReferences(EngineState *s) {
 
 	// Initialize value stack
 	// We do this one by hand since the stack doesn't know the current execution stack
-	Common::List<ExecStack>::const_iterator iter = s->_executionStack.reverse_begin();
+	int top = s->_executionStack.size() - 1;
 
 	// Skip fake kernel stack frame if it's on top
-	if ((*iter).type == EXEC_STACK_TYPE_KERNEL)
-		--iter;
+	if (s->_executionStack[top].type == EXEC_STACK_TYPE_KERNEL)
+		--top;
 
-	assert((iter != s->_executionStack.end()) && ((*iter).type != EXEC_STACK_TYPE_KERNEL));
+	assert((top >= 0) && (s->_executionStack[top].type != EXEC_STACK_TYPE_KERNEL));
 
-	const StackPtr sp = iter->sp;
+	const StackPtr sp = s->_executionStack[top].sp;
 
 	for (reg_t *pos = s->stack_base; pos < sp; pos++)
 		wm.push(*pos);
@@ -122,9 +128,8 @@ AddrSet *findAllActiveReferences(EngineState *s) {
 	debugC(kDebugLevelGC, "[GC] -- Finished adding value stack");
 
 	// Init: Execution Stack
-	for (iter = s->_executionStack.begin();
-	     iter != s->_executionStack.end(); ++iter) {
-		const ExecStack &es = *iter;
+	for (uint i = 0; i < s->_executionStack.size(); ++i) {
+		const ExecStack &es = s->_executionStack[i];
 
 		if (es.type != EXEC_STACK_TYPE_KERNEL) {
 			wm.push(es.objp);
@@ -160,52 +165,107 @@ AddrSet *findAllActiveReferences(EngineState *s) {
 	return normalizeAddresses(s->_segMan, wm._map);
 }
 
-void run_gc(EngineState *s) {
+/**
+ * Marks all reachable objects and sets up the sweep of the heap.
+ */
+static void startCollection(EngineState *s) {
 	SegManager *segMan = s->_segMan;
+	GCState &gc = segMan->getGCState();
 
 	// Some debug stuff
 	debugC(kDebugLevelGC, "[GC] Running...");
 #ifdef GC_DEBUG_CODE
-	const char *segnames[SEG_TYPE_MAX + 1];
-	int segcount[SEG_TYPE_MAX + 1];
 	memset(segnames, 0, sizeof(segnames));
 	memset(segcount, 0, sizeof(segcount));
 #endif
 
+	gc.abortSweep();
+
+	const uint32 startTime = g_system->getMillis();
+
 	// Compute the set of all segments references currently in use.
-	AddrSet *activeRefs = findAllActiveReferences(s);
+	gc.reachable = findAllActiveReferences(s);
+	gc.sweepSegment = 0;
+	gc.sweepEnd = segMan->getSegments().size();
+	gc.sweepPos = 0;
+	gc.lastFreed = 0;
+	gc.lastSweepTime = 0;
+
+	const uint32 markTime = g_system->getMillis() - startTime;
+	gc.lastMarkTime = markTime;
+	gc.totalMarkTime += markTime;
+	if (markTime > gc.maxMarkTime)
+		gc.maxMarkTime = markTime;
+}
 
-	// Iterate over all segments, and check for each whether it
-	// contains stuff that can be collected.
+/**
+ * Frees unreachable objects found by the last mark.
+ * @param segMan	the segment manager
+ * @param budget	maximum number of addresses to check, 0 for no limit
+ * @return true if the sweep is finished
+ */
+static bool sweep(SegManager *segMan, uint budget) {
+	GCState &gc = segMan->getGCState();
 	const Common::Array<SegmentObj *> &heap = segMan->getSegments();
-	for (uint seg = 1; seg < heap.size(); seg++) {
-		SegmentObj *mobj = heap[seg];
+	uint checked = 0;
 
-		if (mobj != NULL) {
-#ifdef GC_DEBUG_CODE
-			const SegmentType type = mobj->getType();
-			segnames[type] = segmentTypeNames[type];
-#endif
+	while (!budget || checked < budget) {
+		if (gc.sweepPos >= gc.sweepList.size()) {
+			// Move on to the next segment
+			gc.sweepList.clear();
+			gc.sweepPos = 0;
+
+			if (++gc.sweepSegment >= gc.sweepEnd)
+				return true;
+
+			const SegmentId seg = gc.sweepSegment;
+
+			// Skip segments that were allocated after the mark
+			bool isNew = false;
+			for (uint i = 0; i < gc.newSegments.size(); i++) {
+				if (gc.newSegments[i] == seg)
+					isNew = true;
+			}
 
 			// Get a list of all deallocatable objects in this segment,
-			// then free any which are not referenced from somewhere.
-			const Common::Array<reg_t> tmp = mobj->listAllDeallocatable(seg);
-			for (Common::Array<reg_t>::const_iterator it = tmp.begin(); it != tmp.end(); ++it) {
-				const reg_t addr = *it;
-				if (!activeRefs->contains(addr)) {
-					// Not found -> we can free it
-					mobj->freeAtAddress(segMan, addr);
-					debugC(kDebugLevelGC, "[GC] Deallocating %04x:%04x", PRINT_REG(addr));
+			// to free any which are not referenced from somewhere.
+			if (!isNew && seg < heap.size() && heap[seg])
+				gc.sweepList = heap[seg]->listAllDeallocatable(seg);
+
+			++checked;
+			continue;
+		}
+
+		const reg_t addr = gc.sweepList[gc.sweepPos++];
+		++checked;
+
+		SegmentObj *mobj = heap[addr.segment];
+
+		// The object may have been freed by the scripts after the mark
+		if (!gc.reachable->contains(addr) && mobj->isValidOffset(addr.offset)) {
+			// Not found -> we can free it
+			mobj->freeAtAddress(segMan, addr);
+			debugC(kDebugLevelGC, "[GC] Deallocating %04x:%04x", PRINT_REG(addr));
+			gc.lastFreed++;
+			gc.totalFreed++;
 #ifdef GC_DEBUG_CODE
-					segcount[type]++;
+			const SegmentType type = mobj->getType();
+			segnames[type] = segmentTypeNames[type];
+			segcount[type]++;
 #endif
-				}
-			}
-
 		}
 	}
 
-	delete activeRefs;
+	return false;
+}
+
+static void finishCollection(SegManager *segMan) {
+	GCState &gc = segMan->getGCState();
+
+	gc.abortSweep();
+	gc.collections++;
+
+	debugC(kDebugLevelGC, "[GC] Freed %d objects", gc.lastFreed);
 
 #ifdef GC_DEBUG_CODE
 	// Output debug summary of garbage collection
@@ -216,4 +276,45 @@ void run_gc(EngineState *s) {
 #endif
 }
 
+void run_gc(EngineState *s) {
+	SegManager *segMan = s->_segMan;
+	GCState &gc = segMan->getGCState();
+
+	startCollection(s);
+
+	const uint32 startTime = g_system->getMillis();
+	sweep(segMan, 0);
+
+	const uint32 sweepTime = g_system->getMillis() - startTime;
+	gc.sweepSteps++;
+	gc.lastSweepTime = sweepTime;
+	if (sweepTime > gc.maxSweepStepTime)
+		gc.maxSweepStepTime = sweepTime;
+
+	finishCollection(segMan);
+}
+
+void run_gc_step(EngineState *s) {
+	SegManager *segMan = s->_segMan;
+	GCState &gc = segMan->getGCState();
+
+	// Start a new collection. The mark itself makes up the first step.
+	if (!gc.isSweeping()) {
+		startCollection(s);
+		return;
+	}
+
+	const uint32 startTime = g_system->getMillis();
+	const bool done = sweep(segMan, GC_SWEEP_STEP);
+
+	const uint32 sweepTime = g_system->getMillis() - startTime;
+	gc.sweepSteps++;
+	gc.lastSweepTime += sweepTime;
+	if (sweepTime > gc.maxSweepStepTime)
+		gc.maxSweepStepTime = sweepTime;
+
+	if (done)
+		finishCollection(segMan);
+}
+
 } // End of namespace Sci
@@ -30,18 +30,6 @@
 
 namespace Sci {
 
-struct reg_t_Hash {
-	uint operator()(const reg_t& x) const {
-		return (x.segment << 3) ^ x.offset ^ (x.offset << 16);
-	}
-};
-
-/*
- * The AddrSet is a "set" of reg_t values.
- * We don't have a HashSet type, so we abuse a HashMap for this.
- */
-typedef Common::HashMap<reg_t, bool, reg_t_Hash> AddrSet;
-
 /**
  * Finds all used references and normalises them to their memory addresses
  * @param s The state to gather all information from
@@ -50,11 +38,21 @@ typedef Common::HashMap<reg_t, bool, reg_t_Hash> AddrSet;
 AddrSet *findAllActiveReferences(EngineState *s);
 
 /**
- * Runs garbage collection on the current system state
+ * Runs a full garbage collection on the current system state
  * @param s The state in which we should gc
  */
 void run_gc(EngineState *s);
 
+/**
+ * Runs one step of an incremental garbage collection. If no collection is in
+ * progress, this marks all reachable objects, which can't be done
+ * incrementally as scripts write to objects and variables through raw
+ * pointers. The unreachable objects are then freed in bounded steps over
+ * the following calls.
+ * @param s The state in which we should gc
+ */
+void run_gc_step(EngineState *s);
+
 struct WorklistManager {
 	Common::Array<reg_t> _worklist;
 	AddrSet _map;	// used for 2 contains() calls, inside push() and run_gc()
@@ -515,12 +515,8 @@ reg_t kStub(EngineState *s, int argc, reg_t *argv) {
 	Kernel *kernel = g_sci->getKernel();
 	int kernelCallNr = -1;
 
-	Common::List<ExecStack>::const_iterator callIterator = s->_executionStack.end();
-	if (callIterator != s->_executionStack.begin()) {
-		callIterator--;
-		ExecStack lastCall = *callIterator;
-		kernelCallNr = lastCall.debugSelector;
-	}
+	if (!s->_executionStack.empty())
+		kernelCallNr = s->_executionStack.back().debugSelector;
 
 	Common::String warningMsg = "Dummy function k" + kernel->getKernelName(kernelCallNr) +
 								Common::String::format("[%x]", kernelCallNr) +
@@ -0,0 +1,993 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "sci/sci.h"
+#include "sci/engine/pathfinding.h"
+
+#include "common/debug.h"
+#include "common/textconsole.h"
+
+namespace Sci {
+
+// Visibility cache entries
+enum VisibilityState {
+	VIS_UNKNOWN = 0,
+	VIS_VISIBLE = 1,
+	VIS_HIDDEN = 2
+};
+
+// Floating point struct
+struct FloatPoint {
+	FloatPoint() : x(0), y(0) {}
+	FloatPoint(float x_, float y_) : x(x_), y(y_) {}
+
+	Common::Point toPoint() {
+		return Common::Point((int16)(x + 0.5), (int16)(y + 0.5));
+	}
+
+	float x, y;
+};
+
+/**
+ * Computes the area of a triangle
+ * Parameters: (const Common::Point &) a, b, c: The points of the triangle
+ * Returns   : (int) The area multiplied by two
+ */
+static int area(const Common::Point &a, const Common::Point &b, const Common::Point &c) {
+	return (b.x - a.x) * (a.y - c.y) - (c.x - a.x) * (a.y - b.y);
+}
+
+/**
+ * Determines whether or not a point is to the left of a directed line
+ * Parameters: (const Common::Point &) a, b: The directed line (a, b)
+ *             (const Common::Point &) c: The query point
+ * Returns   : (int) true if c is to the left of (a, b), false otherwise
+ */
+static bool left(const Common::Point &a, const Common::Point &b, const Common::Point &c) {
+	return area(a, b, c) > 0;
+}
+
+/**
+ * Determines whether or not three points are collinear
+ * Parameters: (const Common::Point &) a, b, c: The three points
+ * Returns   : (int) true if a, b, and c are collinear, false otherwise
+ */
+static bool collinear(const Common::Point &a, const Common::Point &b, const Common::Point &c) {
+	return area(a, b, c) == 0;
+}
+
+/**
+ * Determines whether or not a point lies on a line segment
+ * Parameters: (const Common::Point &) a, b: The line segment (a, b)
+ *             (const Common::Point &) c: The query point
+ * Returns   : (int) true if c lies on (a, b), false otherwise
+ */
+bool between(const Common::Point &a, const Common::Point &b, const Common::Point &c) {
+	if (!collinear(a, b, c))
+		return false;
+
+	// Assumes a != b.
+	if (a.x != b.x)
+		return ((a.x <= c.x) && (c.x <= b.x)) || ((a.x >= c.x) && (c.x >= b.x));
+	else
+		return ((a.y <= c.y) && (c.y <= b.y)) || ((a.y >= c.y) && (c.y >= b.y));
+}
+
+/**
+ * Determines whether or not two line segments properly intersect
+ * Parameters: (const Common::Point &) a, b: The line segment (a, b)
+ *             (const Common::Point &) c, d: The line segment (c, d)
+ * Returns   : (int) true if (a, b) properly intersects (c, d), false otherwise
+ */
+bool intersect_proper(const Common::Point &a, const Common::Point &b, const Common::Point &c, const Common::Point &d) {
+	int ab = (left(a, b, c) && left(b, a, d)) || (left(a, b, d) && left(b, a, c));
+	int cd = (left(c, d, a) && left(d, c, b)) || (left(c, d, b) && left(d, c, a));
+
+	return ab && cd;
+}
+
+/**
+ * Polygon containment test
+ * Parameters: (const Common::Point &) p: The point
+ *             (Polygon *) polygon: The polygon
+ * Returns   : (int) CONT_INSIDE if p is strictly contained in polygon,
+ *                   CONT_ON_EDGE if p lies on an edge of polygon,
+ *                   CONT_OUTSIDE otherwise
+ * Number of ray crossing left and right
+ */
+int contained(const Common::Point &p, Polygon *polygon) {
+	int lcross = 0, rcross = 0;
+	Vertex *vertex;
+
+	// Iterate over edges
+	CLIST_FOREACH(vertex, &polygon->vertices) {
+		const Common::Point &v1 = vertex->v;
+		const Common::Point &v2 = CLIST_NEXT(vertex)->v;
+
+		// Flags for ray straddling left and right
+		int rstrad, lstrad;
+
+		// Check if p is a vertex
+		if (p == v1)
+			return CONT_ON_EDGE;
+
+		// Check if edge straddles the ray
+		rstrad = (v1.y < p.y) != (v2.y < p.y);
+		lstrad = (v1.y > p.y) != (v2.y > p.y);
+
+		if (lstrad || rstrad) {
+			// Compute intersection point x / xq
+			int x = v2.x * v1.y - v1.x * v2.y + (v1.x - v2.x) * p.y;
+			int xq = v1.y - v2.y;
+
+			// Multiply by -1 if xq is negative (for comparison that follows)
+			if (xq < 0) {
+				x = -x;
+				xq = -xq;
+			}
+
+			// Avoid floats by multiplying instead of dividing
+			if (rstrad && (x > xq * p.x))
+				rcross++;
+			else if (lstrad && (x < xq * p.x))
+				lcross++;
+		}
+	}
+
+	// If we counted an odd number of total crossings the point is on an edge
+	if ((lcross + rcross) % 2 == 1)
+		return CONT_ON_EDGE;
+
+	// If there are an odd number of crossings to one side the point is contained in the polygon
+	if (rcross % 2 == 1) {
+		// Invert result for contained access polygons.
+		if (polygon->type == POLY_CONTAINED_ACCESS)
+			return CONT_OUTSIDE;
+		return CONT_INSIDE;
+	}
+
+	// Point is outside polygon. Invert result for contained access polygons
+	if (polygon->type == POLY_CONTAINED_ACCESS)
+		return CONT_INSIDE;
+
+	return CONT_OUTSIDE;
+}
+
+/**
+ * Computes polygon area
+ * Parameters: (Polygon *) polygon: The polygon
+ * Returns   : (int) The area multiplied by two
+ */
+static int polygon_area(Polygon *polygon) {
+	Vertex *first = polygon->vertices.first();
+	Vertex *v;
+	int size = 0;
+
+	v = CLIST_NEXT(first);
+
+	while (CLIST_NEXT(v) != first) {
+		size += area(first->v, v->v, CLIST_NEXT(v)->v);
+		v = CLIST_NEXT(v);
+	}
+
+	return size;
+}
+
+/**
+ * Fixes the vertex order of a polygon if incorrect. Contained access
+ * polygons should have their vertices ordered clockwise, all other types
+ * anti-clockwise
+ * Parameters: (Polygon *) polygon: The polygon
+ */
+void fix_vertex_order(Polygon *polygon) {
+	int area = polygon_area(polygon);
+
+	// When the polygon area is positive the vertices are ordered
+	// anti-clockwise. When the area is negative the vertices are ordered
+	// clockwise
+	if (((area > 0) && (polygon->type == POLY_CONTAINED_ACCESS))
+	        || ((area < 0) && (polygon->type != POLY_CONTAINED_ACCESS))) {
+
+		polygon->vertices.reverse();
+	}
+}
+
+/**
+ * Determines whether or not a line from a point to a vertex intersects the
+ * interior of the polygon, locally at that vertex
+ * Parameters: (Common::Point) p: The point
+ *             (Vertex *) vertex: The vertex
+ * Returns   : (int) 1 if the line (p, vertex->v) intersects the interior of
+ *                   the polygon, locally at the vertex. 0 otherwise
+ */
+int inside(const Common::Point &p, Vertex *vertex) {
+	// Check that it's not a single-vertex polygon
+	if (VERTEX_HAS_EDGES(vertex)) {
+		const Common::Point &prev = CLIST_PREV(vertex)->v;
+		const Common::Point &next = CLIST_NEXT(vertex)->v;
+		const Common::Point &cur = vertex->v;
+
+		if (left(prev, cur, next)) {
+			// Convex vertex, line (p, cur) intersects the inside
+			// if p is located left of both edges
+			if (left(cur, next, p) && left(prev, cur, p))
+				return 1;
+		} else {
+			// Non-convex vertex, line (p, cur) intersects the
+			// inside if p is located left of either edge
+			if (left(cur, next, p) || left(prev, cur, p))
+				return 1;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Determines whether two vertices can see each other, i.e. whether the line
+ * between them doesn't pass through any polygon. This relation is symmetric.
+ * @param s				the pathfinding state
+ * @param vertex_cur	the first vertex
+ * @param vertex		the second vertex
+ * @return true if the vertices are visible from each other
+ */
+static bool is_visible(PathfindingState *s, Vertex *vertex_cur, Vertex *vertex) {
+	// Make sure we don't intersect a polygon locally at the vertices
+	if ((vertex == vertex_cur) || (inside(vertex->v, vertex_cur)) || (inside(vertex_cur->v, vertex)))
+		return false;
+
+	// Check for intersecting edges
+	for (int j = 0; j < s->vertices; j++) {
+		Vertex *edge = s->vertex_index[j];
+		if (VERTEX_HAS_EDGES(edge)) {
+			if (between(vertex_cur->v, vertex->v, edge->v)) {
+				// If we hit a vertex, make sure we can pass through it without intersecting its polygon
+				if ((inside(vertex_cur->v, edge)) || (inside(vertex->v, edge)))
+					return false;
+
+				// This edge won't properly intersect, so we continue
+				continue;
+			}
+
+			if (intersect_proper(vertex_cur->v, vertex->v, edge->v, CLIST_NEXT(edge)->v))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Returns a list of all vertices that are visible from a particular vertex.
+ * Vertices in the closed set of the search are left out, as AStar() has no
+ * use for them.
+ * @param s				the pathfinding state
+ * @param vertex_cur	the vertex
+ * @return list of vertices that are visible from vert
+ */
+static VertexList *visible_vertices(PathfindingState *s, Vertex *vertex_cur) {
+	VertexList *visVerts = new VertexList();
+
+	for (int i = 0; i < s->vertices; i++) {
+		Vertex *vertex = s->vertex_index[i];
+
+		if (vertex->closed)
+			continue;
+
+		bool visible;
+
+		if (s->visibility && vertex_cur->cacheIndex >= 0 && vertex->cacheIndex >= 0) {
+			byte &state = s->visibility[vertex_cur->cacheIndex * s->visibilityStride + vertex->cacheIndex];
+
+			if (state == VIS_UNKNOWN) {
+				state = is_visible(s, vertex_cur, vertex) ? VIS_VISIBLE : VIS_HIDDEN;
+				s->visibility[vertex->cacheIndex * s->visibilityStride + vertex_cur->cacheIndex] = state;
+			}
+
+			visible = (state == VIS_VISIBLE);
+		} else {
+			visible = is_visible(s, vertex_cur, vertex);
+		}
+
+		if (visible)
+			visVerts->push_front(vertex);
+	}
+
+	return visVerts;
+}
+
+/**
+ * Determines if a point lies on the screen border
+ * Parameters: (const Common::Point &) p: The point
+ * Returns   : (int) true if p lies on the screen border, false otherwise
+ */
+bool PathfindingState::pointOnScreenBorder(const Common::Point &p) {
+	return (p.x == 0) || (p.x == _width - 1) || (p.y == 0) || (p.y == _height - 1);
+}
+
+/**
+ * Determines if an edge lies on the screen border
+ * Parameters: (const Common::Point &) p, q: The edge (p, q)
+ * Returns   : (int) true if (p, q) lies on the screen border, false otherwise
+ */
+bool PathfindingState::edgeOnScreenBorder(const Common::Point &p, const Common::Point &q) {
+	return ((p.x == 0 && q.x == 0) || (p.y == 0 && q.y == 0)
+			|| ((p.x == _width - 1) && (q.x == _width - 1))
+			|| ((p.y == _height - 1) && (q.y == _height - 1)));
+}
+
+/**
+ * Searches for a nearby point that is not contained in a polygon
+ * Parameters: (FloatPoint) f: The pointf to search nearby
+ *             (Polygon *) polygon: The polygon
+ * Returns   : (int) PF_OK on success, PF_FATAL otherwise
+ *             (Common::Point) *ret: The non-contained point on success
+ */
+static int find_free_point(FloatPoint f, Polygon *polygon, Common::Point *ret) {
+	Common::Point p;
+
+	// Try nearest point first
+	p = Common::Point((int)floor(f.x + 0.5), (int)floor(f.y + 0.5));
+
+	if (contained(p, polygon) != CONT_INSIDE) {
+		*ret = p;
+		return PF_OK;
+	}
+
+	p = Common::Point((int)floor(f.x), (int)floor(f.y));
+
+	// Try (x, y), (x + 1, y), (x , y + 1) and (x + 1, y + 1)
+	if (contained(p, polygon) == CONT_INSIDE) {
+		p.x++;
+		if (contained(p, polygon) == CONT_INSIDE) {
+			p.y++;
+			if (contained(p, polygon) == CONT_INSIDE) {
+				p.x--;
+				if (contained(p, polygon) == CONT_INSIDE)
+					return PF_FATAL;
+			}
+		}
+	}
+
+	*ret = p;
+	return PF_OK;
+}
+
+/**
+ * Computes the near point of a point contained in a polygon
+ * Parameters: (const Common::Point &) p: The point
+ *             (Polygon *) polygon: The polygon
+ * Returns   : (int) PF_OK on success, PF_FATAL otherwise
+ *             (Common::Point) *ret: The near point of p in polygon on success
+ */
+int PathfindingState::findNearPoint(const Common::Point &p, Polygon *polygon, Common::Point *ret) {
+	Vertex *vertex;
+	FloatPoint near_p;
+	uint32 dist = HUGE_DISTANCE;
+
+	CLIST_FOREACH(vertex, &polygon->vertices) {
+		const Common::Point &p1 = vertex->v;
+		const Common::Point &p2 = CLIST_NEXT(vertex)->v;
+		float u;
+		FloatPoint new_point;
+		uint32 new_dist;
+
+		// Ignore edges on the screen border, except for contained access polygons
+		if ((polygon->type != POLY_CONTAINED_ACCESS) && (edgeOnScreenBorder(p1, p2)))
+			continue;
+
+		// Compute near point
+		u = ((p.x - p1.x) * (p2.x - p1.x) + (p.y - p1.y) * (p2.y - p1.y)) / (float)p1.sqrDist(p2);
+
+		// Clip to edge
+		if (u < 0.0f)
+			u = 0.0f;
+		if (u > 1.0f)
+			u = 1.0f;
+
+		new_point.x = p1.x + u * (p2.x - p1.x);
+		new_point.y = p1.y + u * (p2.y - p1.y);
+
+		new_dist = p.sqrDist(new_point.toPoint());
+
+		if (new_dist < dist) {
+			near_p = new_point;
+			dist = new_dist;
+		}
+	}
+
+	// Find point not contained in polygon
+	return find_free_point(near_p, polygon, ret);
+}
+
+/**
+ * Computes the intersection point of a line segment and an edge (not
+ * including the vertices themselves)
+ * Parameters: (const Common::Point &) a, b: The line segment (a, b)
+ *             (Vertex *) vertex: The first vertex of the edge
+ * Returns   : (int) FP_OK on success, PF_ERROR otherwise
+ *             (FloatPoint) *ret: The intersection point
+ */
+static int intersection(const Common::Point &a, const Common::Point &b, Vertex *vertex, FloatPoint *ret) {
+	// Parameters of parametric equations
+	float s, t;
+	// Numerator and denominator of equations
+	float num, denom;
+	const Common::Point &c = vertex->v;
+	const Common::Point &d = CLIST_NEXT(vertex)->v;
+
+	denom = a.x * (float)(d.y - c.y) + b.x * (float)(c.y - d.y) +
+	        d.x * (float)(b.y - a.y) + c.x * (float)(a.y - b.y);
+
+	if (denom == 0.0)
+		// Segments are parallel, no intersection
+		return PF_ERROR;
+
+	num = a.x * (float)(d.y - c.y) + c.x * (float)(a.y - d.y) + d.x * (float)(c.y - a.y);
+
+	s = num / denom;
+
+	num = -(a.x * (float)(c.y - b.y) + b.x * (float)(a.y - c.y) + c.x * (float)(b.y - a.y));
+
+	t = num / denom;
+
+	if ((0.0 <= s) && (s <= 1.0) && (0.0 < t) && (t < 1.0)) {
+		// Intersection found
+		ret->x = a.x + s * (b.x - a.x);
+		ret->y = a.y + s * (b.y - a.y);
+		return PF_OK;
+	}
+
+	return PF_ERROR;
+}
+
+/**
+ * Computes the nearest intersection point of a line segment and the polygon
+ * set. Intersection points that are reached from the inside of a polygon
+ * are ignored as are improper intersections which do not obstruct
+ * visibility
+ * Parameters: (PathfindingState *) s: The pathfinding state
+ *             (const Common::Point &) p, q: The line segment (p, q)
+ * Returns   : (int) PF_OK on success, PF_ERROR when no intersections were
+ *                   found, PF_FATAL otherwise
+ *             (Common::Point) *ret: On success, the closest intersection point
+ */
+int nearest_intersection(PathfindingState *s, const Common::Point &p, const Common::Point &q, Common::Point *ret) {
+	Polygon *polygon = 0;
+	FloatPoint isec;
+	Polygon *ipolygon = 0;
+	uint32 dist = HUGE_DISTANCE;
+
+	for (PolygonList::iterator it = s->polygons.begin(); it != s->polygons.end(); ++it) {
+		polygon = *it;
+		Vertex *vertex;
+
+		CLIST_FOREACH(vertex, &polygon->vertices) {
+			uint32 new_dist;
+			FloatPoint new_isec;
+
+			// Check for intersection with vertex
+			if (between(p, q, vertex->v)) {
+				// Skip this vertex if we hit it from the
+				// inside of the polygon
+				if (inside(q, vertex)) {
+					new_isec.x = vertex->v.x;
+					new_isec.y = vertex->v.y;
+				} else
+					continue;
+			} else {
+				// Check for intersection with edges
+
+				// Skip this edge if we hit it from the
+				// inside of the polygon
+				if (!left(vertex->v, CLIST_NEXT(vertex)->v, q))
+					continue;
+
+				if (intersection(p, q, vertex, &new_isec) != PF_OK)
+					continue;
+			}
+
+			new_dist = p.sqrDist(new_isec.toPoint());
+			if (new_dist < dist) {
+				ipolygon = polygon;
+				isec = new_isec;
+				dist = new_dist;
+			}
+		}
+	}
+
+	if (dist == HUGE_DISTANCE)
+		return PF_ERROR;
+
+	// Find point not contained in polygon
+	return find_free_point(isec, ipolygon, ret);
+}
+
+/**
+ * Checks whether a point is nearby a contained-access polygon (distance 1 pixel)
+ * @param point			the point
+ * @param polygon		the contained-access polygon
+ * @return true when point is nearby polygon, false otherwise
+ */
+static bool nearbyPolygon(const Common::Point &point, Polygon *polygon) {
+	assert(polygon->type == POLY_CONTAINED_ACCESS);
+
+	return ((contained(Common::Point(point.x, point.y + 1), polygon) != CONT_INSIDE)
+			|| (contained(Common::Point(point.x, point.y - 1), polygon) != CONT_INSIDE)
+			|| (contained(Common::Point(point.x + 1, point.y), polygon) != CONT_INSIDE)
+			|| (contained(Common::Point(point.x - 1, point.y), polygon) != CONT_INSIDE));
+}
+
+/**
+ * Checks that the start point is in a valid position, and takes appropriate action if it's not.
+ * @param s				the pathfinding state
+ * @param start			the start point
+ * @return a valid start point on success, NULL otherwise
+ */
+Common::Point *fixup_start_point(PathfindingState *s, const Common::Point &start) {
+	PolygonList::iterator it = s->polygons.begin();
+	Common::Point *new_start = new Common::Point(start);
+
+	while (it != s->polygons.end()) {
+		int cont = contained(start, *it);
+		int type = (*it)->type;
+
+		switch (type) {
+		case POLY_TOTAL_ACCESS:
+			// Remove totally accessible polygons that contain the start point
+			if (cont != CONT_OUTSIDE) {
+				delete *it;
+				it = s->polygons.erase(it);
+				continue;
+			}
+			break;
+		case POLY_CONTAINED_ACCESS:
+			// Remove contained access polygons that do not contain
+			// the start point (containment test is inverted here).
+			// SSCI appears to be using a small margin of error here,
+			// so we do the same.
+			if ((cont == CONT_INSIDE) && !nearbyPolygon(start, *it)) {
+				delete *it;
+				it = s->polygons.erase(it);
+				continue;
+			}
+			// Fall through
+		case POLY_BARRED_ACCESS:
+		case POLY_NEAREST_ACCESS:
+			if (cont != CONT_OUTSIDE) {
+				if (s->_prependPoint != NULL) {
+					// We shouldn't get here twice.
+					// We need to break in this case, otherwise we'll end in an infinite
+					// loop.
+					warning("AvoidPath: start point is contained in multiple polygons");
+					break;
+				}
+
+				if (s->findNearPoint(start, (*it), new_start) != PF_OK) {
+					delete new_start;
+					return NULL;
+				}
+
+				if ((type == POLY_BARRED_ACCESS) || (type == POLY_CONTAINED_ACCESS))
+					debugC(kDebugLevelAvoidPath, "AvoidPath: start position at unreachable location");
+
+				// The original start position is in an invalid location, so we
+				// use the moved point and add the original one to the final path
+				// later on.
+				if (start != *new_start)
+					s->_prependPoint = new Common::Point(start);
+			}
+		}
+
+		++it;
+	}
+
+	return new_start;
+}
+
+/**
+ * Checks that the end point is in a valid position, and takes appropriate action if it's not.
+ * @param s				the pathfinding state
+ * @param end			the end point
+ * @return a valid end point on success, NULL otherwise
+ */
+Common::Point *fixup_end_point(PathfindingState *s, const Common::Point &end) {
+	PolygonList::iterator it = s->polygons.begin();
+	Common::Point *new_end = new Common::Point(end);
+
+	while (it != s->polygons.end()) {
+		int cont = contained(end, *it);
+		int type = (*it)->type;
+
+		switch (type) {
+		case POLY_TOTAL_ACCESS:
+			// Remove totally accessible polygons that contain the end point
+			if (cont != CONT_OUTSIDE) {
+				delete *it;
+				it = s->polygons.erase(it);
+				continue;
+			}
+			break;
+		case POLY_CONTAINED_ACCESS:
+		case POLY_BARRED_ACCESS:
+		case POLY_NEAREST_ACCESS:
+			if (cont != CONT_OUTSIDE) {
+				if (s->_appendPoint != NULL) {
+					// We shouldn't get here twice.
+					// Happens in LB2CD, inside the speakeasy when walking from the
+					// speakeasy (room 310) into the bathroom (room 320), after having
+					// consulted the notebook (bug #3036299).
+					// We need to break in this case, otherwise we'll end in an infinite
+					// loop.
+					warning("AvoidPath: end point is contained in multiple polygons");
+					break;
+				}
+
+				// The original end position is in an invalid location, so we move the point
+				if (s->findNearPoint(end, (*it), new_end) != PF_OK) {
+					delete new_end;
+					return NULL;
+				}
+
+				// For near-point access polygons we need to add the original end point
+				// to the path after pathfinding.
+				if ((type == POLY_NEAREST_ACCESS) && (end != *new_end))
+					s->_appendPoint = new Common::Point(end);
+			}
+		}
+
+		++it;
+	}
+
+	return new_end;
+}
+
+/**
+ * Merges a point into the polygon set. A new vertex is allocated for this
+ * point, unless a matching vertex already exists. If the point is on an
+ * already existing edge that edge is split up into two edges connected by
+ * the new vertex
+ * Parameters: (PathfindingState *) s: The pathfinding state
+ *             (const Common::Point &) v: The point to merge
+ * Returns   : (Vertex *) The vertex corresponding to v
+ */
+static Vertex *merge_point(PathfindingState *s, const Common::Point &v) {
+	Vertex *vertex;
+	Vertex *v_new;
+	Polygon *polygon;
+
+	// Check for already existing vertex
+	for (PolygonList::iterator it = s->polygons.begin(); it != s->polygons.end(); ++it) {
+		polygon = *it;
+		CLIST_FOREACH(vertex, &polygon->vertices) {
+			if (vertex->v == v)
+				return vertex;
+		}
+	}
+
+	v_new = new Vertex(v);
+
+	// Check for point being on an edge
+	for (PolygonList::iterator it = s->polygons.begin(); it != s->polygons.end(); ++it) {
+		polygon = *it;
+		// Skip single-vertex polygons
+		if (VERTEX_HAS_EDGES(polygon->vertices.first())) {
+			CLIST_FOREACH(vertex, &polygon->vertices) {
+				Vertex *next = CLIST_NEXT(vertex);
+
+				if (between(vertex->v, next->v, v)) {
+					// Split edge by adding vertex
+					polygon->vertices.insertAfter(vertex, v_new);
+					return v_new;
+				}
+			}
+		}
+	}
+
+	// Add point as single-vertex polygon
+	polygon = new Polygon(POLY_BARRED_ACCESS);
+	polygon->vertices.insertHead(v_new);
+	s->polygons.push_front(polygon);
+
+	return v_new;
+}
+
+/**
+ * Changes the polygon list for optimization level 0 (used for keyboard
+ * support). Totally accessible polygons are removed and near-point
+ * accessible polygons are changed into totally accessible polygons.
+ * Parameters: (PathfindingState *) s: The pathfinding state
+ */
+void change_polygons_opt_0(PathfindingState *s) {
+
+	PolygonList::iterator it = s->polygons.begin();
+	while (it != s->polygons.end()) {
+		Polygon *polygon = *it;
+		assert(polygon);
+
+		if (polygon->type == POLY_TOTAL_ACCESS) {
+			delete polygon;
+			it = s->polygons.erase(it);
+		} else {
+			if (polygon->type == POLY_NEAREST_ACCESS)
+				polygon->type = POLY_TOTAL_ACCESS;
+			++it;
+		}
+	}
+}
+
+/**
+ * Sets up the visibility cache for the polygon set of a pathfinding state.
+ * The cached visibility is kept if the polygons match those of the previous
+ * call, otherwise the cache is reset. Should be called before the start and
+ * end points are merged into the polygon set.
+ * Parameters: (PathfindingState *) pf_s: The pathfinding state
+ *             (Common::Array<int16> &) cachedPolygons: The polygon set the
+ *                   cache was built for
+ *             (Common::Array<byte> &) cachedVisibility: The cached visibility
+ */
+static void setup_visibility_cache(PathfindingState *pf_s, Common::Array<int16> &cachedPolygons, Common::Array<byte> &cachedVisibility) {
+	Common::Array<int16> polygons;
+	int count = 0;
+
+	// Visibility only depends on the vertices and how they are connected,
+	// so the polygon types aren't part of the key
+	for (PolygonList::iterator it = pf_s->polygons.begin(); it != pf_s->polygons.end(); ++it) {
+		Vertex *vertex;
+
+		polygons.push_back((*it)->vertices.size());
+		CLIST_FOREACH(vertex, &(*it)->vertices) {
+			polygons.push_back(vertex->v.x);
+			polygons.push_back(vertex->v.y);
+			vertex->cacheIndex = count++;
+		}
+	}
+
+	if (polygons != cachedPolygons) {
+		cachedPolygons = polygons;
+		cachedVisibility.clear();
+		cachedVisibility.resize(count * count);
+		if (count > 0)
+			memset(cachedVisibility.begin(), VIS_UNKNOWN, count * count);
+	}
+
+	if (count > 0) {
+		pf_s->visibility = cachedVisibility.begin();
+		pf_s->visibilityStride = count;
+	}
+}
+
+/**
+ * Merges the start and end points into the polygon set of a pathfinding
+ * state and builds the vertex index, after which AStar() can be run
+ * Parameters: (PathfindingState *) s: The pathfinding state
+ *             (const Common::Point &) start: The start point
+ *             (const Common::Point &) end: The end point
+ *             (Common::Array<int16> &) cachedPolygons,
+ *             (Common::Array<byte> &) cachedVisibility: The visibility cache,
+ *                   see setup_visibility_cache()
+ */
+void setup_search(PathfindingState *s, const Common::Point &start, const Common::Point &end,
+	Common::Array<int16> &cachedPolygons, Common::Array<byte> &cachedVisibility) {
+	setup_visibility_cache(s, cachedPolygons, cachedVisibility);
+
+	// Merge start and end points into polygon set
+	s->vertex_start = merge_point(s, start);
+	s->vertex_end = merge_point(s, end);
+
+	// A point that splits an existing edge changes the shape of its
+	// polygon, so the cached visibility can't be used in that case
+	if ((s->vertex_start->cacheIndex < 0 && VERTEX_HAS_EDGES(s->vertex_start))
+		|| (s->vertex_end->cacheIndex < 0 && VERTEX_HAS_EDGES(s->vertex_end)))
+		s->visibility = NULL;
+
+	int count = 0;
+
+	for (PolygonList::iterator it = s->polygons.begin(); it != s->polygons.end(); ++it)
+		count += (*it)->vertices.size();
+
+	// Allocate and build vertex index
+	s->vertex_index = (Vertex**)malloc(sizeof(Vertex *) * count);
+
+	count = 0;
+
+	for (PolygonList::iterator it = s->polygons.begin(); it != s->polygons.end(); ++it) {
+		Polygon *polygon = *it;
+		Vertex *vertex;
+
+		CLIST_FOREACH(vertex, &polygon->vertices) {
+			s->vertex_index[count++] = vertex;
+		}
+	}
+
+	s->vertices = count;
+}
+
+/**
+ * Open set of the A* search, kept as a binary heap ordered by F cost. Costs
+ * only ever decrease, so instead of updating a vertex in place, it is pushed
+ * again and outdated entries are skipped when they come up.
+ *
+ * Ties are broken in favor of the vertex that entered the open set last,
+ * which matches the order in which the original linear search through a list
+ * of open vertices picked them, and with that the resulting paths.
+ */
+class OpenSet {
+public:
+	OpenSet() : _size(0), _order(0) {}
+
+	bool empty() const {
+		return _size == 0;
+	}
+
+	/**
+	 * Adds a vertex to the open set, or updates its position after its
+	 * F cost has decreased.
+	 */
+	void push(Vertex *vertex) {
+		if (vertex->openOrder == 0) {
+			vertex->openOrder = ++_order;
+			++_size;
+		}
+
+		Entry entry;
+		entry.costF = vertex->costF;
+		entry.order = vertex->openOrder;
+		entry.vertex = vertex;
+
+		uint pos = _heap.size();
+		_heap.push_back(entry);
+
+		while (pos > 0) {
+			uint parent = (pos - 1) / 2;
+			if (!isBetter(entry, _heap[parent]))
+				break;
+			_heap[pos] = _heap[parent];
+			pos = parent;
+		}
+
+		_heap[pos] = entry;
+	}
+
+	/**
+	 * Returns the vertex with the lowest F cost without removing it.
+	 */
+	Vertex *top() {
+		// Drop entries of vertices that have been closed or pushed again since
+		while (_heap[0].vertex->closed || _heap[0].costF != _heap[0].vertex->costF)
+			popEntry();
+
+		return _heap[0].vertex;
+	}
+
+	/**
+	 * Removes the vertex returned by top() from the open set.
+	 */
+	void pop() {
+		popEntry();
+		--_size;
+	}
+
+private:
+	struct Entry {
+		uint32 costF;
+		uint order;
+		Vertex *vertex;
+	};
+
+	static bool isBetter(const Entry &a, const Entry &b) {
+		return (a.costF < b.costF) || ((a.costF == b.costF) && (a.order > b.order));
+	}
+
+	void popEntry() {
+		Entry entry = _heap.back();
+		_heap.pop_back();
+
+		const uint size = _heap.size();
+
+		if (size == 0)
+			return;
+
+		uint pos = 0;
+
+		while (true) {
+			uint child = pos * 2 + 1;
+			if (child >= size)
+				break;
+			if ((child + 1 < size) && isBetter(_heap[child + 1], _heap[child]))
+				++child;
+			if (!isBetter(_heap[child], entry))
+				break;
+			_heap[pos] = _heap[child];
+			pos = child;
+		}
+
+		_heap[pos] = entry;
+	}
+
+	Common::Array<Entry> _heap;
+	uint _size;
+	uint _order;
+};
+
+/**
+ * Computes a shortest path from vertex_start to vertex_end. The caller can
+ * construct the resulting path by following the path_prev links from
+ * vertex_end back to vertex_start. If no path exists vertex_end->path_prev
+ * will be NULL
+ * Parameters: (PathfindingState *) s: The pathfinding state
+ */
+void AStar(PathfindingState *s) {
+	// The remaining vertices. Vertices of which the shortest path is known
+	// are marked as closed.
+	OpenSet openSet;
+
+	s->vertex_start->costG = 0;
+	s->vertex_start->costF = (uint32)sqrt((float)s->vertex_start->v.sqrDist(s->vertex_end->v));
+	openSet.push(s->vertex_start);
+
+	while (!openSet.empty()) {
+		// Find vertex in open set with lowest F cost
+		Vertex *vertex_min = openSet.top();
+
+		// Check if we are done
+		if (vertex_min == s->vertex_end)
+			break;
+
+		// Move vertex from set open to set closed
+		openSet.pop();
+		vertex_min->closed = true;
+
+		VertexList *visVerts = visible_vertices(s, vertex_min);
+
+		for (VertexList::iterator it = visVerts->begin(); it != visVerts->end(); ++it) {
+			uint32 new_dist;
+			Vertex *vertex = *it;
+
+			new_dist = vertex_min->costG + (uint32)sqrt((float)vertex_min->v.sqrDist(vertex->v));
+
+			// When travelling to a vertex on the screen edge, we
+			// add a penalty score to make this path less appealing.
+			// NOTE: If an obstacle has only one vertex on a screen edge,
+			// later SSCI pathfinders will treat that vertex like any
+			// other, while we apply a penalty to paths traversing it.
+			// This difference might lead to problems, but none are
+			// known at the time of writing.
+			if (s->pointOnScreenBorder(vertex->v))
+				new_dist += 10000;
+
+			if (new_dist < vertex->costG) {
+				vertex->costG = new_dist;
+				vertex->costF = vertex->costG + (uint32)sqrt((float)vertex->v.sqrDist(s->vertex_end->v));
+				vertex->path_prev = vertex_min;
+				openSet.push(vertex);
+			}
+		}
+
+		delete visVerts;
+	}
+
+	if (openSet.empty())
+		debugC(kDebugLevelAvoidPath, "AvoidPath: End point (%i, %i) is unreachable", s->vertex_end->v.x, s->vertex_end->v.y);
+}
+
+} // End of namespace Sci
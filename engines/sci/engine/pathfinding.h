@@ -0,0 +1,266 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef SCI_ENGINE_PATHFINDING_H
+#define SCI_ENGINE_PATHFINDING_H
+
+#include "common/array.h"
+#include "common/list.h"
+#include "common/rect.h"
+
+namespace Sci {
+
+// SCI-defined polygon types
+enum {
+	POLY_TOTAL_ACCESS = 0,
+	POLY_NEAREST_ACCESS = 1,
+	POLY_BARRED_ACCESS = 2,
+	POLY_CONTAINED_ACCESS = 3
+};
+
+// Polygon containment types
+enum {
+	CONT_OUTSIDE = 0,
+	CONT_ON_EDGE = 1,
+	CONT_INSIDE = 2
+};
+
+#define HUGE_DISTANCE 0xFFFFFFFF
+
+#define VERTEX_HAS_EDGES(V) ((V) != CLIST_NEXT(V))
+
+// Error codes
+enum {
+	PF_OK = 0,
+	PF_ERROR = -1,
+	PF_FATAL = -2
+};
+
+struct Vertex {
+	// Location
+	Common::Point v;
+
+	// Vertex circular list entry
+	Vertex *_next;	// next element
+	Vertex *_prev;	// previous element
+
+	// A* cost variables
+	uint32 costF;
+	uint32 costG;
+
+	// Previous vertex in shortest path
+	Vertex *path_prev;
+
+	// A* open/closed set membership. openOrder is the 1-based order in which
+	// the vertex entered the open set, or 0 if it never did
+	uint openOrder;
+	bool closed;
+
+	// Index in the visibility cache, or -1 if this vertex was added to the
+	// polygon set after the cache was set up
+	int cacheIndex;
+
+public:
+	Vertex(const Common::Point &p) : v(p) {
+		costG = HUGE_DISTANCE;
+		path_prev = NULL;
+		openOrder = 0;
+		closed = false;
+		cacheIndex = -1;
+	}
+};
+
+typedef Common::List<Vertex *> VertexList;
+
+/* Circular list definitions. */
+
+#define CLIST_FOREACH(var, head)					\
+	for ((var) = (head)->first();					\
+		(var);							\
+		(var) = ((var)->_next == (head)->first() ?	\
+		    NULL : (var)->_next))
+
+/* Circular list access methods. */
+#define CLIST_NEXT(elm)		((elm)->_next)
+#define CLIST_PREV(elm)		((elm)->_prev)
+
+class CircularVertexList {
+public:
+	Vertex *_head;
+
+public:
+	CircularVertexList() : _head(0) {}
+
+	Vertex *first() const {
+		return _head;
+	}
+
+	void insertHead(Vertex *elm) {
+		if (_head == NULL) {
+			elm->_next = elm->_prev = elm;
+		} else {
+			elm->_next = _head;
+			elm->_prev = _head->_prev;
+			_head->_prev = elm;
+			elm->_prev->_next = elm;
+		}
+		_head = elm;
+	}
+
+	static void insertAfter(Vertex *listelm, Vertex *elm) {
+		elm->_prev = listelm;
+		elm->_next = listelm->_next;
+		listelm->_next->_prev = elm;
+		listelm->_next = elm;
+	}
+
+	void remove(Vertex *elm) {
+		if (elm->_next == elm) {
+			_head = NULL;
+		} else {
+			if (_head == elm)
+				_head = elm->_next;
+			elm->_prev->_next = elm->_next;
+			elm->_next->_prev = elm->_prev;
+		}
+	}
+
+	bool empty() const {
+		return _head == NULL;
+	}
+
+	uint size() const {
+		int n = 0;
+		Vertex *v;
+		CLIST_FOREACH(v, this)
+			++n;
+		return n;
+	}
+
+	/**
+	 * Reverse the order of the elements in this circular list.
+	 */
+	void reverse() {
+		if (!_head)
+			return;
+
+		Vertex *elm = _head;
+		do {
+			SWAP(elm->_prev, elm->_next);
+			elm = elm->_next;
+		} while (elm != _head);
+	}
+};
+
+struct Polygon {
+	// SCI polygon type
+	int type;
+
+	// Circular list of vertices
+	CircularVertexList vertices;
+
+public:
+	Polygon(int t) : type(t) {
+	}
+
+	~Polygon() {
+		while (!vertices.empty()) {
+			Vertex *vertex = vertices.first();
+			vertices.remove(vertex);
+			delete vertex;
+		}
+	}
+};
+
+typedef Common::List<Polygon *> PolygonList;
+
+// Pathfinding state
+struct PathfindingState {
+	// List of all polygons
+	PolygonList polygons;
+
+	// Start and end points for pathfinding
+	Vertex *vertex_start, *vertex_end;
+
+	// Array of all vertices, used for sorting
+	Vertex **vertex_index;
+
+	// Total number of vertices
+	int vertices;
+
+	// Visibility cache, see VisibilityState. NULL if it can't be used
+	byte *visibility;
+	int visibilityStride;
+
+	// Point to prepend and append to final path
+	Common::Point *_prependPoint;
+	Common::Point *_appendPoint;
+
+	// Screen size
+	int _width, _height;
+
+	PathfindingState(int width, int height) : _width(width), _height(height) {
+		vertex_start = NULL;
+		vertex_end = NULL;
+		vertex_index = NULL;
+		_prependPoint = NULL;
+		_appendPoint = NULL;
+		vertices = 0;
+		visibility = NULL;
+		visibilityStride = 0;
+	}
+
+	~PathfindingState() {
+		free(vertex_index);
+
+		delete _prependPoint;
+		delete _appendPoint;
+
+		for (PolygonList::iterator it = polygons.begin(); it != polygons.end(); ++it) {
+			delete *it;
+		}
+	}
+
+	bool pointOnScreenBorder(const Common::Point &p);
+	bool edgeOnScreenBorder(const Common::Point &p, const Common::Point &q);
+	int findNearPoint(const Common::Point &p, Polygon *polygon, Common::Point *ret);
+};
+
+// Pathfinding on a polygon set, as used by kAvoidPath. This doesn't depend
+// on the rest of the engine, see the comments in pathfinding.cpp for details.
+
+int contained(const Common::Point &p, Polygon *polygon);
+void fix_vertex_order(Polygon *polygon);
+bool between(const Common::Point &a, const Common::Point &b, const Common::Point &c);
+bool intersect_proper(const Common::Point &a, const Common::Point &b, const Common::Point &c, const Common::Point &d);
+int inside(const Common::Point &p, Vertex *vertex);
+int nearest_intersection(PathfindingState *s, const Common::Point &p, const Common::Point &q, Common::Point *ret);
+Common::Point *fixup_start_point(PathfindingState *s, const Common::Point &start);
+Common::Point *fixup_end_point(PathfindingState *s, const Common::Point &end);
+void change_polygons_opt_0(PathfindingState *s);
+void setup_search(PathfindingState *s, const Common::Point &start, const Common::Point &end,
+	Common::Array<int16> &cachedPolygons, Common::Array<byte> &cachedVisibility);
+void AStar(PathfindingState *s);
+
+} // End of namespace Sci
+
+#endif // SCI_ENGINE_PATHFINDING_H
@@ -43,6 +43,9 @@ SegManager::SegManager(ResourceManager *resMan) {
 
 	_resMan = resMan;
 
+	_selectorLookupHits = 0;
+	_selectorLookupMisses = 0;
+
 	createClassTable();
 }
 
@@ -51,6 +54,8 @@ SegManager::~SegManager() {
 }
 
 void SegManager::resetSegMan() {
+	_gc.abortSweep();
+
 	// Free memory
 	for (uint i = 0; i < _heap.size(); i++) {
 		if (_heap[i])
@@ -75,6 +80,8 @@ void SegManager::resetSegMan() {
 	// Reinitialize class table
 	_classTable.clear();
 	createClassTable();
+
+	invalidateSelectorCache();
 }
 
 void SegManager::initSysStrings() {
@@ -122,6 +129,10 @@ SegmentObj *SegManager::allocSegment(SegmentObj *mem, SegmentId *segid) {
 	}
 	_heap[id] = mem;
 
+	// The last mark didn't see this segment, keep it from being swept
+	if (_gc.isSweeping())
+		_gc.newSegments.push_back(id);
+
 	return mem;
 }
 
@@ -153,6 +164,13 @@ void SegManager::deallocate(SegmentId seg) {
 		_scriptSegMap.erase(scr->getScriptNumber());
 		if (scr->getLocalsSegment())
 			deallocate(scr->getLocalsSegment());
+		invalidateSelectorCache();
+	}
+
+	// Don't let a sweep in progress continue on a freed segment
+	if (_gc.isSweeping() && seg == _gc.sweepSegment) {
+		_gc.sweepList.clear();
+		_gc.sweepPos = 0;
 	}
 
 	delete mobj;
@@ -385,6 +403,7 @@ reg_t SegManager::allocateHunkEntry(const char *hunk_type, int size) {
 	offset = table->allocEntry();
 
 	reg_t addr = make_reg(_hunksSegId, offset);
+	gcAllocated(addr);
 	Hunk *h = &(table->_table[offset]);
 
 	if (!h)
@@ -420,6 +439,7 @@ Clone *SegManager::allocateClone(reg_t *addr) {
 	offset = table->allocEntry();
 
 	*addr = make_reg(_clonesSegId, offset);
+	gcAllocated(*addr);
 	return &(table->_table[offset]);
 }
 
@@ -434,6 +454,7 @@ List *SegManager::allocateList(reg_t *addr) {
 	offset = table->allocEntry();
 
 	*addr = make_reg(_listsSegId, offset);
+	gcAllocated(*addr);
 	return &(table->_table[offset]);
 }
 
@@ -448,6 +469,7 @@ Node *SegManager::allocateNode(reg_t *addr) {
 	offset = table->allocEntry();
 
 	*addr = make_reg(_nodesSegId, offset);
+	gcAllocated(*addr);
 	return &(table->_table[offset]);
 }
 
@@ -850,6 +872,7 @@ SciArray<reg_t> *SegManager::allocateArray(reg_t *addr) {
 	offset = table->allocEntry();
 
 	*addr = make_reg(_arraysSegId, offset);
+	gcAllocated(*addr);
 	return &(table->_table[offset]);
 }
 
@@ -890,6 +913,7 @@ SciString *SegManager::allocateString(reg_t *addr) {
 	offset = table->allocEntry();
 
 	*addr = make_reg(_stringSegId, offset);
+	gcAllocated(*addr);
 	return &(table->_table[offset]);
 }
 
@@ -977,12 +1001,19 @@ int SegManager::instantiateScript(int scriptNum) {
 		scr = allocateScript(scriptNum, &segmentId);
 	}
 
+	// Objects of the new script may reuse the addresses of a previously
+	// freed one
+	invalidateSelectorCache();
+
 	scr->init(scriptNum, _resMan);
 	scr->load(_resMan);
 	scr->initializeLocals(this);
 	scr->initializeClasses(this);
 	scr->initializeObjects(this, segmentId);
 
+	// Drop anything cached while the objects were only partially set up
+	invalidateSelectorCache();
+
 	return segmentId;
 }
 
@@ -1017,6 +1048,33 @@ void SegManager::uninstantiateScript(int script_nr) {
 	}
 }
 
+const SelectorLookupEntry *SegManager::getSelectorCacheEntry(reg_t obj, Selector selector) {
+	SelectorLookupKey key;
+	key.obj = obj;
+	key.selector = selector;
+
+	SelectorLookupCache::const_iterator it = _selectorLookupCache.find(key);
+	if (it == _selectorLookupCache.end()) {
+		_selectorLookupMisses++;
+		return NULL;
+	}
+
+	_selectorLookupHits++;
+	return &it->_value;
+}
+
+void SegManager::setSelectorCacheEntry(reg_t obj, Selector selector, const SelectorLookupEntry &entry) {
+	SelectorLookupKey key;
+	key.obj = obj;
+	key.selector = selector;
+
+	_selectorLookupCache[key] = entry;
+}
+
+void SegManager::invalidateSelectorCache() {
+	_selectorLookupCache.clear(true);
+}
+
 void SegManager::uninstantiateScriptSci0(int script_nr) {
 	bool oldScriptHeader = (getSciVersion() == SCI_VERSION_0_EARLY);
 	SegmentId segmentId = getScriptSegment(script_nr);
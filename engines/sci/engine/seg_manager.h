@@ -43,6 +43,97 @@ enum ScriptLoadType {
 
 class Script;
 
+/**
+ * Result of a lookupSelector() call, as kept in the selector cache of the
+ * SegManager.
+ */
+struct SelectorLookupEntry {
+	SelectorType type;
+	int varIndex;	/**< Index of the variable, if type is kSelectorVariable */
+	reg_t funcAddr;	/**< Address of the method, if type is kSelectorMethod */
+};
+
+struct SelectorLookupKey {
+	reg_t obj;	/**< The object's base position, i.e. the cloned object for clones */
+	Selector selector;
+
+	bool operator==(const SelectorLookupKey &x) const {
+		return obj == x.obj && selector == x.selector;
+	}
+};
+
+struct SelectorLookupKey_Hash {
+	uint operator()(const SelectorLookupKey &x) const {
+		return (x.obj.segment << 3) ^ x.obj.offset ^ (x.obj.offset << 16) ^ (x.selector << 7);
+	}
+};
+
+typedef Common::HashMap<SelectorLookupKey, SelectorLookupEntry, SelectorLookupKey_Hash> SelectorLookupCache;
+
+struct reg_t_Hash {
+	uint operator()(const reg_t& x) const {
+		return (x.segment << 3) ^ x.offset ^ (x.offset << 16);
+	}
+};
+
+/*
+ * The AddrSet is a "set" of reg_t values.
+ * We don't have a HashSet type, so we abuse a HashMap for this.
+ */
+typedef Common::HashMap<reg_t, bool, reg_t_Hash> AddrSet;
+
+/**
+ * State of the garbage collector. Garbage is swept in bounded steps after
+ * each mark, see run_gc_step(), so the SegManager has to tell the collector
+ * about everything allocated while a sweep is in progress.
+ */
+struct GCState {
+	AddrSet *reachable;	/**< Canonic addresses found by the last mark, NULL if no sweep is in progress */
+	SegmentId sweepSegment;	/**< Segment currently being swept */
+	SegmentId sweepEnd;	/**< Number of segments at the time of the mark */
+	Common::Array<reg_t> sweepList;	/**< Deallocatable addresses of sweepSegment */
+	uint sweepPos;	/**< Next entry of sweepList to check */
+	Common::Array<SegmentId> newSegments;	/**< Segments allocated since the mark */
+
+	// Statistics, all times in milliseconds
+	uint32 collections;	/**< Number of finished collections */
+	uint32 lastMarkTime;
+	uint32 maxMarkTime;
+	uint32 totalMarkTime;
+	uint32 sweepSteps;
+	uint32 lastSweepTime;	/**< Total sweep time of the last collection */
+	uint32 maxSweepStepTime;
+	uint32 lastFreed;	/**< Objects freed by the last collection */
+	uint32 totalFreed;
+
+	GCState() : reachable(0), sweepSegment(0), sweepEnd(0), sweepPos(0) {
+		resetStats();
+	}
+
+	~GCState() {
+		delete reachable;
+	}
+
+	bool isSweeping() const { return reachable != 0; }
+
+	/**
+	 * Drops a sweep in progress, e.g. because the heap is about to be replaced.
+	 */
+	void abortSweep() {
+		delete reachable;
+		reachable = 0;
+		sweepList.clear();
+		newSegments.clear();
+	}
+
+	void resetStats() {
+		collections = 0;
+		lastMarkTime = maxMarkTime = totalMarkTime = 0;
+		sweepSteps = lastSweepTime = maxSweepStepTime = 0;
+		lastFreed = totalFreed = 0;
+	}
+};
+
 class SegManager : public Common::Serializable {
 	friend class Console;
 public:
@@ -441,6 +532,49 @@ public:
 
 	const Common::Array<SegmentObj *> &getSegments() const { return _heap; }
 
+	// Selector lookup cache
+
+	/**
+	 * Looks up the cached result of resolving a selector on an object.
+	 * Variable and method positions only depend on the script data the
+	 * object was instantiated from, so clones share the entries of the
+	 * object they were cloned from.
+	 * @param obj			the object's base position (Object::getPos())
+	 * @param selector		the selector to look up
+	 * @return				the cached entry, or NULL if there is none
+	 */
+	const SelectorLookupEntry *getSelectorCacheEntry(reg_t obj, Selector selector);
+
+	/**
+	 * Stores the result of resolving a selector on an object.
+	 */
+	void setSelectorCacheEntry(reg_t obj, Selector selector, const SelectorLookupEntry &entry);
+
+	/**
+	 * Drops all cached selector lookups. Called whenever scripts get
+	 * loaded or freed, as that invalidates the cached addresses.
+	 */
+	void invalidateSelectorCache();
+
+	uint32 getSelectorCacheHits() const { return _selectorLookupHits; }
+	uint32 getSelectorCacheMisses() const { return _selectorLookupMisses; }
+	uint32 getSelectorCacheSize() const { return _selectorLookupCache.size(); }
+	void resetSelectorCacheStats() { _selectorLookupHits = _selectorLookupMisses = 0; }
+
+	// Garbage collection
+
+	GCState &getGCState() { return _gc; }
+
+private:
+	/**
+	 * Keeps a newly allocated object from being freed by a sweep that is in
+	 * progress, as the mark that preceded the sweep didn't know about it.
+	 */
+	void gcAllocated(reg_t addr) {
+		if (_gc.reachable)
+			_gc.reachable->setVal(addr, true);
+	}
+
 private:
 	Common::Array<SegmentObj *> _heap;
 	Common::Array<Class> _classTable; /**< Table of all classes */
@@ -454,6 +588,12 @@ private:
 	SegmentId _nodesSegId; ///< ID of the (a) node segment
 	SegmentId _hunksSegId; ///< ID of the (a) hunk segment
 
+	SelectorLookupCache _selectorLookupCache;
+	uint32 _selectorLookupHits;
+	uint32 _selectorLookupMisses;
+
+	GCState _gc;
+
 	// Statically allocated memory for system strings
 	reg_t _saveDirPtr;
 	reg_t _parserPtr;
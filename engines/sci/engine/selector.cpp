@@ -264,32 +264,54 @@ SelectorType lookupSelector(SegManager *segMan, reg_t obj_location, Selector sel
 				PRINT_REG(obj_location));
 	}
 
-	index = obj->locateVarSelector(segMan, selectorId);
-
-	if (index >= 0) {
-		// Found it as a variable
-		if (varp) {
-			varp->obj = obj_location;
-			varp->varindex = index;
-		}
-		return kSelectorVariable;
+	// Resolving a selector walks the variable and method tables of the
+	// whole superclass chain, so we remember the result
+	const reg_t basePos = obj->getPos();
+	SelectorLookupEntry entry;
+	const SelectorLookupEntry *cached = segMan->getSelectorCacheEntry(basePos, selectorId);
+
+	if (cached) {
+		entry = *cached;
 	} else {
-		// Check if it's a method, with recursive lookup in superclasses
-		while (obj) {
-			index = obj->funcSelectorPosition(selectorId);
-			if (index >= 0) {
-				if (fptr)
-					*fptr = obj->getFunction(index);
-
-				return kSelectorMethod;
-			} else {
-				obj = segMan->getObject(obj->getSuperClassSelector());
+		entry.type = kSelectorNone;
+		entry.varIndex = -1;
+		entry.funcAddr = NULL_REG;
+
+		index = obj->locateVarSelector(segMan, selectorId);
+
+		if (index >= 0) {
+			// Found it as a variable
+			entry.type = kSelectorVariable;
+			entry.varIndex = index;
+		} else {
+			// Check if it's a method, with recursive lookup in superclasses
+			while (obj) {
+				index = obj->funcSelectorPosition(selectorId);
+				if (index >= 0) {
+					entry.type = kSelectorMethod;
+					entry.funcAddr = obj->getFunction(index);
+					break;
+				} else {
+					obj = segMan->getObject(obj->getSuperClassSelector());
+				}
 			}
 		}
 
-		return kSelectorNone;
+		segMan->setSelectorCacheEntry(basePos, selectorId, entry);
+	}
+
+	if (entry.type == kSelectorVariable) {
+		if (varp) {
+			varp->obj = obj_location;
+			varp->varindex = entry.varIndex;
+		}
+	} else if (entry.type == kSelectorMethod) {
+		if (fptr)
+			*fptr = entry.funcAddr;
 	}
 
+	return entry.type;
+
 
 //	return _lookupSelector_function(segMan, obj, selectorId, fptr);
 }
@@ -165,10 +165,7 @@ void EngineState::shrinkStackToBase() {
 	if (_executionStack.size() > 0) {
 		uint size = executionStackBase + 1;
 		assert(_executionStack.size() >= size);
-		Common::List<ExecStack>::iterator iter = _executionStack.begin();
-		for (uint i = 0; i < size; ++i)
-			++iter;
-		_executionStack.erase(iter, _executionStack.end());
+		_executionStack.shrink(size);
 	}
 }
 
@@ -172,7 +172,7 @@ public:
 public:
 	/* VM Information */
 
-	Common::List<ExecStack> _executionStack; /**< The execution stack */
+	ExecutionStack _executionStack; /**< The execution stack */
 	/**
 	 * When called from kernel functions, the vm is re-started recursively on
 	 * the same stack. This variable contains the stack base for the current vm.
@@ -230,6 +230,12 @@ public:
 	VideoState _videoState;
 	bool _syncedAudioOptions;
 
+	// Visibility graph of the polygon set last passed to kAvoidPath. Rooms
+	// tend to use the same set for every path, so vertex visibility is kept
+	// across calls and only thrown away when the polygons change.
+	Common::Array<int16> _avoidPathPolygons;
+	Common::Array<byte> _avoidPathVisibility;
+
 	/**
 	 * Resets the engine state.
 	 */
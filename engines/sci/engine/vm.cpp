@@ -288,7 +288,7 @@ ExecStack *send_selector(EngineState *s, reg_t send_obj, reg_t work_obj, StackPt
 	int activeBreakpointTypes = g_sci->_debugState._activeBreakpointTypes;
 	ObjVarRef varp;
 
-	Common::List<ExecStack>::iterator prevElementIterator = s->_executionStack.end();
+	const uint firstNewFrame = s->_executionStack.size();
 
 	while (framesize > 0) {
 		selector = argp->requireUint16();
@@ -322,17 +322,16 @@ ExecStack *send_selector(EngineState *s, reg_t send_obj, reg_t work_obj, StackPt
 		if (selectorType == kSelectorVariable)
 			xstack.addr.varp = varp;
 
-		// The new stack entries should be put on the stack in reverse order
-		// so that the first one is executed first
-		s->_executionStack.insert(prevElementIterator, xstack);
-		// Decrement the stack end pointer so that it points to our recently
-		// added element, so that the next insert() places it before this one.
-		--prevElementIterator;
+		s->_executionStack.push_back(xstack);
 
 		framesize -= (2 + argc);
 		argp += argc + 1;
 	}	// while (framesize > 0)
 
+	// The new stack entries should be put on the stack in reverse order
+	// so that the first one is executed first
+	s->_executionStack.reverseFrom(firstNewFrame);
+
 	_exec_varselectors(s);
 
 	return s->_executionStack.empty() ? NULL : &(s->_executionStack.back());
@@ -454,7 +453,7 @@ static void callKernelFunc(EngineState *s, int kernelCallNr, int argc) {
 	}
 
 	// Remove callk stack frame again, if there's still an execution stack
-	if (s->_executionStack.begin() != s->_executionStack.end())
+	if (!s->_executionStack.empty())
 		s->_executionStack.pop_back();
 }
 
@@ -852,10 +851,13 @@ void run_vm(EngineState *s) {
 		}
 
 		case op_callk: { // 0x21 (33)
-			// Run the garbage collector, if needed
-			if (s->gcCountDown-- <= 0) {
+			// Run the garbage collector, if needed. Once started, the
+			// collection continues with each kernel call until it's done.
+			if (s->_segMan->getGCState().isSweeping()) {
+				run_gc_step(s);
+			} else if (s->gcCountDown-- <= 0) {
 				s->gcCountDown = s->scriptGCInterval;
-				run_gc(s);
+				run_gc_step(s);
 			}
 
 			// Call kernel function
@@ -1347,6 +1349,31 @@ void run_vm(EngineState *s) {
 	}
 }
 
+ExecutionStack::~ExecutionStack() {
+	for (uint i = 0; i < _chunks.size(); i++)
+		free(_chunks[i]);
+}
+
+void ExecutionStack::push_back(const ExecStack &frame) {
+	if (_size == _chunks.size() * kChunkSize) {
+		ExecStack *chunk = (ExecStack *)malloc(kChunkSize * sizeof(ExecStack));
+		if (!chunk)
+			error("ExecutionStack: Out of memory");
+		_chunks.push_back(chunk);
+	}
+
+	new ((void *)&_chunks[_size / kChunkSize][_size % kChunkSize]) ExecStack(frame);
+	_size++;
+}
+
+void ExecutionStack::reverseFrom(uint first) {
+	if (_size == 0)
+		return;
+
+	for (uint lo = first, hi = _size - 1; lo < hi; lo++, hi--)
+		SWAP((*this)[lo], (*this)[hi]);
+}
+
 reg_t *ObjVarRef::getPointer(SegManager *segMan) const {
 	Object *o = segMan->getObject(obj);
 	return o ? &o->getVariableRef(varindex) : 0;
@@ -28,6 +28,8 @@
 #include "sci/engine/vm_types.h"	// for reg_t
 #include "sci/resource.h"	// for SciVersion
 
+#include "common/array.h"
+#include "common/noncopyable.h"
 #include "common/util.h"
 
 namespace Sci {
@@ -127,6 +129,54 @@ struct ExecStack {
 	}
 };
 
+/**
+ * The execution stack of the VM.
+ *
+ * Frames are stored in fixed size chunks, which are kept around when
+ * frames are popped. Thus pushing a frame normally doesn't allocate any
+ * memory, and frames never move while they are on the stack, so pointers
+ * to them (like EngineState::xs) stay valid.
+ */
+class ExecutionStack : Common::NonCopyable {
+public:
+	ExecutionStack() : _size(0) {}
+	~ExecutionStack();
+
+	uint size() const { return _size; }
+	bool empty() const { return _size == 0; }
+
+	ExecStack &operator[](uint idx) {
+		assert(idx < _size);
+		return _chunks[idx / kChunkSize][idx % kChunkSize];
+	}
+
+	const ExecStack &operator[](uint idx) const {
+		assert(idx < _size);
+		return _chunks[idx / kChunkSize][idx % kChunkSize];
+	}
+
+	ExecStack &back() { return (*this)[_size - 1]; }
+	const ExecStack &back() const { return (*this)[_size - 1]; }
+
+	void push_back(const ExecStack &frame);
+	void pop_back() { assert(_size > 0); _size--; }
+
+	/** Pops frames until only the given number of frames is left. */
+	void shrink(uint newSize) { assert(newSize <= _size); _size = newSize; }
+	void clear() { _size = 0; }
+
+	/** Reverses the order of all frames from the given index upwards. */
+	void reverseFrom(uint first);
+
+private:
+	enum {
+		kChunkSize = 64
+	};
+
+	Common::Array<ExecStack *> _chunks;
+	uint _size;
+};
+
 enum {
 	VAR_GLOBAL = 0,
 	VAR_LOCAL = 1,
@@ -139,6 +189,11 @@ enum {
 	GC_INTERVAL = 0x8000
 };
 
+/** Number of addresses the garbage collector sweeps per kernel call */
+enum {
+	GC_SWEEP_STEP = 256
+};
+
 enum sci_opcodes {
 	op_bnot     = 0x00,	// 000
 	op_add      = 0x01,	// 001
@@ -28,6 +28,7 @@ MODULE_OBJS := \
 	engine/kvideo.o \
 	engine/message.o \
 	engine/object.o \
+	engine/pathfinding.o \
 	engine/savegame.o \
 	engine/script.o \
 	engine/scriptdebug.o \
@@ -22,9 +22,12 @@
 
 // Resource library
 
+#include "common/config-manager.h"
 #include "common/file.h"
 #include "common/fs.h"
 #include "common/macresman.h"
+#include "common/memstream.h"
+#include "common/system.h"
 #include "common/textconsole.h"
 
 #include "sci/resource.h"
@@ -193,11 +196,15 @@ Resource::Resource(ResourceManager *resMan, ResourceId id) : _resMan(resMan), _i
 	_source = NULL;
 	_header = NULL;
 	_headerSize = 0;
+	_packedData = NULL;
+	_packedSize = 0;
+	_packedCompression = kCompNone;
 }
 
 Resource::~Resource() {
 	delete[] data;
 	delete[] _header;
+	delete[] _packedData;
 	if (_source && _source->getSourceType() == kSourcePatch)
 		delete _source;
 }
@@ -566,6 +573,19 @@ Common::SeekableReadStream *ResourceSource::getVolumeFile(ResourceManager *resMa
 }
 
 void ResourceSource::loadResource(ResourceManager *resMan, Resource *res) {
+	if (res->_packedData) {
+		// The compressed data is still in memory, no need to read it again
+		resMan->_cacheStats.packedHits++;
+
+		int error = res->decompressPacked();
+		if (error) {
+			warning("Error %d occurred while unpacking %s: %s",
+					error, res->_id.toString().c_str(), sci_error_types[error]);
+			res->unalloc();
+		}
+		return;
+	}
+
 	Common::SeekableReadStream *fileStream = getVolumeFile(resMan, res);
 	if (!fileStream)
 		return;
@@ -892,6 +912,17 @@ void ResourceManager::init(bool initFromFallbackDetector) {
 	_memoryLocked = 0;
 	_memoryLRU = 0;
 	_LRU.clear();
+	_memoryPacked = 0;
+	_packedLRU.clear();
+	_cacheStats.reset();
+
+	// Cache sizes are configured in KB
+	_maxMemoryLRU = MAX_MEMORY;
+	_maxMemoryPacked = 0;
+	if (ConfMan.hasKey("sci_resource_cache_size"))
+		_maxMemoryLRU = MAX(ConfMan.getInt("sci_resource_cache_size"), 0) * 1024;
+	if (ConfMan.hasKey("sci_resource_cache_compressed_size"))
+		_maxMemoryPacked = MAX(ConfMan.getInt("sci_resource_cache_compressed_size"), 0) * 1024;
 	_resMap.clear();
 	_audioMapSCI1 = NULL;
 
@@ -994,7 +1025,7 @@ void ResourceManager::removeFromLRU(Resource *res) {
 		warning("resMan: trying to remove resource that isn't enqueued");
 		return;
 	}
-	_LRU.remove(res);
+	_LRU.erase(res->_lruPosition);
 	_memoryLRU -= res->size;
 	res->_status = kResStatusAllocated;
 }
@@ -1005,6 +1036,7 @@ void ResourceManager::addToLRU(Resource *res) {
 		return;
 	}
 	_LRU.push_front(res);
+	res->_lruPosition = _LRU.begin();
 	_memoryLRU += res->size;
 #if SCI_VERBOSE_RESMAN
 	debug("Adding %s.%03d (%d bytes) to lru control: %d bytes total",
@@ -1031,12 +1063,52 @@ void ResourceManager::printLRU() {
 	debug("Total: %d entries, %d bytes (mgr says %d)", entries, mem, _memoryLRU);
 }
 
+void ResourceManager::addToPackedLRU(Resource *res, byte *data, uint32 size, ResourceCompression compression) {
+	if (res->_packedData)
+		removeFromPackedLRU(res);
+
+	res->_packedData = data;
+	res->_packedSize = size;
+	res->_packedCompression = compression;
+	_packedLRU.push_front(res);
+	res->_packedPosition = _packedLRU.begin();
+	_memoryPacked += size;
+
+	freeOldPackedData();
+}
+
+void ResourceManager::removeFromPackedLRU(Resource *res) {
+	if (!res->_packedData)
+		return;
+
+	_packedLRU.erase(res->_packedPosition);
+	_memoryPacked -= res->_packedSize;
+	delete[] res->_packedData;
+	res->_packedData = NULL;
+	res->_packedSize = 0;
+}
+
+void ResourceManager::freeOldPackedData() {
+	while (_maxMemoryPacked < _memoryPacked) {
+		assert(!_packedLRU.empty());
+		removeFromPackedLRU(*_packedLRU.reverse_begin());
+	}
+}
+
+void ResourceManager::setCacheSize(int maxMemory, int maxPackedMemory) {
+	_maxMemoryLRU = maxMemory;
+	_maxMemoryPacked = maxPackedMemory;
+	freeOldResources();
+	freeOldPackedData();
+}
+
 void ResourceManager::freeOldResources() {
-	while (MAX_MEMORY < _memoryLRU) {
+	while (_maxMemoryLRU < _memoryLRU) {
 		assert(!_LRU.empty());
 		Resource *goner = *_LRU.reverse_begin();
 		removeFromLRU(goner);
 		goner->unalloc();
+		_cacheStats.evictions++;
 #ifdef SCI_VERBOSE_RESMAN
 		debug("resMan-debug: LRU: Freeing %s.%03d (%d bytes)", getResourceTypeName(goner->type), goner->number, goner->size);
 #endif
@@ -1062,10 +1134,14 @@ Resource *ResourceManager::findResource(ResourceId id, bool lock) {
 	if (!retval)
 		return NULL;
 
-	if (retval->_status == kResStatusNoMalloc)
+	if (retval->_status == kResStatusNoMalloc) {
+		_cacheStats.misses++;
 		loadResource(retval);
-	else if (retval->_status == kResStatusEnqueued)
-		removeFromLRU(retval);
+	} else {
+		_cacheStats.hits++;
+		if (retval->_status == kResStatusEnqueued)
+			removeFromLRU(retval);
+	}
 	// Unless an error occurred, the resource is now either
 	// locked or allocated, but never queued or freed.
 
@@ -1853,6 +1929,14 @@ Resource *ResourceManager::updateResource(ResourceId resId, ResourceSource *src,
 
 	if (_resMap.contains(resId)) {
 		res = _resMap.getVal(resId);
+
+		// The resource now comes from a different source, so forget what
+		// we have cached from the old one
+		if (res->_status == kResStatusEnqueued) {
+			removeFromLRU(res);
+			res->unalloc();
+		}
+		removeFromPackedLRU(res);
 	} else {
 		res = new Resource(this, resId);
 		_resMap.setVal(resId, res);
@@ -1974,6 +2058,38 @@ int Resource::decompress(ResVersion volVersion, Common::SeekableReadStream *file
 	if (errorNum)
 		return errorNum;
 
+	// Keep the compressed data around, if the second cache tier has room
+	// for it, so it doesn't have to be read again after the resource got
+	// evicted
+	if (compression != kCompNone && _resMan->_maxMemoryPacked > 0 && (int)szPacked <= _resMan->_maxMemoryPacked) {
+		byte *packed = new byte[szPacked];
+		if (file->read(packed, szPacked) != szPacked) {
+			delete[] packed;
+			return SCI_ERROR_IO_ERROR;
+		}
+
+		_resMan->addToPackedLRU(this, packed, szPacked, compression);
+		return decompressPacked();
+	}
+
+	return unpack(compression, file, szPacked);
+}
+
+int Resource::decompressPacked() {
+	assert(_packedData);
+
+	// Mark the data as recently used
+	_resMan->_packedLRU.erase(_packedPosition);
+	_resMan->_packedLRU.push_front(this);
+	_packedPosition = _resMan->_packedLRU.begin();
+
+	Common::MemoryReadStream stream(_packedData, _packedSize);
+	return unpack(_packedCompression, &stream, _packedSize);
+}
+
+int Resource::unpack(ResourceCompression compression, Common::SeekableReadStream *file, uint32 szPacked) {
+	int errorNum;
+
 	// getting a decompressor
 	Decompressor *dec = NULL;
 	switch (compression) {
@@ -2002,12 +2118,19 @@ int Resource::decompress(ResVersion volVersion, Common::SeekableReadStream *file
 		return SCI_ERROR_UNKNOWN_COMPRESSION;
 	}
 
+	const uint32 startTime = g_system->getMillis();
+
 	data = new byte[size];
 	_status = kResStatusAllocated;
 	errorNum = data ? dec->unpack(file, data, szPacked, size) : SCI_ERROR_RESOURCE_TOO_BIG;
 	if (errorNum)
 		unalloc();
 
+	if (compression != kCompNone) {
+		_resMan->_cacheStats.decompressions++;
+		_resMan->_cacheStats.decompressTime += g_system->getMillis() - startTime;
+	}
+
 	delete dec;
 	return errorNum;
 }
@@ -242,6 +242,14 @@ protected:
 	uint16 _lockers; /**< Number of places where this resource was locked */
 	ResourceSource *_source;
 	ResourceManager *_resMan;
+	Common::List<Resource *>::iterator _lruPosition; /**< Position in the LRU list, valid while enqueued */
+
+	// Compressed data kept in memory by the second cache tier, so the
+	// resource can be restored without reading it from disk again
+	byte *_packedData;
+	uint32 _packedSize;
+	ResourceCompression _packedCompression;
+	Common::List<Resource *>::iterator _packedPosition; /**< Position in the packed LRU list, valid if _packedData is set */
 
 	bool loadPatch(Common::SeekableReadStream *file);
 	bool loadFromPatchFile();
@@ -249,12 +257,32 @@ protected:
 	bool loadFromAudioVolumeSCI1(Common::SeekableReadStream *file);
 	bool loadFromAudioVolumeSCI11(Common::SeekableReadStream *file);
 	int decompress(ResVersion volVersion, Common::SeekableReadStream *file);
+	int decompressPacked();
+	int unpack(ResourceCompression compression, Common::SeekableReadStream *file, uint32 szPacked);
 	int readResourceInfo(ResVersion volVersion, Common::SeekableReadStream *file, uint32 &szPacked, ResourceCompression &compression);
 };
 
 typedef Common::HashMap<ResourceId, Resource *, ResourceIdHash> ResourceMap;
 
+/** Statistics of the resource cache, as shown by the "resource_cache" console command */
+struct ResourceCacheStats {
+	uint32 hits;	///< Lookups of resources that were in memory
+	uint32 misses;	///< Lookups of resources that had to be loaded
+	uint32 packedHits;	///< Misses restored from compressed data in memory
+	uint32 evictions;	///< Resources freed to stay within the budget
+	uint32 decompressions;	///< Number of compressed resources unpacked
+	uint32 decompressTime;	///< Time spent unpacking resources, in ms
+
+	ResourceCacheStats() { reset(); }
+
+	void reset() {
+		hits = misses = packedHits = evictions = decompressions = decompressTime = 0;
+	}
+};
+
 class ResourceManager {
+	friend class Resource;
+
 	// FIXME: These 'friend' declarations are meant to be a temporary hack to
 	// ease transition to the ResourceSource class system.
 	friend class ResourceSource;
@@ -296,6 +324,25 @@ public:
 	 */
 	Resource *findResource(ResourceId id, bool lock);
 
+	/**
+	 * Sets the memory budgets of the resource cache.
+	 * @param maxMemory			bytes of unlocked resources to keep in memory
+	 * @param maxPackedMemory	bytes of compressed resource data to keep in
+	 *							memory after the resource itself was freed, 0 to
+	 *							disable this second tier
+	 */
+	void setCacheSize(int maxMemory, int maxPackedMemory);
+
+	int getCacheSize() const { return _maxMemoryLRU; }
+	int getPackedCacheSize() const { return _maxMemoryPacked; }
+	int getLRUMemory() const { return _memoryLRU; }
+	int getLockedMemory() const { return _memoryLocked; }
+	int getPackedMemory() const { return _memoryPacked; }
+	uint getLRUCount() const { return _LRU.size(); }
+	uint getPackedCount() const { return _packedLRU.size(); }
+
+	ResourceCacheStats &getCacheStats() { return _cacheStats; }
+
 	/**
 	 * Unlocks a previously locked resource.
 	 * @param res	The resource to free
@@ -379,7 +426,8 @@ public:
 	ResourceType convertResType(byte type);
 
 protected:
-	// Maximum number of bytes to allow being allocated for resources
+	// Default maximum number of bytes to allow being allocated for resources,
+	// can be changed with the sci_resource_cache_size config key.
 	// Note: maxMemory will not be interpreted as a hard limit, only as a restriction
 	// for resources which are not explicitly locked. However, a warning will be
 	// issued whenever this limit is exceeded.
@@ -391,7 +439,12 @@ protected:
 	Common::List<ResourceSource *> _sources;
 	int _memoryLocked;	///< Amount of resource bytes in locked memory
 	int _memoryLRU;		///< Amount of resource bytes under LRU control
+	int _maxMemoryLRU;	///< Maximum amount of resource bytes under LRU control
 	Common::List<Resource *> _LRU; ///< Last Resource Used list
+	int _memoryPacked;	///< Amount of compressed resource bytes kept in memory
+	int _maxMemoryPacked;	///< Maximum amount of compressed resource bytes kept in memory
+	Common::List<Resource *> _packedLRU; ///< Last Resource Used list of compressed resource data
+	ResourceCacheStats _cacheStats;
 	ResourceMap _resMap;
 	Common::List<Common::File *> _volumeFiles; ///< list of opened volume files
 	ResourceSource *_audioMapSCI1; ///< Currently loaded audio map for SCI1
@@ -446,6 +499,7 @@ protected:
 	Common::SeekableReadStream *getVolumeFile(ResourceSource *source);
 	void loadResource(Resource *res);
 	void freeOldResources();
+	void freeOldPackedData();
 	void addResource(ResourceId resId, ResourceSource *src, uint32 offset, uint32 size = 0);
 	Resource *updateResource(ResourceId resId, ResourceSource *src, uint32 size);
 	void removeAudioResource(ResourceId resId);
@@ -511,6 +565,8 @@ protected:
 	void printLRU();
 	void addToLRU(Resource *res);
 	void removeFromLRU(Resource *res);
+	void addToPackedLRU(Resource *res, byte *data, uint32 size, ResourceCompression compression);
+	void removeFromPackedLRU(Resource *res);
 
 	ResourceCompression getViewCompression();
 	ViewType detectViewType();
@@ -214,6 +214,7 @@ void ResourceManager::removeAudioResource(ResourceId resId) {
 			} else {
 				if (res->_status == kResStatusEnqueued)
 					removeFromLRU(res);
+				removeFromPackedLRU(res);
 
 				_resMap.erase(resId);
 				delete res;
@@ -34,6 +34,10 @@
 #include "scumm/resource.h"
 #include "scumm/scumm.h"
 #include "scumm/sound.h"
+#ifdef ENABLE_SCUMM_7_8
+#include "scumm/scumm_v7.h"
+#include "scumm/smush/smush_player.h"
+#endif
 
 namespace Scumm {
 
@@ -79,6 +83,7 @@ ScummDebugger::ScummDebugger(ScummEngine *s)
 	DCmd_Register("scr",       WRAP_METHOD(ScummDebugger, Cmd_Script));
 	DCmd_Register("scripts",   WRAP_METHOD(ScummDebugger, Cmd_PrintScript));
 	DCmd_Register("importres", WRAP_METHOD(ScummDebugger, Cmd_ImportRes));
+	DCmd_Register("resources", WRAP_METHOD(ScummDebugger, Cmd_Resources));
 
 	if (_vm->_game.id == GID_LOOM)
 		DCmd_Register("drafts",  WRAP_METHOD(ScummDebugger, Cmd_PrintDraft));
@@ -97,6 +102,11 @@ ScummDebugger::ScummDebugger(ScummEngine *s)
 
 	DCmd_Register("imuse",     WRAP_METHOD(ScummDebugger, Cmd_IMuse));
 
+#ifdef ENABLE_SCUMM_7_8
+	if (_vm->_game.version >= 7)
+		DCmd_Register("smush",   WRAP_METHOD(ScummDebugger, Cmd_Smush));
+#endif
+
 	DCmd_Register("resetcursors",    WRAP_METHOD(ScummDebugger, Cmd_ResetCursors));
 }
 
@@ -165,6 +175,24 @@ bool ScummDebugger::Cmd_IMuse(int argc, const char **argv) {
 	return true;
 }
 
+#ifdef ENABLE_SCUMM_7_8
+bool ScummDebugger::Cmd_Smush(int argc, const char **argv) {
+	const SmushPlayer::Stats &stats = ((ScummEngine_v7 *)_vm)->_splayer->getStats();
+	if (stats.shownFrames + stats.lateFrames + stats.droppedFrames == 0) {
+		DebugPrintf("No SMUSH movie has been played yet.\n");
+		return true;
+	}
+
+	DebugPrintf("Last SMUSH movie:\n");
+	DebugPrintf("  %d frames shown\n", stats.shownFrames);
+	DebugPrintf("  %d frames late\n", stats.lateFrames);
+	DebugPrintf("  %d frames dropped\n", stats.droppedFrames);
+	DebugPrintf("  %d frames stalled on file access\n", stats.stalledFrames);
+
+	return true;
+}
+#endif
+
 bool ScummDebugger::Cmd_Room(int argc, const char **argv) {
 	if (argc > 1) {
 		int room = atoi(argv[1]);
@@ -311,6 +339,27 @@ bool ScummDebugger::Cmd_ImportRes(int argc, const char** argv) {
 	return true;
 }
 
+bool ScummDebugger::Cmd_Resources(int argc, const char** argv) {
+	ResourceStats &stats = _vm->_res->_stats;
+
+	if (argc == 2 && !strcmp(argv[1], "reset")) {
+		stats.reset();
+		DebugPrintf("Resource statistics reset\n");
+		return true;
+	} else if (argc != 1) {
+		DebugPrintf("Syntax: resources [reset]\n");
+		return true;
+	}
+
+	DebugPrintf("Allocated: %d KB, %d resources which may expire\n", _vm->_res->getAllocatedSize() / 1024, _vm->_res->getExpirableCount());
+	DebugPrintf("Loaded: %d resources, taking %d ms\n", stats.loads, stats.loadTime);
+	DebugPrintf("Expired: %d resources\n", stats.expired);
+	DebugPrintf("Scenes started: %d, loading %d resources\n", stats.scenes, stats.sceneLoads);
+	DebugPrintf("Stalled while starting scenes: %d ms in total, %d ms at most\n", stats.sceneStallTime, stats.maxSceneStallTime);
+	DebugPrintf("Rooms loaded ahead of time: %d, rooms already loaded when entered: %d\n", stats.prefetches, stats.prefetchHits);
+	return true;
+}
+
 bool ScummDebugger::Cmd_PrintScript(int argc, const char **argv) {
 	int i;
 	ScriptSlot *ss = _vm->vm.slot;
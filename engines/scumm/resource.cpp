@@ -540,6 +540,10 @@ void ResourceManager::allocResTypeData(ResType type, uint32 tag, int num, ResTyp
 
 	// If there was data in there, let's clear it out completely. This is important
 	// in case we are restarting the game.
+	for (ResId idx = 0; idx < _types[type].size(); idx++) {
+		if (_types[type][idx]._expirableIndex != -1)
+			removeExpirable(type, idx);
+	}
 	_types[type].clear();
 	_types[type].resize(num);
 
@@ -612,8 +616,13 @@ void ScummEngine::ensureResourceLoaded(ResType type, ResId idx) {
 	if (idx <= _res->_types[type].size() && _res->_types[type][idx]._address)
 		return;
 
+	const uint32 loadStartTime = _system->getMillis();
+
 	loadResource(type, idx);
 
+	_res->_stats.loads++;
+	_res->_stats.loadTime += _system->getMillis() - loadStartTime;
+
 	if (_game.version == 5 && type == rtRoom && (int)idx == _roomResource)
 		VAR(VAR_ROOM_FLAG) = 1;
 }
@@ -777,13 +786,13 @@ void ResourceManager::increaseExpireCounter() {
 }
 
 void ResourceManager::increaseResourceCounters() {
-	for (ResType type = rtFirst; type <= rtLast; type = ResType(type + 1)) {
-		ResId idx = _types[type].size();
-		while (idx-- > 0) {
-			byte counter = _types[type][idx].getResourceCounter();
-			if (counter && counter < RF_USAGE_MAX) {
-				setResourceCounter(type, idx, counter + 1);
-			}
+	// The counters are only looked at by expireResources(), so there's no
+	// need to update those of resources which never expire
+	for (uint i = 0; i < _expirable.size(); i++) {
+		const ExpirableResource &e = _expirable[i];
+		byte counter = _types[e.type][e.idx].getResourceCounter();
+		if (counter && counter < RF_USAGE_MAX) {
+			setResourceCounter(e.type, e.idx, counter + 1);
 		}
 	}
 }
@@ -834,9 +843,34 @@ byte *ResourceManager::createResource(ResType type, ResId idx, uint32 size) {
 	_types[type][idx]._address = ptr;
 	_types[type][idx]._size = size;
 	setResourceCounter(type, idx, 1);
+
+	if (_types[type]._mode != kDynamicResTypeMode)
+		addExpirable(type, idx);
+
 	return ptr;
 }
 
+void ResourceManager::addExpirable(ResType type, ResId idx) {
+	ExpirableResource e;
+	e.type = type;
+	e.idx = idx;
+
+	_types[type][idx]._expirableIndex = _expirable.size();
+	_expirable.push_back(e);
+}
+
+void ResourceManager::removeExpirable(ResType type, ResId idx) {
+	const int pos = _types[type][idx]._expirableIndex;
+
+	// Move the last entry into the place of the removed one
+	const ExpirableResource &last = _expirable.back();
+	_types[last.type][last.idx]._expirableIndex = pos;
+	_expirable[pos] = last;
+	_expirable.pop_back();
+
+	_types[type][idx]._expirableIndex = -1;
+}
+
 ResourceManager::Resource::Resource() {
 	_address = 0;
 	_size = 0;
@@ -844,6 +878,7 @@ ResourceManager::Resource::Resource() {
 	_status = 0;
 	_roomno = 0;
 	_roomoffs = 0;
+	_expirableIndex = -1;
 }
 
 ResourceManager::Resource::~Resource() {
@@ -898,6 +933,8 @@ void ResourceManager::nukeResource(ResType type, ResId idx) {
 	if (ptr != NULL) {
 		debugC(DEBUG_RESOURCE, "nukeResource(%s,%d)", nameOfResType(type), idx);
 		_allocatedSize -= _types[type][idx]._size;
+		if (_types[type][idx]._expirableIndex != -1)
+			removeExpirable(type, idx);
 		_types[type][idx].nuke();
 	}
 }
@@ -1033,9 +1070,6 @@ void ResourceManager::Resource::setOnHeap() {
 }
 
 void ResourceManager::expireResources(uint32 size) {
-	byte best_counter;
-	ResType best_type;
-	int best_res = 0;
 	uint32 oldAllocatedSize;
 
 	if (_expireCounter != 0xFF) {
@@ -1049,29 +1083,40 @@ void ResourceManager::expireResources(uint32 size) {
 	oldAllocatedSize = _allocatedSize;
 
 	do {
-		best_type = rtInvalid;
-		best_counter = 2;
-
-		for (ResType type = rtFirst; type <= rtLast; type = ResType(type + 1)) {
-			if (_types[type]._mode != kDynamicResTypeMode) {
-				// Resources of this type can be reloaded from the data files,
-				// so we can potentially unload them to free memory.
-				ResId idx = _types[type].size();
-				while (idx-- > 0) {
-					Resource &tmp = _types[type][idx];
-					byte counter = tmp.getResourceCounter();
-					if (!tmp.isLocked() && counter >= best_counter && tmp._address && !_vm->isResourceInUse(type, idx) && !tmp.isOffHeap()) {
-						best_counter = counter;
-						best_type = type;
-						best_res = idx;
-					}
-				}
+		int best = -1;
+		byte bestCounter = 2;
+
+		// Expire the oldest resource first. Of equally old ones, take the
+		// same one as the scan through all resource slots used to, i.e. the
+		// one with the highest type and the lowest index.
+		for (uint i = 0; i < _expirable.size(); i++) {
+			const ExpirableResource &e = _expirable[i];
+			Resource &tmp = _types[e.type][e.idx];
+			byte counter = tmp.getResourceCounter();
+
+			if (counter < bestCounter || tmp.isLocked() || tmp.isOffHeap())
+				continue;
+
+			if (best != -1 && counter == bestCounter) {
+				const ExpirableResource &b = _expirable[best];
+
+				if (e.type < b.type || (e.type == b.type && e.idx > b.idx))
+					continue;
 			}
+
+			if (_vm->isResourceInUse(e.type, e.idx))
+				continue;
+
+			best = i;
+			bestCounter = counter;
 		}
 
-		if (!best_type)
+		if (best == -1)
 			break;
-		nukeResource(best_type, best_res);
+
+		const ExpirableResource victim = _expirable[best];
+		nukeResource(victim.type, victim.idx);
+		_stats.expired++;
 	} while (size + _allocatedSize > _minHeapThreshold);
 
 	increaseResourceCounters();
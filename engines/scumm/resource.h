@@ -50,6 +50,27 @@ enum {
 
 class ScummEngine;
 
+/** Statistics of resource loading, as shown by the "resources" debugger command */
+struct ResourceStats {
+	uint32 loads;	///< Resources loaded from the data files
+	uint32 loadTime;	///< Time spent loading resources, in ms
+	uint32 expired;	///< Resources expired to stay below the heap threshold
+	uint32 scenes;	///< Number of scenes started
+	uint32 sceneLoads;	///< Resources loaded while starting scenes
+	uint32 sceneStallTime;	///< Time spent loading resources while starting scenes, in ms
+	uint32 maxSceneStallTime;	///< Longest time spent loading resources while starting one scene, in ms
+	uint32 prefetches;	///< Rooms loaded ahead of time
+	uint32 prefetchHits;	///< Scenes whose room was already in memory
+
+	ResourceStats() { reset(); }
+
+	void reset() {
+		loads = loadTime = expired = 0;
+		scenes = sceneLoads = sceneStallTime = maxSceneStallTime = 0;
+		prefetches = prefetchHits = 0;
+	}
+};
+
 /**
  * The mode of a resource type indicates whether the resource can be restored
  * from the game data files or not.
@@ -125,6 +146,12 @@ public:
 		 */
 		uint32 _roomoffs;
 
+		/**
+		 * The position of this resource in the list of loaded resources
+		 * which may expire, or -1 if it isn't in there.
+		 */
+		int _expirableIndex;
+
 	public:
 		Resource();
 		~Resource();
@@ -170,11 +197,25 @@ public:
 	};
 	ResTypeData _types[rtLast + 1];
 
+	ResourceStats _stats;
+
 protected:
 	uint32 _allocatedSize;
 	uint32 _maxHeapThreshold, _minHeapThreshold;
 	byte _expireCounter;
 
+	struct ExpirableResource {
+		ResType type;
+		ResId idx;
+	};
+
+	/**
+	 * The loaded resources which can be restored from the game data files,
+	 * and may thus expire. Keeping track of them spares expireResources()
+	 * and increaseResourceCounters() going through all resource slots.
+	 */
+	Common::Array<ExpirableResource> _expirable;
+
 public:
 	ResourceManager(ScummEngine *vm);
 	~ResourceManager();
@@ -224,10 +265,22 @@ public:
 
 	void resourceStats();
 
+	uint32 getAllocatedSize() const { return _allocatedSize; }
+	uint32 getExpirableCount() const { return _expirable.size(); }
+
+	/**
+	 * Is there enough free heap to load resources ahead of time, without
+	 * making others expire?
+	 */
+	bool canPrefetch() const { return _allocatedSize < _minHeapThreshold; }
+
 //protected:
 	bool validateResource(const char *str, ResType type, ResId idx) const;
 protected:
 	void expireResources(uint32 size);
+
+	void addExpirable(ResType type, ResId idx);
+	void removeExpirable(ResType type, ResId idx);
 };
 
 } // End of namespace Scumm
@@ -35,6 +35,29 @@
 
 namespace Scumm {
 
+/**
+ * Adds the resources loaded while starting a scene, and the time this took,
+ * to the resource statistics, however startScene() is left.
+ */
+class SceneStallTimer {
+	ResourceStats &_stats;
+	uint32 _loads;
+	uint32 _loadTime;
+
+public:
+	SceneStallTimer(ResourceStats &stats) : _stats(stats), _loads(stats.loads), _loadTime(stats.loadTime) {
+		_stats.scenes++;
+	}
+
+	~SceneStallTimer() {
+		const uint32 stallTime = _stats.loadTime - _loadTime;
+
+		_stats.sceneLoads += _stats.loads - _loads;
+		_stats.sceneStallTime += stallTime;
+		_stats.maxSceneStallTime = MAX(_stats.maxSceneStallTime, stallTime);
+	}
+};
+
 /**
  * Start a 'scene' by loading the specified room with the given main actor.
  * The actor is placed next to the object indicated by objectNr.
@@ -44,6 +67,8 @@ void ScummEngine::startScene(int room, Actor *a, int objectNr) {
 
 	debugC(DEBUG_GENERAL, "Loading room %d", room);
 
+	SceneStallTimer stallTimer(_res->_stats);
+
 	stopTalk();
 
 	fadeOut(_switchRoomEffect2);
@@ -117,6 +142,8 @@ void ScummEngine::startScene(int room, Actor *a, int objectNr) {
 
 	_res->increaseResourceCounters();
 
+	const int prevRoomResource = _roomResource;
+
 	_currentRoom = room;
 	VAR(VAR_ROOM) = room;
 
@@ -128,8 +155,15 @@ void ScummEngine::startScene(int room, Actor *a, int objectNr) {
 	if (VAR_ROOM_RESOURCE != 0xFF)
 		VAR(VAR_ROOM_RESOURCE) = _roomResource;
 
-	if (room != 0)
+	addNextRoom(prevRoomResource, _roomResource);
+
+	if (room != 0) {
+		if ((uint)_roomResource < _res->_types[rtRoom].size() && _res->isResourceLoaded(rtRoom, _roomResource))
+			_res->_stats.prefetchHits++;
+
 		ensureResourceLoaded(rtRoom, room);
+		queueRoomPrefetch(_roomResource);
+	}
 
 	clearRoomObjects();
 
@@ -232,6 +266,66 @@ void ScummEngine::startScene(int room, Actor *a, int objectNr) {
 
 }
 
+void ScummEngine::addNextRoom(int fromRoom, int toRoom) {
+	if (fromRoom == 0 || toRoom == 0 || fromRoom == toRoom || toRoom > 0xFF)
+		return;
+
+	if (_nextRooms.size() < (uint)(fromRoom + 1) * kNumNextRooms)
+		_nextRooms.resize((fromRoom + 1) * kNumNextRooms);
+
+	// Move the room to the front of the list, dropping the oldest one
+	byte *next = &_nextRooms[fromRoom * kNumNextRooms];
+	int i = 0;
+	while (i < kNumNextRooms - 1 && next[i] != toRoom)
+		i++;
+	for (; i > 0; i--)
+		next[i] = next[i - 1];
+	next[0] = toRoom;
+}
+
+void ScummEngine::queueRoomPrefetch(int room) {
+	_prefetchRooms.clear();
+
+	// The HE games read from the room files in many more places, so keep
+	// this to the classic ones
+	if (_game.heversion != 0 || _nextRooms.size() < (uint)(room + 1) * kNumNextRooms)
+		return;
+
+	// The list is used as a stack, so add the least recent room first
+	for (int i = kNumNextRooms - 1; i >= 0; i--) {
+		const byte next = _nextRooms[room * kNumNextRooms + i];
+		if (next)
+			_prefetchRooms.push_back(next);
+	}
+}
+
+bool ScummEngine::prefetchRoom() {
+	while (!_prefetchRooms.empty()) {
+		// Don't make other resources expire for this
+		if (!_res->canPrefetch()) {
+			_prefetchRooms.clear();
+			return false;
+		}
+
+		const byte room = _prefetchRooms.back();
+		_prefetchRooms.pop_back();
+
+		if (room >= _res->_types[rtRoom].size() || _res->isResourceLoaded(rtRoom, room))
+			continue;
+
+		// Rooms on another disk would change VAR_CURRENTDISK, or even ask for
+		// the disk to be inserted
+		if (_res->_types[rtRoom][room]._roomno != _res->_types[rtRoom][_roomResource]._roomno)
+			continue;
+
+		ensureResourceLoaded(rtRoom, room);
+		_res->_stats.prefetches++;
+		return true;
+	}
+
+	return false;
+}
+
 /**
  * Init some static room data after a room has been loaded.
  * E.g. the room dimension, the offset to the graphics data, the room scripts,
@@ -1972,8 +1972,8 @@ Common::Error ScummEngine::go() {
 			(_game.version == 1 && isScriptRunning(137)))
 			delta = 6;
 
-		// Wait...
-		waitForTimer(delta * 1000 / 60 - diff);
+		// Wait, loading the rooms the player may go to next meanwhile...
+		waitForTimer(delta * 1000 / 60 - diff, true);
 
 		// Start the stop watch!
 		diff = _system->getMillis();
@@ -1993,7 +1993,7 @@ Common::Error ScummEngine::go() {
 	return Common::kNoError;
 }
 
-void ScummEngine::waitForTimer(int msec_delay) {
+void ScummEngine::waitForTimer(int msec_delay, bool prefetch) {
 	uint32 start_time;
 
 	if (_fastMode & 2)
@@ -2015,6 +2015,10 @@ void ScummEngine::waitForTimer(int msec_delay) {
 		_system->updateScreen();
 		if (_system->getMillis() >= start_time + msec_delay)
 			break;
+
+		if (prefetch && prefetchRoom())
+			continue;
+
 		_system->delayMillis(10);
 	}
 }
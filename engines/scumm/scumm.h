@@ -25,6 +25,7 @@
 
 #include "engines/engine.h"
 
+#include "common/array.h"
 #include "common/endian.h"
 #include "common/events.h"
 #include "common/file.h"
@@ -455,7 +456,7 @@ public:
 protected:
 	virtual void parseEvent(Common::Event event);
 
-	void waitForTimer(int msec_delay);
+	void waitForTimer(int msec_delay, bool prefetch = false);
 	virtual void processInput();
 	virtual void processKeyboard(Common::KeyState lastKeyHit);
 	virtual void clearClickedStatus();
@@ -645,6 +646,21 @@ protected:
 	void startScene(int room, Actor *a, int b);
 	void startManiac();
 
+	enum {
+		kNumNextRooms = 2
+	};
+
+	/**
+	 * For each room, the rooms last entered from it, most recent first. These
+	 * are loaded ahead of time, while waiting for the next frame.
+	 */
+	Common::Array<byte> _nextRooms;
+	Common::Array<byte> _prefetchRooms;
+
+	void addNextRoom(int fromRoom, int toRoom);
+	void queueRoomPrefetch(int room);
+	bool prefetchRoom();
+
 public:
 	void runScript(int script, bool freezeResistant, bool recursive, int *lvarptr, int cycle = 0);
 	void stopScript(int script);
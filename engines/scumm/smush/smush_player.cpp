@@ -203,6 +203,134 @@ static StringResource *getStrings(ScummEngine *vm, const char *file, bool is_enc
 	return sr;
 }
 
+/**
+ * Wraps a movie file, parts of which can be read into memory ahead of time.
+ * Reading, seeking and the positions work exactly like on the file itself,
+ * so the chunk handlers can't tell the difference, but reading data which is
+ * in memory already doesn't have to wait for the disk.
+ */
+class SmushReadAheadStream : public Common::SeekableReadStream {
+public:
+	SmushReadAheadStream(Common::SeekableReadStream *parentStream)
+		: _parentStream(parentStream), _buffer(0), _bufferCapacity(0),
+		  _bufferStart(0), _bufferSize(0), _pos(parentStream->pos()), _eos(false) {
+	}
+
+	~SmushReadAheadStream() {
+		free(_buffer);
+		delete _parentStream;
+	}
+
+	bool err() const { return _parentStream->err(); }
+	void clearErr() { _eos = false; _parentStream->clearErr(); }
+	bool eos() const { return _eos; }
+
+	int32 pos() const { return _pos; }
+	int32 size() const { return _parentStream->size(); }
+
+	bool seek(int32 offset, int whence = SEEK_SET) {
+		if (whence == SEEK_CUR)
+			offset += _pos;
+		else if (whence == SEEK_END)
+			offset += size();
+
+		// Seeking within the data in memory doesn't touch the file
+		if (offset >= _bufferStart && offset <= _bufferStart + (int32)_bufferSize) {
+			_pos = offset;
+			_eos = false;
+			return true;
+		}
+
+		const bool result = _parentStream->seek(offset, SEEK_SET);
+		_pos = _parentStream->pos();
+		_eos = _parentStream->eos();
+		return result;
+	}
+
+	uint32 read(void *dataPtr, uint32 dataSize) {
+		byte *dst = (byte *)dataPtr;
+		uint32 bytesRead = 0;
+
+		if (_pos >= _bufferStart && _pos < _bufferStart + (int32)_bufferSize) {
+			bytesRead = MIN<uint32>(dataSize, _bufferStart + _bufferSize - _pos);
+			memcpy(dst, _buffer + _pos - _bufferStart, bytesRead);
+			_pos += bytesRead;
+		}
+
+		// Whatever hasn't been read ahead comes from the file
+		if (bytesRead < dataSize) {
+			if (_parentStream->pos() != _pos)
+				_parentStream->seek(_pos, SEEK_SET);
+
+			const uint32 parentRead = _parentStream->read(dst + bytesRead, dataSize - bytesRead);
+			_pos += parentRead;
+			bytesRead += parentRead;
+			_eos = _parentStream->eos();
+		}
+
+		return bytesRead;
+	}
+
+	/**
+	 * Read the given part of the file into memory, unless it is already.
+	 * The data before the current position is dropped from memory.
+	 *
+	 * @return the number of bytes of that part which are in memory now
+	 */
+	uint32 readAhead(int32 offset, uint32 size) {
+		int32 bufferEnd = _bufferStart + _bufferSize;
+
+		if (offset < _bufferStart || offset > bufferEnd) {
+			_bufferStart = offset;
+			_bufferSize = 0;
+			bufferEnd = offset;
+		} else {
+			const int32 keepStart = MIN(_pos, offset);
+			if (keepStart > _bufferStart && keepStart <= bufferEnd) {
+				memmove(_buffer, _buffer + keepStart - _bufferStart, bufferEnd - keepStart);
+				_bufferStart = keepStart;
+				_bufferSize = bufferEnd - keepStart;
+			}
+		}
+
+		const int32 end = offset + size;
+		if (end > bufferEnd) {
+			if ((uint32)(end - _bufferStart) > _bufferCapacity) {
+				_bufferCapacity = end - _bufferStart;
+				_buffer = (byte *)realloc(_buffer, _bufferCapacity);
+				assert(_buffer);
+			}
+
+			if (_parentStream->pos() != bufferEnd)
+				_parentStream->seek(bufferEnd, SEEK_SET);
+			_bufferSize += _parentStream->read(_buffer + _bufferSize, end - bufferEnd);
+			bufferEnd = _bufferStart + _bufferSize;
+		}
+
+		return MAX<int32>(0, MIN(end, bufferEnd) - offset);
+	}
+
+	/** Check whether the given part of the file is in memory. */
+	bool isBuffered(int32 offset, uint32 size) const {
+		return offset >= _bufferStart && offset + (int32)size <= _bufferStart + (int32)_bufferSize;
+	}
+
+	/** Read a big endian value from the data in memory, without moving. */
+	uint32 peekUint32BE(int32 offset) const {
+		assert(isBuffered(offset, 4));
+		return READ_BE_UINT32(_buffer + offset - _bufferStart);
+	}
+
+private:
+	Common::SeekableReadStream *_parentStream;
+	byte *_buffer;
+	uint32 _bufferCapacity;
+	int32 _bufferStart;
+	uint32 _bufferSize;
+	int32 _pos;
+	bool _eos;
+};
+
 void SmushPlayer::timerCallback() {
 	parseNextFrame();
 }
@@ -241,6 +369,8 @@ SmushPlayer::SmushPlayer(ScummEngine_v7 *scumm) {
 	_paused = false;
 	_pauseStartTime = 0;
 	_pauseTime = 0;
+
+	memset(&_stats, 0, sizeof(_stats));
 }
 
 SmushPlayer::~SmushPlayer() {
@@ -966,19 +1096,45 @@ SmushFont *SmushPlayer::getFont(int font) {
 	return _sf[font];
 }
 
+void SmushPlayer::fillReadAhead() {
+	// The file position is undefined until a pending seek is done
+	if (!_base || _seekPos >= 0)
+		return;
+
+	int32 offset = _base->pos();
+	for (int i = 0; i < kReadAheadChunks && offset + 8 < (int32)_baseSize; i++) {
+		if (_base->readAhead(offset, 8) < 8)
+			break;
+
+		const int32 subSize = _base->peekUint32BE(offset + 4);
+		if (subSize < 0 || _base->readAhead(offset + 8, subSize) < (uint32)subSize)
+			break;
+
+		offset += 8 + subSize;
+	}
+}
+
+bool SmushPlayer::isChunkReadAhead() const {
+	const int32 offset = _base->pos();
+	return _base->isBuffered(offset, 8) && _base->isBuffered(offset + 8, _base->peekUint32BE(offset + 4));
+}
+
 void SmushPlayer::parseNextFrame() {
+	bool seeked = false;
 
 	if (_seekPos >= 0) {
 		if (_smixer)
 			_smixer->stop();
 
+		seeked = true;
+
 		if (_seekFile.size() > 0) {
 			delete _base;
 
 			ScummFile *tmp = new ScummFile();
 			if (!g_scumm->openFile(*tmp, _seekFile))
 				error("SmushPlayer: Unable to open file %s", _seekFile.c_str());
-			_base = tmp;
+			_base = new SmushReadAheadStream(tmp);
 			_base->readUint32BE();
 			_baseSize = _base->readUint32BE();
 
@@ -1014,6 +1170,12 @@ void SmushPlayer::parseNextFrame() {
 
 	assert(_base);
 
+	// Usually the chunk has been read ahead in the idle time of the play
+	// loop. If it hasn't, we have to wait for the file now. Right after a
+	// seek, there was no chance to read ahead.
+	if (!seeked && _base->pos() + 8 < (int32)_baseSize && !isChunkReadAhead())
+		_stats.stalledFrames++;
+
 	const uint32 subType = _base->readUint32BE();
 	const int32 subSize = _base->readUint32BE();
 	const int32 subOffset = _base->pos();
@@ -1073,6 +1235,11 @@ void SmushPlayer::warpMouse(int x, int y, int buttons) {
 
 void SmushPlayer::updateScreen() {
 	uint32 end_time, start_time = _vm->_system->getMillis();
+
+	// The previous frame never made it to the screen
+	if (_updateNeeded)
+		_stats.droppedFrames++;
+
 	_updateNeeded = true;
 	end_time = _vm->_system->getMillis();
 	debugC(DEBUG_SMUSH, "Smush stats: updateScreen( %03d )", end_time - start_time);
@@ -1155,6 +1322,8 @@ void SmushPlayer::play(const char *filename, int32 speed, int32 offset, int32 st
 	_palDirtyMin = 256;
 	_palDirtyMax = -1;
 
+	memset(&_stats, 0, sizeof(_stats));
+
 	// Hide mouse
 	bool oldMouseState = CursorMan.showMouse(false);
 
@@ -1174,6 +1343,7 @@ void SmushPlayer::play(const char *filename, int32 speed, int32 offset, int32 st
 	_pauseTime = 0;
 
 	int skipped = 0;
+	bool lateFrame = false;
 
 	for (;;) {
 		uint32 now, elapsed;
@@ -1203,7 +1373,13 @@ void SmushPlayer::play(const char *filename, int32 speed, int32 offset, int32 st
 				skipFrame = true;
 			else
 				skipFrame = false;
+
+			// A late frame is usually skipped, and then counted as
+			// dropped by updateScreen() once the next one is decoded
+			const uint32 frame = _frame;
 			timerCallback();
+			if (_frame != frame)
+				lateFrame = skipFrame;
 		}
 
 		_vm->scummLoop_handleSound();
@@ -1238,6 +1414,10 @@ void SmushPlayer::play(const char *filename, int32 speed, int32 offset, int32 st
 				_vm->_system->copyRectToScreen(_dst, _width, 0, 0, w, h);
 				_vm->_system->updateScreen();
 				_updateNeeded = false;
+				if (lateFrame)
+					_stats.lateFrames++;
+				else
+					_stats.shownFrames++;
 			}
 		}
 		if (_endOfFile)
@@ -1249,9 +1429,17 @@ void SmushPlayer::play(const char *filename, int32 speed, int32 offset, int32 st
 			_IACTpos = 0;
 			break;
 		}
+
+		// Read the next frames in the time we would be idle anyway, so
+		// that file access doesn't delay them when they are due
+		fillReadAhead();
+
 		_vm->_system->delayMillis(10);
 	}
 
+	debugC(DEBUG_SMUSH, "Smush stats: %d frames shown, %d late, %d dropped, %d stalled",
+		_stats.shownFrames, _stats.lateFrames, _stats.droppedFrames, _stats.stalledFrames);
+
 	release();
 
 	// Reset mouse state
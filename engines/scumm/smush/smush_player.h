@@ -31,13 +31,30 @@ namespace Scumm {
 class ScummEngine_v7;
 class SmushFont;
 class SmushMixer;
+class SmushReadAheadStream;
 class StringResource;
 class Codec37Decoder;
 class Codec47Decoder;
 
 class SmushPlayer {
 	friend class Insane;
+public:
+	/**
+	 * Playback statistics of the current or the last played movie. Every
+	 * decoded frame is counted as either shown, late or dropped.
+	 */
+	struct Stats {
+		uint32 shownFrames;   ///< frames copied to the screen in time
+		uint32 lateFrames;    ///< frames copied to the screen after their display time was over
+		uint32 droppedFrames; ///< frames decoded, but never copied to the screen
+		uint32 stalledFrames; ///< frames read from disk when they were due, as they hadn't been read ahead
+	};
+
 private:
+	enum {
+		kReadAheadChunks = 8
+	};
+
 	ScummEngine_v7 *_vm;
 	int32 _nbframes;
 	SmushMixer *_smixer;
@@ -47,7 +64,7 @@ private:
 	StringResource *_strings;
 	Codec37Decoder *_codec37;
 	Codec47Decoder *_codec47;
-	Common::SeekableReadStream *_base;
+	SmushReadAheadStream *_base;
 	uint32 _baseSize;
 	byte *_frameBuffer;
 	byte *_specialBuffer;
@@ -82,6 +99,8 @@ private:
 	bool _middleAudio;
 	bool _skipPalette;
 
+	Stats _stats;
+
 public:
 	SmushPlayer(ScummEngine_v7 *scumm);
 	~SmushPlayer();
@@ -93,6 +112,8 @@ public:
 	void release();
 	void warpMouse(int x, int y, int buttons);
 
+	const Stats &getStats() const { return _stats; }
+
 protected:
 	int _width, _height;
 
@@ -111,6 +132,8 @@ protected:
 private:
 	SmushFont *getFont(int font);
 	void parseNextFrame();
+	void fillReadAhead();
+	bool isChunkReadAhead() const;
 	void init(int32 spped);
 	void setupAnim(const char *file);
 	void updateScreen();
@@ -22,13 +22,45 @@
 
 #include "sword25/console.h"
 #include "sword25/sword25.h"
+#include "sword25/kernel/kernel.h"
+#include "sword25/gfx/graphicengine.h"
+#include "sword25/gfx/renderobjectmanager.h"
 
 namespace Sword25 {
 
 Sword25Console::Sword25Console(Sword25Engine *vm) : GUI::Debugger(), _vm(vm) {
+	DCmd_Register("redraw", WRAP_METHOD(Sword25Console, Cmd_Redraw));
 }
 
 Sword25Console::~Sword25Console() {
 }
 
+bool Sword25Console::Cmd_Redraw(int argc, const char **argv) {
+	GraphicEngine *gfx = Kernel::getInstance()->getGfx();
+	if (!gfx || !gfx->getRenderObjectManager()) {
+		DebugPrintf("The graphics engine is not initialized\n");
+		return true;
+	}
+
+	RenderObjectManager *manager = gfx->getRenderObjectManager();
+
+	if (argc == 2 && !strcmp(argv[1], "reset")) {
+		manager->resetRedrawStats();
+		DebugPrintf("Redraw statistics reset\n");
+		return true;
+	} else if (argc != 1) {
+		DebugPrintf("Syntax: redraw [reset]\n");
+		return true;
+	}
+
+	const RenderObjectManager::RedrawStats &stats = manager->getRedrawStats();
+	const uint32 screenPixels = gfx->getDisplayWidth() * gfx->getDisplayHeight();
+	const uint32 average = stats.frames ? (uint32)(stats.totalPixels / stats.frames) : 0;
+
+	DebugPrintf("Frames: %d, redrawing the whole screen: %d\n", stats.frames, stats.fullRedraws);
+	DebugPrintf("Pixels redrawn in the last frame: %d of %d\n", stats.lastFramePixels, screenPixels);
+	DebugPrintf("Pixels redrawn per frame: %d on average, %d at most\n", average, stats.maxFramePixels);
+	return true;
+}
+
 } // End of namespace Sword25
@@ -110,6 +110,7 @@ bool DynamicBitmap::doRender() {
 }
 
 bool DynamicBitmap::setContent(const byte *pixeldata, uint size, uint offset, uint stride) {
+	forceRefresh();
 	return _image->setContent(pixeldata, size, offset, stride);
 }
 
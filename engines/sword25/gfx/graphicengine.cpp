@@ -107,6 +107,7 @@ bool GraphicEngine::init(int width, int height, int bitDepth, int backbufferCoun
 	_screenRect.top = 0;
 	_screenRect.right = _width;
 	_screenRect.bottom = _height;
+	_clipRect = _screenRect;
 
 	const Graphics::PixelFormat format = g_system->getScreenFormat();
 
@@ -140,8 +141,12 @@ bool GraphicEngine::startFrame(bool updateAll) {
 
 bool GraphicEngine::endFrame() {
 #ifndef THEORA_INDIRECT_RENDERING
-	if (Kernel::getInstance()->getFMV()->isMovieLoaded())
+	if (Kernel::getInstance()->getFMV()->isMovieLoaded()) {
+		// The movie is drawn directly to the screen, so everything has to
+		// be redrawn once it is over
+		_renderObjectManagerPtr->forceFullRedraw();
 		return true;
+	}
 #endif
 
 	_renderObjectManagerPtr->render();
@@ -181,6 +186,8 @@ bool GraphicEngine::fill(const Common::Rect *fillRectPtr, uint color) {
 		rect = *fillRectPtr;
 	}
 
+	rect.clip(_clipRect);
+
 	if (rect.width() > 0 && rect.height() > 0) {
 		if (ca == 0xff) {
 			_backSurface.fillRect(rect, color);
@@ -216,7 +223,7 @@ bool GraphicEngine::fill(const Common::Rect *fillRectPtr, uint color) {
 			}
 		}
 
-		g_system->copyRectToScreen((byte *)_backSurface.getBasePtr(rect.left, rect.top), _backSurface.pitch, rect.left, rect.top, rect.width(), rect.height());
+		// The area is copied to the screen by RenderObjectManager::render()
 	}
 
 	return true;
@@ -145,6 +145,10 @@ public:
 
 	RenderObjectPtr<Panel> getMainPanel();
 
+	RenderObjectManager *getRenderObjectManager() {
+		return _renderObjectManagerPtr.get();
+	}
+
 	/**
 	 * Specifies the time (in microseconds) since the last frame has passed
 	 */
@@ -226,9 +230,27 @@ public:
 	 * If a NULL value is passed, then the entire image is to be filled.
 	 * @param Color         The 32-bit color with which the area is to be filled. The default is BS_RGB(0, 0, 0) (black)
 	 * @note FIf the rectangle is not completely inside the screen, it is automatically clipped.
+	 * @note The area is not copied to the screen here. RenderObjectManager::render() does that for all areas it redraws.
 	 */
 	bool fill(const Common::Rect *fillRectPtr = 0, uint color = BS_RGB(0, 0, 0));
 
+	/**
+	 * Restricts all drawing into the frame buffer to a rectangle. Fill and blit
+	 * operations leave the pixels outside of it untouched.
+	 * @param clipRect      The rectangle to draw into. It is clipped to the screen.
+	 */
+	void setClipRect(const Common::Rect &clipRect) {
+		_clipRect = clipRect;
+		_clipRect.clip(_screenRect);
+	}
+
+	/**
+	 * Returns the rectangle all drawing into the frame buffer is restricted to.
+	 */
+	const Common::Rect &getClipRect() const {
+		return _clipRect;
+	}
+
 	Graphics::Surface _backSurface;
 	Graphics::Surface *getSurface() { return &_backSurface; }
 
@@ -290,6 +312,7 @@ protected:
 	int _width;
 	int _height;
 	Common::Rect _screenRect;
+	Common::Rect _clipRect;
 	int _bitDepth;
 
 	/**
@@ -40,6 +40,11 @@
 
 #include "common/system.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define BLIT_USE_SSE2
+#endif
+
 namespace Sword25 {
 
 // -----------------------------------------------------------------------------
@@ -99,7 +104,8 @@ static byte *readSavegameThumbnail(const Common::String &filename, uint &fileSiz
 RenderedImage::RenderedImage(const Common::String &filename, bool &result) :
 	_data(0),
 	_width(0),
-	_height(0) {
+	_height(0),
+	_scaledImage(0) {
 	result = false;
 
 	PackageManager *pPackage = Kernel::getInstance()->getPackage();
@@ -149,7 +155,8 @@ RenderedImage::RenderedImage(const Common::String &filename, bool &result) :
 
 RenderedImage::RenderedImage(uint width, uint height, bool &result) :
 	_width(width),
-	_height(height) {
+	_height(height),
+	_scaledImage(0) {
 
 	_data = new byte[width * height * 4];
 	Common::fill(_data, &_data[width * height * 4], 0);
@@ -162,7 +169,7 @@ RenderedImage::RenderedImage(uint width, uint height, bool &result) :
 	return;
 }
 
-RenderedImage::RenderedImage() : _width(0), _height(0), _data(0) {
+RenderedImage::RenderedImage() : _width(0), _height(0), _data(0), _scaledImage(0) {
 	_backSurface = Kernel::getInstance()->getGfx()->getSurface();
 
 	_doCleanup = false;
@@ -173,10 +180,20 @@ RenderedImage::RenderedImage() : _width(0), _height(0), _data(0) {
 // -----------------------------------------------------------------------------
 
 RenderedImage::~RenderedImage() {
+	freeScaledImage();
+
 	if (_doCleanup)
 		delete[] _data;
 }
 
+void RenderedImage::freeScaledImage() {
+	if (_scaledImage) {
+		_scaledImage->free();
+		delete _scaledImage;
+		_scaledImage = 0;
+	}
+}
+
 // -----------------------------------------------------------------------------
 
 bool RenderedImage::fill(const Common::Rect *pFillRect, uint color) {
@@ -193,6 +210,8 @@ bool RenderedImage::setContent(const byte *pixeldata, uint size, uint offset, ui
 		return false;
 	}
 
+	freeScaledImage();
+
 	const byte *in = &pixeldata[offset];
 	byte *out = _data;
 
@@ -206,6 +225,8 @@ bool RenderedImage::setContent(const byte *pixeldata, uint size, uint offset, ui
 }
 
 void RenderedImage::replaceContent(byte *pixeldata, int width, int height) {
+	freeScaledImage();
+
 	_width = width;
 	_height = height;
 	_data = pixeldata;
@@ -219,6 +240,291 @@ uint RenderedImage::getPixel(int x, int y) {
 
 // -----------------------------------------------------------------------------
 
+/**
+ * Draws a row of pixels without color modulation. Transparent pixels are
+ * skipped, opaque ones are copied and all others are alpha blended.
+ * @param out       Destination pixels
+ * @param in        Source pixels
+ * @param inStep    Distance between two source pixels, -1 for mirrored rows
+ * @param width     Number of pixels to draw
+ */
+static void blendRow(uint32 *out, const uint32 *in, int inStep, int width) {
+	int j = 0;
+
+#ifdef BLIT_USE_SSE2
+	// Handle four pixels per iteration. Blending a channel is done as
+	// (out * (256 - a) + in * a) >> 8, which is the same as the
+	// out + (((in - out) * a) >> 8) of the scalar code, but stays within
+	// 16 bits.
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i opaque = _mm_set1_epi32(255);
+	const __m128i alphaMask = _mm_set1_epi32(0xFF000000);
+	const __m128i c256 = _mm_set1_epi16(256);
+
+	for (; j + 4 <= width; j += 4) {
+		__m128i src;
+		if (inStep > 0) {
+			src = _mm_loadu_si128((const __m128i *)in);
+		} else {
+			src = _mm_loadu_si128((const __m128i *)(in - 3));
+			src = _mm_shuffle_epi32(src, 0x1B);
+		}
+		in += inStep * 4;
+
+		const __m128i alpha = _mm_srli_epi32(src, 24);
+		const __m128i isTransparent = _mm_cmpeq_epi32(alpha, zero);
+		const __m128i isOpaque = _mm_cmpeq_epi32(alpha, opaque);
+
+		if (_mm_movemask_epi8(isTransparent) == 0xFFFF) {
+			out += 4;
+			continue;
+		}
+
+		if (_mm_movemask_epi8(isOpaque) == 0xFFFF) {
+			_mm_storeu_si128((__m128i *)out, src);
+			out += 4;
+			continue;
+		}
+
+		const __m128i dst = _mm_loadu_si128((const __m128i *)out);
+
+		const __m128i alpha2 = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+		const __m128i alphaLo = _mm_unpacklo_epi32(alpha2, alpha2);
+		const __m128i alphaHi = _mm_unpackhi_epi32(alpha2, alpha2);
+
+		const __m128i lo = _mm_srli_epi16(_mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpacklo_epi8(dst, zero), _mm_sub_epi16(c256, alphaLo)),
+			_mm_mullo_epi16(_mm_unpacklo_epi8(src, zero), alphaLo)), 8);
+		const __m128i hi = _mm_srli_epi16(_mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpackhi_epi8(dst, zero), _mm_sub_epi16(c256, alphaHi)),
+			_mm_mullo_epi16(_mm_unpackhi_epi8(src, zero), alphaHi)), 8);
+
+		__m128i result = _mm_or_si128(_mm_packus_epi16(lo, hi), alphaMask);
+		result = _mm_or_si128(_mm_and_si128(isOpaque, src), _mm_andnot_si128(isOpaque, result));
+		result = _mm_or_si128(_mm_and_si128(isTransparent, dst), _mm_andnot_si128(isTransparent, result));
+
+		_mm_storeu_si128((__m128i *)out, result);
+		out += 4;
+	}
+#endif
+
+	for (; j < width; j++) {
+		const uint32 pix = *in;
+		const uint a = pix >> 24;
+		in += inStep;
+
+		if (a == 255) {
+			*out = pix;
+		} else if (a != 0) {
+			// Blend the two outer channels at once, their products don't
+			// overlap in 32 bits
+			const uint32 dst = *out;
+			const uint32 outer = (((dst & 0xFF00FF) * (256 - a) + (pix & 0xFF00FF) * a) >> 8) & 0xFF00FF;
+			const uint32 middle = (((dst >> 8) & 0xFF) * (256 - a) + ((pix >> 8) & 0xFF) * a) & 0xFF00;
+			*out = 0xFF000000 | outer | middle;
+		}
+		out++;
+	}
+}
+
+#ifdef BLIT_USE_SSE2
+/**
+ * Blends eight 16 bit channels as dst + (((src - dst) * factor) >> 16).
+ */
+static inline __m128i blendModulated(__m128i dst, __m128i src, __m128i factor) {
+	const __m128i sl = _mm_mullo_epi16(src, factor), sh = _mm_mulhi_epu16(src, factor);
+	const __m128i dl = _mm_mullo_epi16(dst, factor), dh = _mm_mulhi_epu16(dst, factor);
+	const __m128i d0 = _mm_srai_epi32(_mm_sub_epi32(_mm_unpacklo_epi16(sl, sh), _mm_unpacklo_epi16(dl, dh)), 16);
+	const __m128i d1 = _mm_srai_epi32(_mm_sub_epi32(_mm_unpackhi_epi16(sl, sh), _mm_unpackhi_epi16(dl, dh)), 16);
+	return _mm_add_epi16(dst, _mm_packs_epi32(d0, d1));
+}
+#endif
+
+/**
+ * Draws a row of pixels with color modulation. Works like blendRow(), but
+ * the alpha value of each pixel is scaled by ca and the color channels by
+ * cr, cg and cb.
+ * @param out       Destination pixels
+ * @param in        Source pixels
+ * @param inStep    Distance between two source pixels, -1 for mirrored rows
+ * @param width     Number of pixels to draw
+ * @param ca        Alpha modulation
+ * @param cr        Red modulation
+ * @param cg        Green modulation
+ * @param cb        Blue modulation
+ */
+static void blendRowModulated(uint32 *out, const uint32 *in, int inStep, int width, int ca, int cr, int cg, int cb) {
+	int j = 0;
+
+#ifdef BLIT_USE_SSE2
+	// Handle four pixels per iteration. A channel modulated by c is blended
+	// as out + (((in - out) * a * c) >> 16), and an unmodulated one as
+	// out + (((in - out) * a) >> 8), which is the same with c = 256. Since
+	// a * c fits in 16 bits, the products are built in 32 bits from
+	// _mm_mullo_epi16() and _mm_mulhi_epu16(). Opaque pixels are set to
+	// (in * c) >> 8, and channels with c = 0 always end up as 0.
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i opaque = _mm_set1_epi32(255);
+	const __m128i alphaMask = _mm_set1_epi32(0xFF000000);
+	const __m128i alphaScale = _mm_set1_epi32(ca);
+	const __m128i scale = _mm_set_epi16(0, cr == 255 ? 256 : cr, cg == 255 ? 256 : cg, cb == 255 ? 256 : cb,
+	                                    0, cr == 255 ? 256 : cr, cg == 255 ? 256 : cg, cb == 255 ? 256 : cb);
+	const __m128i keep = _mm_set1_epi32((cr ? 0xFF0000 : 0) | (cg ? 0xFF00 : 0) | (cb ? 0xFF : 0));
+
+	for (; j + 4 <= width; j += 4) {
+		__m128i src;
+		if (inStep > 0) {
+			src = _mm_loadu_si128((const __m128i *)in);
+		} else {
+			src = _mm_loadu_si128((const __m128i *)(in - 3));
+			src = _mm_shuffle_epi32(src, 0x1B);
+		}
+		in += inStep * 4;
+
+		__m128i alpha = _mm_srli_epi32(src, 24);
+		if (ca != 255)
+			alpha = _mm_srli_epi32(_mm_mullo_epi16(alpha, alphaScale), 8);
+		const __m128i isTransparent = _mm_cmpeq_epi32(alpha, zero);
+		const __m128i isOpaque = _mm_cmpeq_epi32(alpha, opaque);
+
+		if (_mm_movemask_epi8(isTransparent) == 0xFFFF) {
+			out += 4;
+			continue;
+		}
+
+		const __m128i dst = _mm_loadu_si128((const __m128i *)out);
+
+		const __m128i alpha2 = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+		const __m128i factorLo = _mm_mullo_epi16(_mm_unpacklo_epi32(alpha2, alpha2), scale);
+		const __m128i factorHi = _mm_mullo_epi16(_mm_unpackhi_epi32(alpha2, alpha2), scale);
+
+		const __m128i srcLo = _mm_unpacklo_epi8(src, zero);
+		const __m128i srcHi = _mm_unpackhi_epi8(src, zero);
+		const __m128i dstLo = _mm_unpacklo_epi8(dst, zero);
+		const __m128i dstHi = _mm_unpackhi_epi8(dst, zero);
+
+		const __m128i blend = _mm_packus_epi16(blendModulated(dstLo, srcLo, factorLo), blendModulated(dstHi, srcHi, factorHi));
+		const __m128i full = _mm_packus_epi16(_mm_srli_epi16(_mm_mullo_epi16(srcLo, scale), 8),
+		                                      _mm_srli_epi16(_mm_mullo_epi16(srcHi, scale), 8));
+
+		__m128i result = _mm_or_si128(_mm_and_si128(isOpaque, full), _mm_andnot_si128(isOpaque, blend));
+		result = _mm_or_si128(_mm_and_si128(result, keep), alphaMask);
+		result = _mm_or_si128(_mm_and_si128(isTransparent, dst), _mm_andnot_si128(isTransparent, result));
+
+		_mm_storeu_si128((__m128i *)out, result);
+		out += 4;
+	}
+#endif
+
+	byte *o = (byte *)out;
+	for (; j < width; j++) {
+		uint32 pix = *in;
+		int b = (pix >> 0) & 0xff;
+		int g = (pix >> 8) & 0xff;
+		int r = (pix >> 16) & 0xff;
+		int a = (pix >> 24) & 0xff;
+		in += inStep;
+
+		if (ca != 255) {
+			a = a * ca >> 8;
+		}
+
+		switch (a) {
+		case 0: // Full transparency
+			o += 4;
+			break;
+		case 255: // Full opacity
+#if defined(SCUMM_LITTLE_ENDIAN)
+			if (cb != 255)
+				*o++ = (b * cb) >> 8;
+			else
+				*o++ = b;
+
+			if (cg != 255)
+				*o++ = (g * cg) >> 8;
+			else
+				*o++ = g;
+
+			if (cr != 255)
+				*o++ = (r * cr) >> 8;
+			else
+				*o++ = r;
+
+			*o++ = a;
+#else
+			*o++ = a;
+
+			if (cr != 255)
+				*o++ = (r * cr) >> 8;
+			else
+				*o++ = r;
+
+			if (cg != 255)
+				*o++ = (g * cg) >> 8;
+			else
+				*o++ = g;
+
+			if (cb != 255)
+				*o++ = (b * cb) >> 8;
+			else
+				*o++ = b;
+#endif
+			break;
+
+		default: // alpha blending
+#if defined(SCUMM_LITTLE_ENDIAN)
+			if (cb == 0)
+				*o = 0;
+			else if (cb != 255)
+				*o += ((b - *o) * a * cb) >> 16;
+			else
+				*o += ((b - *o) * a) >> 8;
+			o++;
+			if (cg == 0)
+				*o = 0;
+			else if (cg != 255)
+				*o += ((g - *o) * a * cg) >> 16;
+			else
+				*o += ((g - *o) * a) >> 8;
+			o++;
+			if (cr == 0)
+				*o = 0;
+			else if (cr != 255)
+				*o += ((r - *o) * a * cr) >> 16;
+			else
+				*o += ((r - *o) * a) >> 8;
+			o++;
+			*o = 255;
+			o++;
+#else
+			*o = 255;
+			o++;
+			if (cr == 0)
+				*o = 0;
+			else if (cr != 255)
+				*o += ((r - *o) * a * cr) >> 16;
+			else
+				*o += ((r - *o) * a) >> 8;
+			o++;
+			if (cg == 0)
+				*o = 0;
+			else if (cg != 255)
+				*o += ((g - *o) * a * cg) >> 16;
+			else
+				*o += ((g - *o) * a) >> 8;
+			o++;
+			if (cb == 0)
+				*o = 0;
+			else if (cb != 255)
+				*o += ((b - *o) * a * cb) >> 16;
+			else
+				*o += ((b - *o) * a) >> 8;
+			o++;
+#endif
+		}
+	}
+}
+
 bool RenderedImage::blit(int posX, int posY, int flipping, Common::Rect *pPartRect, uint color, int width, int height) {
 	int ca = (color >> 24) & 0xff;
 
@@ -272,12 +578,20 @@ bool RenderedImage::blit(int posX, int posY, int flipping, Common::Rect *pPartRe
 #endif
 
 	Graphics::Surface *img;
-	Graphics::Surface *imgScaled = NULL;
-	byte *savedPixels = NULL;
+	Graphics::Surface scaledImage;
 	if ((width != srcImage.w) || (height != srcImage.h)) {
-		// Scale the image
-		img = imgScaled = scale(srcImage, width, height);
-		savedPixels = (byte *)img->pixels;
+		// Scale the image. Objects are usually drawn with the same size for
+		// many frames in a row, so the last scaled image is kept.
+		const Common::Rect partRect = pPartRect ? *pPartRect : Common::Rect(_width, _height);
+		if (!_scaledImage || (_scaledImage->w != width) || (_scaledImage->h != height) || (_scaledPartRect != partRect)) {
+			freeScaledImage();
+			_scaledImage = scale(srcImage, width, height);
+			_scaledPartRect = partRect;
+		}
+
+		// Work on a copy of the surface header, since it is clipped below
+		scaledImage = *_scaledImage;
+		img = &scaledImage;
 	} else {
 		img = &srcImage;
 	}
@@ -298,146 +612,47 @@ bool RenderedImage::blit(int posX, int posY, int flipping, Common::Rect *pPartRe
 	img->w = CLIP((int)img->w, 0, (int)MAX((int)_backSurface->w - posX, 0));
 	img->h = CLIP((int)img->h, 0, (int)MAX((int)_backSurface->h - posY, 0));
 
-	if ((img->w > 0) && (img->h > 0)) {
-		int xp = 0, yp = 0;
+	// Only draw the part inside the clipping rectangle of the graphics engine
+	const Common::Rect &clipRect = Kernel::getInstance()->getGfx()->getClipRect();
+	const int skipX = MAX(clipRect.left - posX, 0);
+	const int skipY = MAX(clipRect.top - posY, 0);
+	const int drawWidth = MIN((int)img->w, clipRect.right - posX) - skipX;
+	const int drawHeight = MIN((int)img->h, clipRect.bottom - posY) - skipY;
+
+	if ((drawWidth > 0) && (drawHeight > 0)) {
+		int xp = skipX, yp = skipY;
 
 		int inStep = 4;
 		int inoStep = img->pitch;
 		if (flipping & Image::FLIP_V) {
 			inStep = -inStep;
-			xp = img->w - 1;
+			xp = img->w - 1 - skipX;
 		}
 
 		if (flipping & Image::FLIP_H) {
 			inoStep = -inoStep;
-			yp = img->h - 1;
+			yp = img->h - 1 - skipY;
 		}
 
 		byte *ino = (byte *)img->getBasePtr(xp, yp);
-		byte *outo = (byte *)_backSurface->getBasePtr(posX, posY);
-		byte *in, *out;
-
-		for (int i = 0; i < img->h; i++) {
-			out = outo;
-			in = ino;
-			for (int j = 0; j < img->w; j++) {
-				uint32 pix = *(uint32 *)in;
-				int b = (pix >> 0) & 0xff;
-				int g = (pix >> 8) & 0xff;
-				int r = (pix >> 16) & 0xff;
-				int a = (pix >> 24) & 0xff;
-				in += inStep;
-
-				if (ca != 255) {
-					a = a * ca >> 8;
-				}
-
-				switch (a) {
-				case 0: // Full transparency
-					out += 4;
-					break;
-				case 255: // Full opacity
-#if defined(SCUMM_LITTLE_ENDIAN)
-					if (cb != 255)
-						*out++ = (b * cb) >> 8;
-					else
-						*out++ = b;
-
-					if (cg != 255)
-						*out++ = (g * cg) >> 8;
-					else
-						*out++ = g;
-
-					if (cr != 255)
-						*out++ = (r * cr) >> 8;
-					else
-						*out++ = r;
-
-					*out++ = a;
-#else
-					*out++ = a;
-
-					if (cr != 255)
-						*out++ = (r * cr) >> 8;
-					else
-						*out++ = r;
-
-					if (cg != 255)
-						*out++ = (g * cg) >> 8;
-					else
-						*out++ = g;
-
-					if (cb != 255)
-						*out++ = (b * cb) >> 8;
-					else
-						*out++ = b;
-#endif
-					break;
-
-				default: // alpha blending
-#if defined(SCUMM_LITTLE_ENDIAN)
-					if (cb == 0)
-						*out = 0;
-					else if (cb != 255)
-						*out += ((b - *out) * a * cb) >> 16;
-					else
-						*out += ((b - *out) * a) >> 8;
-					out++;
-					if (cg == 0)
-						*out = 0;
-					else if (cg != 255)
-						*out += ((g - *out) * a * cg) >> 16;
-					else
-						*out += ((g - *out) * a) >> 8;
-					out++;
-					if (cr == 0)
-						*out = 0;
-					else if (cr != 255)
-						*out += ((r - *out) * a * cr) >> 16;
-					else
-						*out += ((r - *out) * a) >> 8;
-					out++;
-					*out = 255;
-					out++;
-#else
-					*out = 255;
-					out++;
-					if (cr == 0)
-						*out = 0;
-					else if (cr != 255)
-						*out += ((r - *out) * a * cr) >> 16;
-					else
-						*out += ((r - *out) * a) >> 8;
-					out++;
-					if (cg == 0)
-						*out = 0;
-					else if (cg != 255)
-						*out += ((g - *out) * a * cg) >> 16;
-					else
-						*out += ((g - *out) * a) >> 8;
-					out++;
-					if (cb == 0)
-						*out = 0;
-					else if (cb != 255)
-						*out += ((b - *out) * a * cb) >> 16;
-					else
-						*out += ((b - *out) * a) >> 8;
-					out++;
-#endif
-				}
+		byte *outo = (byte *)_backSurface->getBasePtr(posX + skipX, posY + skipY);
+
+		if ((ca == 255) && (cr == 255) && (cg == 255) && (cb == 255)) {
+			// Without color modulation, the pixels only need to be blended
+			for (int i = 0; i < drawHeight; i++) {
+				blendRow((uint32 *)outo, (const uint32 *)ino, inStep / 4, drawWidth);
+				outo += _backSurface->pitch;
+				ino += inoStep;
+			}
+		} else {
+			for (int i = 0; i < drawHeight; i++) {
+				blendRowModulated((uint32 *)outo, (const uint32 *)ino, inStep / 4, drawWidth, ca, cr, cg, cb);
+				outo += _backSurface->pitch;
+				ino += inoStep;
 			}
-			outo += _backSurface->pitch;
-			ino += inoStep;
 		}
 
-		g_system->copyRectToScreen((byte *)_backSurface->getBasePtr(posX, posY), _backSurface->pitch, posX, posY,
-			img->w, img->h);
-	}
-
-	if (imgScaled) {
-		imgScaled->pixels = savedPixels;
-		imgScaled->free();
-		delete imgScaled;
+		// The area is copied to the screen by RenderObjectManager::render()
 	}
 
 	return true;
@@ -485,6 +700,18 @@ Graphics::Surface *RenderedImage::scale(const Graphics::Surface &srcImage, int x
 		const byte *srcP = (const byte *)srcImage.getBasePtr(0, vertUsage[yp]);
 		byte *destP = (byte *)s->getBasePtr(0, yp);
 
+		// Rows picking the same source row as the previous one are copied
+		if (yp > 0 && vertUsage[yp] == vertUsage[yp - 1]) {
+			memcpy(destP, s->getBasePtr(0, yp - 1), xSize * srcImage.format.bytesPerPixel);
+			continue;
+		}
+
+		if (srcImage.format.bytesPerPixel == 4) {
+			for (int xp = 0; xp < xSize; ++xp)
+				((uint32 *)destP)[xp] = ((const uint32 *)srcP)[horizUsage[xp]];
+			continue;
+		}
+
 		for (int xp = 0; xp < xSize; ++xp) {
 			const byte *tempSrcP = srcP + (horizUsage[xp] * srcImage.format.bytesPerPixel);
 			for (int byteCtr = 0; byteCtr < srcImage.format.bytesPerPixel; ++byteCtr) {
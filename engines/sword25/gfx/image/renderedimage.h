@@ -113,6 +113,11 @@ private:
 
 	Graphics::Surface *_backSurface;
 
+	Graphics::Surface *_scaledImage;  ///< The image scaled by the last scaled blit
+	Common::Rect _scaledPartRect;     ///< The part of the image _scaledImage was created from
+
+	void freeScaledImage();
+
 	static int *scaleLine(int size, int srcSize);
 };
 
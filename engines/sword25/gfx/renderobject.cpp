@@ -96,6 +96,10 @@ RenderObject::RenderObject(RenderObjectPtr<RenderObject> parentPtr, TYPES type,
 }
 
 RenderObject::~RenderObject() {
+	// Den zuletzt gezeichneten Bereich neu zeichnen lassen, damit das Objekt vom Bildschirm verschwindet.
+	if (_managerPtr && _oldVisible)
+		_managerPtr->addDirtyRect(_oldDirtyRect);
+
 	// Objekt aus dem Elternobjekt entfernen.
 	if (_parentPtr.isValid())
 		_parentPtr->detatchChildren(this->getHandle());
@@ -106,7 +110,7 @@ RenderObject::~RenderObject() {
 	RenderObjectRegistry::instance().deregisterObject(this);
 }
 
-bool RenderObject::render() {
+bool RenderObject::render(const Common::Rect &clipRect) {
 	// Objektnderungen validieren
 	validateObject();
 
@@ -120,13 +124,14 @@ bool RenderObject::render() {
 		_childChanged = false;
 	}
 
-	// Objekt zeichnen.
-	doRender();
+	// Objekt zeichnen, falls es im neu zu zeichnenden Bereich liegt.
+	if (calcDirtyRect().intersects(clipRect))
+		doRender();
 
 	// Dann mssen die Kinder gezeichnet werden
 	RENDEROBJECT_ITER it = _children.begin();
 	for (; it != _children.end(); ++it)
-		if (!(*it)->render())
+		if (!(*it)->render(clipRect))
 			return false;
 
 	return true;
@@ -135,6 +140,7 @@ bool RenderObject::render() {
 void RenderObject::validateObject() {
 	// Die Vernderungen in den Objektvariablen aufheben
 	_oldBbox = _bbox;
+	_oldDirtyRect = calcDirtyRect();
 	_oldVisible = _visible;
 	_oldX = _x;
 	_oldY = _y;
@@ -174,6 +180,14 @@ bool RenderObject::updateObjectState() {
 void RenderObject::updateBoxes() {
 	// Bounding-Box aktualisieren
 	_bbox = calcBoundingBox();
+
+	// Sowohl der alte als auch der neue Bereich des Objektes mssen neu gezeichnet werden.
+	if (_managerPtr) {
+		if (_oldVisible)
+			_managerPtr->addDirtyRect(_oldDirtyRect);
+		if (_visible)
+			_managerPtr->addDirtyRect(calcDirtyRect());
+	}
 }
 
 Common::Rect RenderObject::calcBoundingBox() const {
@@ -191,6 +205,15 @@ Common::Rect RenderObject::calcBoundingBox() const {
 	return bbox;
 }
 
+Common::Rect RenderObject::calcDirtyRect() const {
+	// Objekte zeichnen sich vollstndig, auch wenn sie ber das Elternobjekt hinausragen. Daher wird hier, anders als bei
+	// der Bounding-Box, nicht geclippt.
+	Common::Rect dirtyRect(0, 0, _width, _height);
+	dirtyRect.translate(_absoluteX, _absoluteY);
+
+	return dirtyRect;
+}
+
 void RenderObject::calcAbsolutePos(int &x, int &y) const {
 	x = calcAbsoluteX();
 	y = calcAbsoluteY();
@@ -425,6 +448,9 @@ bool RenderObject::unpersist(InputPersistenceBlock &reader) {
 	updateAbsolutePos();
 	updateObjectState();
 
+	// Der Bereich wird nicht gespeichert. Nach dem Laden wird ohnehin der gesamte Bildschirm neu gezeichnet.
+	_oldDirtyRect = calcDirtyRect();
+
 	return reader.isGood();
 }
 
@@ -213,12 +213,14 @@ public:
 	// ---------
 	/**
 	    @brief Rendert des Objekt und alle seine Unterobjekte.
+	    @param clipRect der Bildschirmbereich, der neu gezeichnet wird. Objekte, deren Bounding-Box ihn nicht schneidet, werden
+	                    nicht gezeichnet, ihre Unterobjekte aber trotzdem besucht.
 	    @return Gibt false zurck, falls beim Rendern ein Fehler aufgetreten ist.
 	    @remark Vor jedem Aufruf dieser Methode muss ein Aufruf von UpdateObjectState() erfolgt sein.
 	            Dieses kann entweder direkt geschehen oder durch den Aufruf von UpdateObjectState() an einem Vorfahren-Objekt.<br>
 	            Diese Methode darf nur von BS_RenderObjectManager aufgerufen werden.
 	*/
-	bool render();
+	bool render(const Common::Rect &clipRect);
 	/**
 	    @brief Bereitet das Objekt und alle seine Unterobjekte auf einen Rendervorgang vor.
 	           Hierbei werden alle Dirty-Rectangles berechnet und die Renderreihenfolge aktualisiert.
@@ -383,6 +385,7 @@ protected:
 
 	// Kopien der Variablen, die fr die Errechnung des Dirty-Rects und zur Bestimmung der Objektvernderung notwendig sind
 	Common::Rect     _oldBbox;
+	Common::Rect     _oldDirtyRect;
 	int         _oldX;
 	int         _oldY;
 	int         _oldZ;
@@ -466,6 +469,9 @@ private:
 	Common::Rect calcBoundingBox() const;
 	/**
 	    @brief Berechnet das Dirty-Rectangle des Objektes.
+
+	    Dies ist der Bereich, in den das Objekt zeichnet. Anders als die Bounding-Box wird er nicht am Elternobjekt geclippt.
+
 	    @return Gibt das Dirty-Rectangle des Objektes in Bildschirmkoordinaten zurck.
 	*/
 	Common::Rect calcDirtyRect() const;
@@ -37,6 +37,8 @@
 #include "sword25/gfx/graphicengine.h"
 #include "sword25/gfx/animationtemplateregistry.h"
 #include "common/rect.h"
+#include "common/system.h"
+#include "common/textconsole.h"
 #include "sword25/gfx/renderobject.h"
 #include "sword25/gfx/timedrenderobject.h"
 #include "sword25/gfx/rootrenderobject.h"
@@ -44,7 +46,11 @@
 namespace Sword25 {
 
 RenderObjectManager::RenderObjectManager(int width, int height, int framebufferCount) :
-	_frameStarted(false) {
+	_frameStarted(false),
+	_fullRedraw(true),
+	_screenRect(width, height) {
+	_stats.reset();
+
 	// Wurzel des BS_RenderObject-Baumes erzeugen.
 	_rootPtr = (new RootRenderObject(this, width, height))->getHandle();
 }
@@ -75,8 +81,71 @@ bool RenderObjectManager::render() {
 
 	_frameStarted = false;
 
-	// Die Render-Methode der Wurzel aufrufen. Dadurch wird das rekursive Rendern der Baumelemente angestoen.
-	return _rootPtr->render();
+	if (_fullRedraw) {
+		_dirtyRects.clear();
+		_dirtyRects.push_back(_screenRect);
+		_fullRedraw = false;
+		_stats.fullRedraws++;
+	}
+
+	GraphicEngine *gfxPtr = Kernel::getInstance()->getGfx();
+	Graphics::Surface *surface = gfxPtr->getSurface();
+	bool result = true;
+	uint32 pixels = 0;
+
+	// Die Render-Methode der Wurzel fr jeden vernderten Bereich aufrufen. Dadurch wird das rekursive Rendern der
+	// Baumelemente angestoen. Anschlieend wird nur der neu gezeichnete Bereich auf den Bildschirm kopiert.
+	for (uint i = 0; i < _dirtyRects.size() && result; ++i) {
+		const Common::Rect &rect = _dirtyRects[i];
+
+		gfxPtr->setClipRect(rect);
+		result = _rootPtr->render(rect);
+
+		g_system->copyRectToScreen((byte *)surface->getBasePtr(rect.left, rect.top), surface->pitch, rect.left, rect.top, rect.width(), rect.height());
+		pixels += rect.width() * rect.height();
+	}
+
+	gfxPtr->setClipRect(_screenRect);
+	_dirtyRects.clear();
+
+	_stats.frames++;
+	_stats.lastFramePixels = pixels;
+	_stats.maxFramePixels = MAX(_stats.maxFramePixels, pixels);
+	_stats.totalPixels += pixels;
+	debug(9, "RenderObjectManager::render(): %d pixels redrawn", pixels);
+
+	return result;
+}
+
+void RenderObjectManager::addDirtyRect(const Common::Rect &rect) {
+	if (_fullRedraw)
+		return;
+
+	Common::Rect dirtyRect(rect);
+	dirtyRect.clip(_screenRect);
+	if (dirtyRect.isEmpty())
+		return;
+
+	// Mit allen berlappenden Bereichen zusammenfassen. Da der zusammengefasste Bereich weitere Bereiche berlappen kann,
+	// wird nach jedem Zusammenfassen von vorne begonnen.
+	uint i = 0;
+	while (i < _dirtyRects.size()) {
+		if (_dirtyRects[i].intersects(dirtyRect)) {
+			dirtyRect.extend(_dirtyRects[i]);
+			_dirtyRects.remove_at(i);
+			i = 0;
+		} else {
+			++i;
+		}
+	}
+
+	if (_dirtyRects.size() >= MAX_DIRTY_RECTS) {
+		for (i = 0; i < _dirtyRects.size(); ++i)
+			dirtyRect.extend(_dirtyRects[i]);
+		_dirtyRects.clear();
+	}
+
+	_dirtyRects.push_back(dirtyRect);
 }
 
 void RenderObjectManager::attatchTimedRenderObject(RenderObjectPtr<TimedRenderObject> renderObjectPtr) {
@@ -125,6 +194,9 @@ bool RenderObjectManager::unpersist(InputPersistenceBlock &reader) {
 
 	reader.read(_frameStarted);
 
+	// Der Bildschirminhalt passt nicht mehr zu den wiederhergestellten Objekten.
+	forceFullRedraw();
+
 	// Momentan gespeicherte Referenzen auf TimedRenderObjects lschen.
 	_timedRenderObjects.resize(0);
 
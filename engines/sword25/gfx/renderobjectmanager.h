@@ -84,6 +84,8 @@ public:
 	/**
 	    @brief Rendert alle Objekte die sich whrend des letzten Aufrufes von Render() verndert haben.
 	    @return Gibt false zurck, falls das Rendern fehlgeschlagen ist.
+	    @remark Die neu gezeichneten Bereiche werden anschlieend auf den Bildschirm kopiert. GraphicEngine::fill() und
+	            RenderedImage::blit() kopieren selbst nichts auf den Bildschirm, sondern verlassen sich darauf.
 	 */
 	bool render();
 	/**
@@ -105,12 +107,61 @@ public:
 	    @brief Entfernt ein BS_TimedRenderObject aus der Liste fr zeitabhngige Render-Objekte.
 	*/
 	void detatchTimedRenderObject(RenderObjectPtr<TimedRenderObject> pRenderObject);
+	/**
+	    @brief Markiert einen Bildschirmbereich, der beim nchsten Aufruf von render() neu gezeichnet werden muss.
+
+	    berlappende Bereiche werden zusammengefasst. Gibt es zu viele Bereiche, werden alle zu ihrer Bounding-Box
+	    zusammengefasst.
+
+	    @param rect der Bereich in Bildschirmkoordinaten
+	*/
+	void addDirtyRect(const Common::Rect &rect);
+	/**
+	    @brief Sorgt dafr, dass beim nchsten Aufruf von render() der gesamte Bildschirm neu gezeichnet wird.
+
+	    Dies ist immer dann ntig, wenn der Bildschirminhalt ohne den Manager verndert wurde, z.B. durch ein Video.
+	*/
+	void forceFullRedraw() {
+		_fullRedraw = true;
+	}
+
+	/**
+	    @brief Statistik darber, wie viele Pixel pro Frame neu gezeichnet wurden.
+	*/
+	struct RedrawStats {
+		uint32 frames;            ///< Anzahl der gerenderten Frames
+		uint32 fullRedraws;       ///< Anzahl der Frames, in denen der gesamte Bildschirm neu gezeichnet wurde
+		uint32 lastFramePixels;   ///< Anzahl der im letzten Frame neu gezeichneten Pixel
+		uint32 maxFramePixels;    ///< Hchste Anzahl der in einem Frame neu gezeichneten Pixel
+		double totalPixels;       ///< Anzahl der in allen Frames neu gezeichneten Pixel
+
+		void reset() {
+			frames = fullRedraws = lastFramePixels = maxFramePixels = 0;
+			totalPixels = 0;
+		}
+	};
+
+	const RedrawStats &getRedrawStats() const {
+		return _stats;
+	}
+	void resetRedrawStats() {
+		_stats.reset();
+	}
 
 	virtual bool persist(OutputPersistenceBlock &writer);
 	virtual bool unpersist(InputPersistenceBlock &reader);
 
 private:
+	enum {
+		MAX_DIRTY_RECTS = 16
+	};
+
 	bool _frameStarted;
+	bool _fullRedraw;
+	Common::Rect _screenRect;
+	Common::Array<Common::Rect> _dirtyRects;
+	RedrawStats _stats;
+
 	typedef Common::Array<RenderObjectPtr<TimedRenderObject> > RenderObjectList;
 	RenderObjectList _timedRenderObjects;
 
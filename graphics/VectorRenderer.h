@@ -266,6 +266,13 @@ public:
 		_activeSurface = surface;
 	}
 
+	/**
+	 * Returns the surface all drawing is currently done on.
+	 */
+	Surface *getActiveSurface() const {
+		return _activeSurface;
+	}
+
 	/**
 	 * Fills the active surface with the specified fg/bg color or the active gradient.
 	 * Defaults to using the active Foreground color for filling.
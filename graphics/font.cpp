@@ -120,12 +120,16 @@ void Font::drawString(Surface *dst, const Common::String &sOld, int x, int y, in
 		x = x + w - width;
 	x += deltax;
 
+	drawStringLine(dst, str, x, y, leftX, rightX, color);
+}
+
+void Font::drawStringLine(Surface *dst, const Common::String &str, int x, int y, int leftX, int rightX, uint32 color) const {
 	uint last = 0;
-	for (i = 0; i < str.size(); ++i) {
+	for (uint i = 0; i < str.size(); ++i) {
 		const uint cur = str[i];
 		x += getKerningOffset(last, cur);
 		last = cur;
-		w = getCharWidth(cur);
+		const int w = getCharWidth(cur);
 		if (x+w > rightX)
 			break;
 		if (x >= leftX)
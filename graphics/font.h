@@ -120,6 +120,17 @@ public:
 	 * @return the maximal width of any of the lines added to lines
 	 */
 	int wordWrapText(const Common::String &str, int maxWidth, Common::Array<Common::String> &lines) const;
+
+protected:
+	/**
+	 * Draw a single line of text, which was already aligned and shortened
+	 * by drawString. Characters left of leftX are skipped and drawing stops
+	 * at the first character which would exceed rightX.
+	 *
+	 * The default implementation draws the line with drawChar, one character
+	 * at a time. Fonts can override it with a faster batched path.
+	 */
+	virtual void drawStringLine(Surface *dst, const Common::String &str, int x, int y, int leftX, int rightX, uint32 color) const;
 };
 
 } // End of namespace Graphics
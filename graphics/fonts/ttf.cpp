@@ -34,6 +34,7 @@
 #include "common/singleton.h"
 #include "common/stream.h"
 #include "common/hashmap.h"
+#include "common/array.h"
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -112,6 +113,8 @@ public:
 	virtual int getKerningOffset(byte left, byte right) const;
 
 	virtual void drawChar(Surface *dst, byte chr, int x, int y, uint32 color) const;
+protected:
+	virtual void drawStringLine(Surface *dst, const Common::String &str, int x, int y, int leftX, int rightX, uint32 color) const;
 private:
 	bool _initialized;
 	FT_Face _face;
@@ -122,17 +125,69 @@ private:
 	int _width, _height;
 	int _ascent, _descent;
 
+	/**
+	 * A rasterized glyph. The image data lives in one of the atlas pages,
+	 * at (x, y) with the size w x h.
+	 */
 	struct Glyph {
-		Surface image;
+		FT_UInt slot;
+		bool valid;
+
+		int page;
+		int x, y, w, h;
+
 		int xOffset, yOffset;
 		int advance;
+
+		Glyph() : slot(0), valid(false), page(-1), x(0), y(0), w(0), h(0), xOffset(0), yOffset(0), advance(0) {}
 	};
 
-	bool cacheGlyph(Glyph &glyph, FT_UInt &slot, uint chr);
-	typedef Common::HashMap<byte, Glyph> GlyphCache;
-	GlyphCache _glyphs;
+	/**
+	 * A page of the glyph atlas. Glyphs are packed into horizontal
+	 * shelves, which are filled from left to right.
+	 */
+	struct AtlasPage {
+		Surface image;
+		int shelfX, shelfY;
+		int shelfHeight;
+	};
+
+	bool cacheGlyph(Glyph &glyph, uint32 unicode) const;
+	uint8 *allocateGlyph(Glyph &glyph) const;
+
+	/**
+	 * Look up the glyph for a Unicode code point, rasterizing it on first
+	 * use. The returned glyph is invalid in case the font does not contain
+	 * the code point.
+	 */
+	const Glyph &getGlyph(uint32 unicode) const;
+
+	/**
+	 * Look up the glyph for a character of the font's 8bit mapping. This
+	 * goes through a direct lookup table after the first call.
+	 */
+	const Glyph &getCharGlyph(byte chr) const {
+		const Glyph *glyph = _charGlyphs[chr];
+		if (!glyph)
+			glyph = _charGlyphs[chr] = &getGlyph(_charMap[chr]);
+		return *glyph;
+	}
+
+	int getKerning(const Glyph &left, const Glyph &right) const;
 
-	FT_UInt _glyphSlots[256];
+	void drawGlyph(Surface *dst, const Glyph &glyph, int x, int y, uint32 color) const;
+
+	typedef Common::HashMap<uint32, Glyph *> GlyphCache;
+	mutable GlyphCache _glyphs;
+
+	uint32 _charMap[256];
+	mutable const Glyph *_charGlyphs[256];
+
+	int _atlasSize;
+	mutable Common::Array<AtlasPage *> _atlas;
+
+	typedef Common::HashMap<uint32, int> KerningCache;
+	mutable KerningCache _kerning;
 
 	bool _monochrome;
 	bool _hasKerning;
@@ -140,7 +195,8 @@ private:
 
 TTFFont::TTFFont()
     : _initialized(false), _face(), _ttfFile(0), _size(0), _width(0), _height(0), _ascent(0),
-      _descent(0), _glyphs(), _glyphSlots(), _monochrome(false), _hasKerning(false) {
+      _descent(0), _glyphs(), _charMap(), _charGlyphs(), _atlasSize(0), _atlas(), _kerning(),
+      _monochrome(false), _hasKerning(false) {
 }
 
 TTFFont::~TTFFont() {
@@ -151,7 +207,12 @@ TTFFont::~TTFFont() {
 		_ttfFile = 0;
 
 		for (GlyphCache::iterator i = _glyphs.begin(), end = _glyphs.end(); i != end; ++i)
-			i->_value.image.free();
+			delete i->_value;
+
+		for (uint i = 0; i < _atlas.size(); ++i) {
+			_atlas[i]->image.free();
+			delete _atlas[i];
+		}
 
 		_initialized = false;
 	}
@@ -211,27 +272,40 @@ bool TTFFont::load(Common::SeekableReadStream &stream, int size, bool monochrome
 	_width = ftCeil26_6(FT_MulFix(_face->max_advance_width, _face->size->metrics.x_scale));
 	_height = _ascent - _descent + 1;
 
-	if (!mapping) {
-		// Load all ISO-8859-1 characters.
-		for (uint i = 0; i < 256; ++i) {
-			if (!cacheGlyph(_glyphs[i], _glyphSlots[i], i))
-				_glyphSlots[i] = 0;
-		}
-	} else {
-		for (uint i = 0; i < 256; ++i) {
-			const uint32 unicode = mapping[i] & 0x7FFFFFFF;
-			const bool isRequired = (mapping[i] & 0x80000000) != 0;
-			// Check whether loading an important glyph fails and error out if
-			// that is the case.
-			if (!cacheGlyph(_glyphs[i], _glyphSlots[i], unicode)) {
-				_glyphSlots[i] = 0;
-				if (isRequired)
-					return false;
+	// Make the atlas pages big enough to hold a decent amount of glyphs
+	_atlasSize = 256;
+	while (_atlasSize < 8 * MAX(_width, _height))
+		_atlasSize *= 2;
+
+	// Glyphs are only rasterized once they are used. We merely check here
+	// that the font has any of the characters at all and that the required
+	// glyphs of the mapping are present.
+	bool hasGlyphs = false;
+	for (uint i = 0; i < 256; ++i) {
+		_charMap[i] = mapping ? (mapping[i] & 0x7FFFFFFF) : i;
+
+		if (!FT_Get_Char_Index(_face, _charMap[i])) {
+			if (mapping && (mapping[i] & 0x80000000)) {
+				delete[] _ttfFile;
+				_ttfFile = 0;
+
+				g_ttf.closeFont(_face);
+
+				return false;
 			}
+		} else {
+			hasGlyphs = true;
 		}
 	}
 
-	_initialized = (_glyphs.size() != 0);
+	_initialized = hasGlyphs;
+	if (!_initialized) {
+		delete[] _ttfFile;
+		_ttfFile = 0;
+
+		g_ttf.closeFont(_face);
+	}
+
 	return _initialized;
 }
 
@@ -244,26 +318,54 @@ int TTFFont::getMaxCharWidth() const {
 }
 
 int TTFFont::getCharWidth(byte chr) const {
-	GlyphCache::const_iterator glyphEntry = _glyphs.find(chr);
-	if (glyphEntry == _glyphs.end())
-		return 0;
-	else
-		return glyphEntry->_value.advance;
+	return getCharGlyph(chr).advance;
 }
 
 int TTFFont::getKerningOffset(byte left, byte right) const {
 	if (!_hasKerning)
 		return 0;
 
-	FT_UInt leftGlyph = _glyphSlots[left];
-	FT_UInt rightGlyph = _glyphSlots[right];
+	return getKerning(getCharGlyph(left), getCharGlyph(right));
+}
+
+const TTFFont::Glyph &TTFFont::getGlyph(uint32 unicode) const {
+	GlyphCache::const_iterator glyphEntry = _glyphs.find(unicode);
+	if (glyphEntry != _glyphs.end())
+		return *glyphEntry->_value;
+
+	// Missing glyphs are cached as invalid glyphs, so that we do not have to
+	// ask FreeType about them every time.
+	Glyph *glyph = new Glyph();
+	if (!cacheGlyph(*glyph, unicode))
+		*glyph = Glyph();
+
+	_glyphs[unicode] = glyph;
+	return *glyph;
+}
 
-	if (!leftGlyph || !rightGlyph)
+int TTFFont::getKerning(const Glyph &left, const Glyph &right) const {
+	if (!_hasKerning || !left.slot || !right.slot)
 		return 0;
 
+	// Glyph indices are 16 bit in TrueType fonts, which lets us use the
+	// pair as key. Everything else is passed on to FreeType directly.
+	const bool cacheable = (left.slot <= 0xFFFF && right.slot <= 0xFFFF);
+	const uint32 key = (left.slot << 16) | right.slot;
+
+	if (cacheable) {
+		KerningCache::const_iterator kerningEntry = _kerning.find(key);
+		if (kerningEntry != _kerning.end())
+			return kerningEntry->_value;
+	}
+
 	FT_Vector kerningVector;
-	FT_Get_Kerning(_face, leftGlyph, rightGlyph, FT_KERNING_DEFAULT, &kerningVector);
-	return (kerningVector.x / 64);
+	FT_Get_Kerning(_face, left.slot, right.slot, FT_KERNING_DEFAULT, &kerningVector);
+	const int offset = (kerningVector.x / 64);
+
+	if (cacheable)
+		_kerning[key] = offset;
+
+	return offset;
 }
 
 namespace {
@@ -305,11 +407,28 @@ void renderGlyph(uint8 *dstPos, const int dstPitch, const uint8 *srcPos, const i
 } // End of anonymous namespace
 
 void TTFFont::drawChar(Surface *dst, byte chr, int x, int y, uint32 color) const {
-	GlyphCache::const_iterator glyphEntry = _glyphs.find(chr);
-	if (glyphEntry == _glyphs.end())
-		return;
+	drawGlyph(dst, getCharGlyph(chr), x, y, color);
+}
 
-	const Glyph &glyph = glyphEntry->_value;
+void TTFFont::drawStringLine(Surface *dst, const Common::String &str, int x, int y, int leftX, int rightX, uint32 color) const {
+	const Glyph *last = 0;
+	for (uint i = 0; i < str.size(); ++i) {
+		const Glyph &glyph = getCharGlyph(str[i]);
+		if (last)
+			x += getKerning(*last, glyph);
+		last = &glyph;
+
+		if (x + glyph.advance > rightX)
+			break;
+		if (x >= leftX)
+			drawGlyph(dst, glyph, x, y, color);
+		x += glyph.advance;
+	}
+}
+
+void TTFFont::drawGlyph(Surface *dst, const Glyph &glyph, int x, int y, uint32 color) const {
+	if (!glyph.valid || !glyph.w || !glyph.h)
+		return;
 
 	x += glyph.xOffset;
 	y += glyph.yOffset;
@@ -319,10 +438,11 @@ void TTFFont::drawChar(Surface *dst, byte chr, int x, int y, uint32 color) const
 	if (y > dst->h)
 		return;
 
-	int w = glyph.image.w;
-	int h = glyph.image.h;
+	int w = glyph.w;
+	int h = glyph.h;
 
-	const uint8 *srcPos = (const uint8 *)glyph.image.getBasePtr(0, 0);
+	const Surface &image = _atlas[glyph.page]->image;
+	const uint8 *srcPos = (const uint8 *)image.getBasePtr(glyph.x, glyph.y);
 
 	// Make sure we are not drawing outside the screen bounds
 	if (x < 0) {
@@ -338,7 +458,7 @@ void TTFFont::drawChar(Surface *dst, byte chr, int x, int y, uint32 color) const
 		return;
 
 	if (y < 0) {
-		srcPos += y * glyph.image.pitch;
+		srcPos -= y * image.pitch;
 		h += y;
 		y = 0;
 	}
@@ -367,24 +487,57 @@ void TTFFont::drawChar(Surface *dst, byte chr, int x, int y, uint32 color) const
 			}
 
 			dstPos += dst->pitch;
-			srcPos += glyph.image.pitch;
+			srcPos += image.pitch;
 		}
 	} else if (dst->format.bytesPerPixel == 2) {
-		renderGlyph<uint16>(dstPos, dst->pitch, srcPos, glyph.image.pitch, w, h, color, dst->format);
+		renderGlyph<uint16>(dstPos, dst->pitch, srcPos, image.pitch, w, h, color, dst->format);
 	} else if (dst->format.bytesPerPixel == 4) {
-		renderGlyph<uint32>(dstPos, dst->pitch, srcPos, glyph.image.pitch, w, h, color, dst->format);
+		renderGlyph<uint32>(dstPos, dst->pitch, srcPos, image.pitch, w, h, color, dst->format);
 	}
 }
 
-bool TTFFont::cacheGlyph(Glyph &glyph, FT_UInt &slot, uint chr) {
-	slot = FT_Get_Char_Index(_face, chr);
-	if (!slot)
+uint8 *TTFFont::allocateGlyph(Glyph &glyph) const {
+	AtlasPage *page = _atlas.empty() ? 0 : _atlas.back();
+
+	if (page) {
+		// Start a new shelf in case the glyph does not fit into the current one
+		if (page->shelfX + glyph.w > page->image.w) {
+			page->shelfY += page->shelfHeight;
+			page->shelfX = 0;
+			page->shelfHeight = 0;
+		}
+
+		if (page->shelfX + glyph.w > page->image.w || page->shelfY + glyph.h > page->image.h)
+			page = 0;
+	}
+
+	if (!page) {
+		page = new AtlasPage();
+		page->image.create(MAX(_atlasSize, glyph.w), MAX(_atlasSize, glyph.h), PixelFormat::createFormatCLUT8());
+		memset(page->image.pixels, 0, page->image.h * page->image.pitch);
+		page->shelfX = page->shelfY = page->shelfHeight = 0;
+		_atlas.push_back(page);
+	}
+
+	glyph.page = _atlas.size() - 1;
+	glyph.x = page->shelfX;
+	glyph.y = page->shelfY;
+
+	page->shelfX += glyph.w;
+	page->shelfHeight = MAX(page->shelfHeight, glyph.h);
+
+	return (uint8 *)page->image.getBasePtr(glyph.x, glyph.y);
+}
+
+bool TTFFont::cacheGlyph(Glyph &glyph, uint32 unicode) const {
+	glyph.slot = FT_Get_Char_Index(_face, unicode);
+	if (!glyph.slot)
 		return false;
 
 	// We use the light target and render mode to improve the looks of the
 	// glyphs. It is most noticable in FreeSansBold.ttf, where otherwise the
 	// 't' glyph looks like it is cut off on the right side.
-	if (FT_Load_Glyph(_face, slot, (_monochrome ? FT_LOAD_TARGET_MONO : FT_LOAD_TARGET_LIGHT)))
+	if (FT_Load_Glyph(_face, glyph.slot, (_monochrome ? FT_LOAD_TARGET_MONO : FT_LOAD_TARGET_LIGHT)))
 		return false;
 
 	if (FT_Render_Glyph(_face->glyph, (_monochrome ? FT_RENDER_MODE_MONO : FT_RENDER_MODE_LIGHT)))
@@ -413,7 +566,18 @@ bool TTFFont::cacheGlyph(Glyph &glyph, FT_UInt &slot, uint chr) {
 	}
 
 	const FT_Bitmap &bitmap = _face->glyph->bitmap;
-	glyph.image.create(bitmap.width, bitmap.rows, PixelFormat::createFormatCLUT8());
+	if (bitmap.pixel_mode != FT_PIXEL_MODE_MONO && bitmap.pixel_mode != FT_PIXEL_MODE_GRAY) {
+		warning("TTFFont::cacheGlyph: Unsupported pixel mode %d", bitmap.pixel_mode);
+		return false;
+	}
+
+	glyph.w = bitmap.width;
+	glyph.h = bitmap.rows;
+	glyph.valid = true;
+
+	// Empty glyphs, like the space, do not need any room in the atlas
+	if (!glyph.w || !glyph.h)
+		return true;
 
 	const uint8 *src = bitmap.buffer;
 	int srcPitch = bitmap.pitch;
@@ -422,41 +586,35 @@ bool TTFFont::cacheGlyph(Glyph &glyph, FT_UInt &slot, uint chr) {
 		srcPitch = -srcPitch;
 	}
 
-	uint8 *dst = (uint8 *)glyph.image.getBasePtr(0, 0);
-	memset(dst, 0, glyph.image.h * glyph.image.pitch);
+	uint8 *dst = allocateGlyph(glyph);
+	const int dstPitch = _atlas[glyph.page]->image.pitch;
 
-	switch (bitmap.pixel_mode) {
-	case FT_PIXEL_MODE_MONO:
-		for (int y = 0; y < bitmap.rows; ++y) {
+	if (bitmap.pixel_mode == FT_PIXEL_MODE_MONO) {
+		for (int y = 0; y < (int)bitmap.rows; ++y) {
 			const uint8 *curSrc = src;
+			uint8 *curDst = dst;
 			uint8 mask = 0;
 
-			for (int x = 0; x < bitmap.width; ++x) {
+			for (int x = 0; x < (int)bitmap.width; ++x) {
 				if ((x % 8) == 0)
 					mask = *curSrc++;
 
 				if (mask & 0x80)
-					*dst = 255;
+					*curDst = 255;
 
 				mask <<= 1;
-				++dst;
+				++curDst;
 			}
 
+			dst += dstPitch;
 			src += srcPitch;
 		}
-		break;
-
-	case FT_PIXEL_MODE_GRAY:
-		for (int y = 0; y < bitmap.rows; ++y) {
+	} else {
+		for (int y = 0; y < (int)bitmap.rows; ++y) {
 			memcpy(dst, src, bitmap.width);
-			dst += glyph.image.pitch;
+			dst += dstPitch;
 			src += srcPitch;
 		}
-		break;
-
-	default:
-		warning("TTFFont::cacheGlyph: Unsupported pixel mode %d", bitmap.pixel_mode);
-		return false;
 	}
 
 	return true;
@@ -45,7 +45,8 @@ static const uint8 _zigZagOrder[64] = {
 
 JPEG::JPEG() :
 	_stream(NULL), _w(0), _h(0), _numComp(0), _components(NULL), _numScanComp(0),
-	_scanComp(NULL), _currentComp(NULL) {
+	_scanComp(NULL), _currentComp(NULL), _scanData(NULL), _scanSize(0), _scanCapacity(0),
+	_bitPos(0) {
 
 	// Initialize the quantization tables
 	for (int i = 0; i < JPEG_MAX_QUANT_TABLES; i++)
@@ -62,6 +63,8 @@ JPEG::JPEG() :
 
 JPEG::~JPEG() {
 	reset();
+
+	free(_scanData);
 }
 
 Surface *JPEG::getSurface(const PixelFormat &format) {
@@ -73,26 +76,78 @@ Surface *JPEG::getSurface(const PixelFormat &format) {
 	if (format.bytesPerPixel == 1)
 		return 0;
 
-	// Get our component surfaces
-	Graphics::Surface *yComponent = getComponent(1);
-	Graphics::Surface *uComponent = getComponent(2);
-	Graphics::Surface *vComponent = getComponent(3);
+	// The output has the size of the components. They are decoded in
+	// whole MCUs, but trimmed back to the image size afterwards.
+	const Graphics::Surface *yComponent = getComponent(1);
 
 	Graphics::Surface *output = new Graphics::Surface();
 	output->create(yComponent->w, yComponent->h, format);
 
-	for (uint16 i = 0; i < output->h; i++) {
-		for (uint16 j = 0; j < output->w; j++) {
-			byte r = 0, g = 0, b = 0;
-			YUV2RGB(*((byte *)yComponent->getBasePtr(j, i)), *((byte *)uComponent->getBasePtr(j, i)), *((byte *)vComponent->getBasePtr(j, i)), r, g, b);
-			if (format.bytesPerPixel == 2)
-				*((uint16 *)output->getBasePtr(j, i)) = format.RGBToColor(r, g, b);
-			else
-				*((uint32 *)output->getBasePtr(j, i)) = format.RGBToColor(r, g, b);
+	convertToSurface(output);
+	return output;
+}
+
+namespace {
+
+template<typename PixelInt>
+void convertYUVToRGB(Surface *dst, const Surface *yComponent, const Surface *uComponent, const Surface *vComponent, uint16 w, uint16 h) {
+	// The chroma terms of YUV2RGB() for all possible values
+	int rV[256], gUV[2][256], bU[256];
+	for (int i = 0; i < 256; i++) {
+		rV[i] = (1357 * (i - 128)) >> 10;
+		gUV[0][i] = -((333 * (i - 128)) >> 10);
+		gUV[1][i] = -((691 * (i - 128)) >> 10);
+		bU[i] = (1715 * (i - 128)) >> 10;
+	}
+
+	// The clipped color components in the destination format, for all
+	// possible sums of luma and chroma terms
+	const PixelFormat &format = dst->format;
+	uint32 rColor[768], gColor[768], bColor[768];
+	for (int i = 0; i < 768; i++) {
+		const byte c = CLIP<int>(i - 256, 0, 255);
+		rColor[i] = format.RGBToColor(c, 0, 0);
+		gColor[i] = format.RGBToColor(0, c, 0);
+		bColor[i] = format.RGBToColor(0, 0, c);
+	}
+
+	for (uint16 i = 0; i < h; i++) {
+		const byte *y = (const byte *)yComponent->getBasePtr(0, i);
+		const byte *u = (const byte *)uComponent->getBasePtr(0, i);
+		const byte *v = (const byte *)vComponent->getBasePtr(0, i);
+		PixelInt *out = (PixelInt *)dst->getBasePtr(0, i);
+
+		for (uint16 j = 0; j < w; j++) {
+			const int luma = y[j] + 256;
+			out[j] = rColor[luma + rV[v[j]]] | gColor[luma + gUV[1][v[j]] + gUV[0][u[j]]] | bColor[luma + bU[u[j]]];
 		}
 	}
+}
 
-	return output;
+} // End of anonymous namespace
+
+bool JPEG::convertToSurface(Surface *dst) {
+	// Make sure we have loaded data
+	if (!isLoaded())
+		return false;
+
+	// Only accept >8bpp surfaces
+	if (dst->format.bytesPerPixel == 1)
+		return false;
+
+	// Get our component surfaces
+	const Graphics::Surface *yComponent = getComponent(1);
+	const Graphics::Surface *uComponent = getComponent(2);
+	const Graphics::Surface *vComponent = getComponent(3);
+
+	assert(dst->w >= yComponent->w && dst->h >= yComponent->h);
+
+	if (dst->format.bytesPerPixel == 2)
+		convertYUVToRGB<uint16>(dst, yComponent, uComponent, vComponent, yComponent->w, yComponent->h);
+	else
+		convertYUVToRGB<uint32>(dst, yComponent, uComponent, vComponent, yComponent->w, yComponent->h);
+
+	return true;
 }
 
 void JPEG::reset() {
@@ -327,7 +382,7 @@ bool JPEG::readDHT() {
 		// Fill the table of Huffman codes
 		cur = 0;
 		uint16 curCode = 0;
-		uint8 curCodeSize = _huff[tableNum].sizes[0];
+		uint8 curCodeSize = _huff[tableNum].count ? _huff[tableNum].sizes[0] : 0;
 		while (cur < _huff[tableNum].count) {
 			// Increase the code size to fit the request
 			while (_huff[tableNum].sizes[cur] != curCodeSize) {
@@ -340,6 +395,8 @@ bool JPEG::readDHT() {
 			curCode++;
 			cur++;
 		}
+
+		buildHuffmanLookup(_huff[tableNum]);
 	}
 
 	return true;
@@ -422,7 +479,7 @@ bool JPEG::readSOS() {
 	}
 
 	// Entropy coded sequence starts, initialize Huffman decoder
-	_bitsNumber = 0;
+	readScanData();
 
 	// Read all the scan MCUs
 	uint16 xMCU = _w / (_maxFactorH * 8);
@@ -453,7 +510,9 @@ bool JPEG::readSOS() {
 
 				if (interval == 0) {
 					interval = _restartInterval;
-					_bitsNumber = 0;
+
+					// Skip the rest of the current byte
+					_bitPos = (_bitPos + 7) & ~7;
 
 					for (byte i = 0; i < _numScanComp; i++)
 						_scanComp[i]->DCpredictor = 0;					
@@ -578,17 +637,37 @@ void JPEG::idct1D8x8(int32 src[8], int32 dest[64], int32 ps, int32 half) {
 	dest[7 * 8] = (src[0] - src[1]) >> ps;
 }
 
+// idct1D8x8() for input with only the DC value set, which results in the
+// same value for all outputs
+void JPEG::idctDC8x8(int32 src[8], int32 dest[64], int32 ps, int32 half) {
+	const int32 val = ((src[0] << 9) + half) >> ps;
+
+	for (int i = 0; i < 8; i++)
+		dest[i * 8] = val;
+}
+
 void JPEG::idct2D8x8(int32 block[64]) {
 	int32 tmp[64];
 
-	// Apply 1D IDCT to rows
-	for (int i = 0; i < 8; i++)
-		idct1D8x8(&block[i * 8], &tmp[i], 9, 1 << 8);
+	// Apply 1D IDCT to rows. Most rows of a typical block don't have
+	// any AC values.
+	for (int i = 0; i < 8; i++) {
+		const int32 *row = &block[i * 8];
+		if ((row[1] | row[2] | row[3] | row[4] | row[5] | row[6] | row[7]) == 0)
+			idctDC8x8(&block[i * 8], &tmp[i], 9, 1 << 8);
+		else
+			idct1D8x8(&block[i * 8], &tmp[i], 9, 1 << 8);
+	}
 
 	// Apply 1D IDCT to columns
-	for (int i = 0; i < 8; i++)
-		idct1D8x8(&tmp[i * 8], &block[i], 12, 1 << 11);
- }
+	for (int i = 0; i < 8; i++) {
+		const int32 *col = &tmp[i * 8];
+		if ((col[1] | col[2] | col[3] | col[4] | col[5] | col[6] | col[7]) == 0)
+			idctDC8x8(&tmp[i * 8], &block[i], 12, 1 << 11);
+		else
+			idct1D8x8(&tmp[i * 8], &block[i], 12, 1 << 11);
+	}
+}
 
 bool JPEG::readDataUnit(uint16 x, uint16 y) {
 	// Prepare an empty data array
@@ -604,31 +683,17 @@ bool JPEG::readDataUnit(uint16 x, uint16 y) {
 	readAC(readData);
 
 	// Calculate the DCT coefficients from the input sequence
+	const uint16 *quant = _quant[_currentComp->quantTableSelector];
 	int32 block[64];
 	for (uint8 i = 0; i < 64; i++) {
-		// Dequantize
-		int32 val = readData[i];
-		int16 quant = _quant[_currentComp->quantTableSelector][i];
-		val *= quant;
-
-		// Store the normalized coefficients, undoing the Zig-Zag
-		block[_zigZagOrder[i]] = val;
+		// Dequantize and store the normalized coefficients, undoing the
+		// Zig-Zag
+		block[_zigZagOrder[i]] = (int32)readData[i] * (int16)quant[i];
 	}
 
 	// Apply the IDCT
 	idct2D8x8(block);
 
-	// Level shift to make the values unsigned
-	for (int i = 0; i < 64; i++) {
-		block[i] = block[i] + 128;
-
-		if (block[i] < 0)
-			block[i] = 0;
-
-		if (block[i] > 255)
-			block[i] = 255;
-	}
-
 	// Paint the component surface
 	uint8 scalingV = _maxFactorV / _currentComp->factorV;
 	uint8 scalingH = _maxFactorH / _currentComp->factorH;
@@ -638,14 +703,23 @@ bool JPEG::readDataUnit(uint16 x, uint16 y) {
 	y <<= 3;
 
 	for (uint8 j = 0; j < 8; j++) {
+		// Level shift to make the values unsigned
+		byte line[8];
+		for (uint8 i = 0; i < 8; i++)
+			line[i] = CLIP<int32>(block[j * 8 + i] + 128, 0, 255);
+
 		for (uint16 sV = 0; sV < scalingV; sV++) {
 			// Get the beginning of the block line
 			byte *ptr = (byte *)_currentComp->surface.getBasePtr(x * scalingH, (y + j) * scalingV + sV);
 
-			for (uint8 i = 0; i < 8; i++) {
-				for (uint16 sH = 0; sH < scalingH; sH++) {
-					*ptr = (byte)(block[j * 8 + i]);
-					ptr++;
+			if (scalingH == 1) {
+				memcpy(ptr, line, 8);
+			} else {
+				for (uint8 i = 0; i < 8; i++) {
+					for (uint16 sH = 0; sH < scalingH; sH++) {
+						*ptr = line[i];
+						ptr++;
+					}
 				}
 			}
 		}
@@ -687,6 +761,10 @@ void JPEG::readAC(int16 *out) {
 		} else {
 			// Skip r values
 			cur += r;
+			if (cur >= 64) {
+				warning("JPEG: AC coefficients out of bounds");
+				break;
+			}
 
 			// Read the next value
 			out[cur] = readSignedBits(s);
@@ -696,13 +774,15 @@ void JPEG::readAC(int16 *out) {
 }
 
 int16 JPEG::readSignedBits(uint8 numBits) {
-	uint16 ret = 0;
 	if (numBits > 16)
 		error("requested %d bits", numBits); //XXX
 
+	if (numBits == 0)
+		return 0;
+
 	// MSB=0 for negatives, 1 for positives
-	for (int i = 0; i < numBits; i++)
-		ret = (ret << 1) + readBit();
+	uint16 ret = peekBits(numBits);
+	skipBits(numBits);
 
 	// Extend sign bits (PAG109)
 	if (!(ret >> (numBits - 1))) {
@@ -712,65 +792,127 @@ int16 JPEG::readSignedBits(uint8 numBits) {
 	return ret;
 }
 
-// TODO: optimize?
-uint8 JPEG::readHuff(uint8 table) {
-	bool foundCode = false;
-	uint8 val = 0;
-
-	uint8 cur = 0;
-	uint8 codeSize = 1;
-	uint16 code = readBit();
-	while (!foundCode) {
-		// Prepare a code of the current size
-		while (codeSize < _huff[table].sizes[cur]) {
-			code = (code << 1) + readBit();
-			codeSize++;
+void JPEG::buildHuffmanLookup(HuffmanTable &table) {
+	memset(table.lookup, 0, sizeof(table.lookup));
+
+	for (int size = 0; size <= 16; size++) {
+		table.maxCode[size] = -1;
+		table.valueOffset[size] = 0;
+	}
+
+	for (int cur = 0; cur < table.count; cur++) {
+		const uint8 size = table.sizes[cur];
+		const uint16 code = table.codes[cur];
+
+		// The codes of each size are consecutive
+		if (table.maxCode[size] < 0)
+			table.valueOffset[size] = cur - code;
+		table.maxCode[size] = code;
+
+		if (size <= JPEG_HUFF_LOOKUP_BITS) {
+			// Fill all the entries starting with the code
+			const int shift = JPEG_HUFF_LOOKUP_BITS - size;
+			const uint16 entry = (size << 8) | table.values[cur];
+
+			for (int i = 0; i < (1 << shift); i++)
+				table.lookup[(code << shift) | i] = entry;
 		}
+	}
+}
 
-		// Compare the codes of the current size
-		while (!foundCode && (codeSize == _huff[table].sizes[cur])) {
-			if (code == _huff[table].codes[cur]) {
-				// Found the code
-				val = _huff[table].values[cur];
-				foundCode = true;
-			} else {
-				// Continue reading
-				cur++;
-			}
+uint8 JPEG::readHuff(uint8 table) {
+	const HuffmanTable &huff = _huff[table];
+	const uint32 bits = peekBits(16);
+
+	// Short codes are decoded by a single lookup
+	const uint16 entry = huff.lookup[bits >> (16 - JPEG_HUFF_LOOKUP_BITS)];
+	if (entry) {
+		skipBits(entry >> 8);
+		return entry & 0xFF;
+	}
+
+	// Compare the longer codes by size
+	for (uint8 size = JPEG_HUFF_LOOKUP_BITS + 1; size <= 16; size++) {
+		const int32 code = bits >> (16 - size);
+		if (code <= huff.maxCode[size]) {
+			skipBits(size);
+			return huff.values[huff.valueOffset[size] + code];
 		}
 	}
 
-	return val;
+	warning("JPEG: Invalid Huffman code");
+	skipBits(16);
+	return 0;
+}
+
+inline uint32 JPEG::peekBits(uint8 numBits) const {
+	// The scan data is followed by padding, so we can always read 32 bits
+	const uint32 bits = READ_BE_UINT32(_scanData + (_bitPos >> 3)) << (_bitPos & 7);
+	return bits >> (32 - numBits);
+}
+
+inline void JPEG::skipBits(uint8 numBits) {
+	// Past the end of the data, only zeros are read
+	_bitPos = MIN<uint32>(_bitPos + numBits, _scanSize * 8);
 }
 
-uint8 JPEG::readBit() {
-	// Read a whole byte if necessary
-	if (_bitsNumber == 0) {
-		_bitsData = _stream->readByte();
-		_bitsNumber = 8;
+void JPEG::readScanData() {
+	_scanSize = 0;
+	_bitPos = 0;
 
-		// Detect markers
-		if (_bitsData == 0xFF) {
-			uint8 byte2 = _stream->readByte();
+	// Collect the data up to the next marker. Stuffed bytes are replaced
+	// by the 0xFF they stand for and restart markers are dropped. The
+	// stream is left at the marker ending the scan.
+	bool afterFF = false;
+	bool done = false;
 
-			// A stuffed 0 validates the previous byte
-			if (byte2 != 0) {
-				if (byte2 == 0xDC) {
+	byte chunk[4096];
+	while (!done) {
+		const int32 chunkStart = _stream->pos();
+		const uint32 chunkSize = _stream->read(chunk, sizeof(chunk));
+		if (chunkSize == 0)
+			break;
+
+		if (_scanSize + chunkSize + 4 > _scanCapacity) {
+			_scanCapacity = MAX<uint32>(_scanCapacity * 2, _scanSize + chunkSize + 4);
+			_scanData = (byte *)realloc(_scanData, _scanCapacity);
+		}
+
+		for (uint32 i = 0; i < chunkSize; i++) {
+			const byte b = chunk[i];
+
+			if (!afterFF) {
+				if (b == 0xFF)
+					afterFF = true;
+				else
+					_scanData[_scanSize++] = b;
+			} else if (b == 0x00) {
+				// A stuffed 0 validates the previous byte
+				_scanData[_scanSize++] = 0xFF;
+				afterFF = false;
+			} else if (b >= 0xD0 && b <= 0xD7) {
+				debug(7, "RST%d marker detected", b & 7);
+				afterFF = false;
+			} else if (b != 0xFF) {
+				if (b == 0xDC) {
 					// DNL marker: Define Number of Lines
 					// TODO: terminate scan
 					warning("DNL marker detected: terminate scan");
-				} else if (byte2 >= 0xD0 && byte2 <= 0xD7) {
-					debug(7, "RST%d marker detected", byte2 & 7);
-					_bitsData = _stream->readByte();
-				} else {
-					warning("Error: marker 0x%02X read in entropy data", byte2);
 				}
+
+				_stream->seek(chunkStart + (int32)i - 1);
+				done = true;
+				break;
 			}
 		}
 	}
-	_bitsNumber--;
 
-	return (_bitsData & (1 << _bitsNumber)) ? 1 : 0;
+	if (!_scanData) {
+		_scanCapacity = 4;
+		_scanData = (byte *)malloc(_scanCapacity);
+	}
+
+	memset(_scanData + _scanSize, 0, 4);
 }
 
 Surface *JPEG::getComponent(uint c) {
@@ -35,6 +35,7 @@ struct PixelFormat;
 
 #define JPEG_MAX_QUANT_TABLES 4
 #define JPEG_MAX_HUFF_TABLES 2
+#define JPEG_HUFF_LOOKUP_BITS 9
 
 class JPEG {
 public:
@@ -49,6 +50,16 @@ public:
 	Surface *getComponent(uint c);
 	Surface *getSurface(const PixelFormat &format);
 
+	/**
+	 * Convert the image into an existing surface, which has to be at least
+	 * as big as the components, like the one returned by getSurface().
+	 * Unlike getSurface(), this does not allocate a new surface every time,
+	 * which helps when decoding video frames.
+	 *
+	 * @return true if the image could be converted
+	 */
+	bool convertToSurface(Surface *dst);
+
 private:
 	void reset();
 
@@ -90,10 +101,19 @@ private:
 
 	// Huffman tables
 	struct HuffmanTable {
-		uint8 count;
+		uint16 count;
 		uint8 *values;
 		uint8 *sizes;
 		uint16 *codes;
+
+		// Size << 8 | value of the codes of up to JPEG_HUFF_LOOKUP_BITS bits,
+		// indexed by the next bits of the stream. 0 for longer codes.
+		uint16 lookup[1 << JPEG_HUFF_LOOKUP_BITS];
+
+		// Largest code of each size (-1 if there is none) and the offset
+		// from a code of that size to its index in values
+		int32 maxCode[17];
+		int32 valueOffset[17];
 	} _huff[2 * JPEG_MAX_HUFF_TABLES];
 
 	// Marker read functions
@@ -105,6 +125,8 @@ private:
 	bool readDRI();
 
 	// Helper functions
+	void buildHuffmanLookup(HuffmanTable &table);
+	void readScanData();
 	bool readMCU(uint16 xMCU, uint16 yMCU);
 	bool readDataUnit(uint16 x, uint16 y);
 	int16 readDC();
@@ -113,12 +135,19 @@ private:
 
 	// Huffman decoding
 	uint8 readHuff(uint8 table);
-	uint8 readBit();
-	uint8 _bitsData;
-	uint8 _bitsNumber;
+	uint32 peekBits(uint8 numBits) const;
+	void skipBits(uint8 numBits);
+
+	// Entropy coded data of the current scan, without stuffed bytes and
+	// restart markers
+	byte *_scanData;
+	uint32 _scanSize;
+	uint32 _scanCapacity;
+	uint32 _bitPos;
 
 	// Inverse Discrete Cosine Transformation
 	static void idct1D8x8(int32 src[8], int32 dest[64], int32 ps, int32 half);
+	static void idctDC8x8(int32 src[8], int32 dest[64], int32 ps, int32 half);
 	static void idct2D8x8(int32 block[64]);
 };
 
@@ -88,6 +88,11 @@
 
 #include "graphics/surface.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define YUV_USE_SSE2
+#endif
+
 namespace Graphics {
 
 class YUVToRGBLookup {
@@ -95,11 +100,12 @@ public:
 	YUVToRGBLookup(Graphics::PixelFormat format);
 	~YUVToRGBLookup();
 
+	Graphics::PixelFormat _format;
 	int16 *_colorTab;
 	uint32 *_rgbToPix;
 };
 
-YUVToRGBLookup::YUVToRGBLookup(Graphics::PixelFormat format) {
+YUVToRGBLookup::YUVToRGBLookup(Graphics::PixelFormat format) : _format(format) {
 	_colorTab = new int16[4 * 256]; // 2048 bytes
 
 	int16 *Cr_r_tab = &_colorTab[0 * 256];
@@ -198,6 +204,170 @@ namespace Graphics {
 	L = &rgbToPix[(s)]; \
 	*((PixelInt *)(d)) = (L[cr_r] | L[crb_g] | L[cb_b])
 
+#ifdef YUV_USE_SSE2
+
+/**
+ * Build pixels of the destination format out of 8 bit color components,
+ * which are given in 16 bit lanes. This is what RGBToColor() does, for
+ * eight pixels at a time.
+ */
+struct PixelPackerSSE2 {
+	__m128i rLoss, gLoss, bLoss;
+	__m128i rShift, gShift, bShift;
+	__m128i alpha16;
+
+	// For 32 bit pixels, the shifts into the lower and upper 16 bits.
+	// Shifting 16 bit lanes by 16 or more clears them.
+	bool split32;
+	__m128i rShiftLo, gShiftLo, bShiftLo;
+	__m128i rShiftHi, gShiftHi, bShiftHi;
+	__m128i alphaLo, alphaHi;
+
+	PixelPackerSSE2(const Graphics::PixelFormat &format) {
+		rLoss = _mm_cvtsi32_si128(format.rLoss);
+		gLoss = _mm_cvtsi32_si128(format.gLoss);
+		bLoss = _mm_cvtsi32_si128(format.bLoss);
+		rShift = _mm_cvtsi32_si128(format.rShift);
+		gShift = _mm_cvtsi32_si128(format.gShift);
+		bShift = _mm_cvtsi32_si128(format.bShift);
+
+		const uint32 alpha = (0xFF >> format.aLoss) << format.aShift;
+		alpha16 = _mm_set1_epi16((int16)alpha);
+
+		// Components crossing the middle of a 32 bit pixel can't be split
+		split32 = isSplittable(format.rShift, format.rLoss) &&
+		          isSplittable(format.gShift, format.gLoss) &&
+		          isSplittable(format.bShift, format.bLoss);
+
+		rShiftLo = _mm_cvtsi32_si128(format.rShift < 16 ? format.rShift : 16);
+		gShiftLo = _mm_cvtsi32_si128(format.gShift < 16 ? format.gShift : 16);
+		bShiftLo = _mm_cvtsi32_si128(format.bShift < 16 ? format.bShift : 16);
+		rShiftHi = _mm_cvtsi32_si128(format.rShift >= 16 ? format.rShift - 16 : 16);
+		gShiftHi = _mm_cvtsi32_si128(format.gShift >= 16 ? format.gShift - 16 : 16);
+		bShiftHi = _mm_cvtsi32_si128(format.bShift >= 16 ? format.bShift - 16 : 16);
+		alphaLo = _mm_set1_epi16((int16)(alpha & 0xFFFF));
+		alphaHi = _mm_set1_epi16((int16)(alpha >> 16));
+	}
+
+	static bool isSplittable(byte shift, byte loss) {
+		return shift >= 16 || shift + 8 - loss <= 16;
+	}
+
+	/** Pack eight pixels into 16 bit values. */
+	inline __m128i pack16(__m128i r, __m128i g, __m128i b) const {
+		r = _mm_sll_epi16(_mm_srl_epi16(r, rLoss), rShift);
+		g = _mm_sll_epi16(_mm_srl_epi16(g, gLoss), gShift);
+		b = _mm_sll_epi16(_mm_srl_epi16(b, bLoss), bShift);
+		return _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, alpha16));
+	}
+
+	/**
+	 * Pack eight pixels into 32 bit values, by building their lower and
+	 * upper halves in 16 bit lanes. Only usable if split32 is set.
+	 */
+	inline void pack32(__m128i *dst, __m128i r, __m128i g, __m128i b) const {
+		r = _mm_srl_epi16(r, rLoss);
+		g = _mm_srl_epi16(g, gLoss);
+		b = _mm_srl_epi16(b, bLoss);
+
+		const __m128i lo = _mm_or_si128(_mm_or_si128(_mm_sll_epi16(r, rShiftLo), _mm_sll_epi16(g, gShiftLo)),
+		                                _mm_or_si128(_mm_sll_epi16(b, bShiftLo), alphaLo));
+		const __m128i hi = _mm_or_si128(_mm_or_si128(_mm_sll_epi16(r, rShiftHi), _mm_sll_epi16(g, gShiftHi)),
+		                                _mm_or_si128(_mm_sll_epi16(b, bShiftHi), alphaHi));
+
+		dst[0] = _mm_unpacklo_epi16(lo, hi);
+		dst[1] = _mm_unpackhi_epi16(lo, hi);
+	}
+};
+
+/**
+ * Convert one row of 16 pixels and store it. The chroma values are given
+ * for eight pixel pairs. Clipping the components to 0-255 gives the same
+ * result as the spread out pixel tables.
+ */
+template<typename PixelInt>
+static inline void convertRowSSE2(byte *dstPtr, const PixelPackerSSE2 &packer, const byte *ySrc, __m128i crR, __m128i crbG, __m128i cbB) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i max = _mm_set1_epi16(255);
+	const __m128i y = _mm_loadu_si128((const __m128i *)ySrc);
+	const __m128i yLo = _mm_unpacklo_epi8(y, zero);
+	const __m128i yHi = _mm_unpackhi_epi8(y, zero);
+
+#define CLIP_COMPONENT(y, c) _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(y, c), zero), max)
+
+	const __m128i rLo = CLIP_COMPONENT(yLo, _mm_unpacklo_epi16(crR, crR));
+	const __m128i rHi = CLIP_COMPONENT(yHi, _mm_unpackhi_epi16(crR, crR));
+	const __m128i gLo = CLIP_COMPONENT(yLo, _mm_unpacklo_epi16(crbG, crbG));
+	const __m128i gHi = CLIP_COMPONENT(yHi, _mm_unpackhi_epi16(crbG, crbG));
+	const __m128i bLo = CLIP_COMPONENT(yLo, _mm_unpacklo_epi16(cbB, cbB));
+	const __m128i bHi = CLIP_COMPONENT(yHi, _mm_unpackhi_epi16(cbB, cbB));
+
+#undef CLIP_COMPONENT
+
+	__m128i pixels[4];
+	int count;
+
+	if (sizeof(PixelInt) == 2) {
+		pixels[0] = packer.pack16(rLo, gLo, bLo);
+		pixels[1] = packer.pack16(rHi, gHi, bHi);
+		count = 2;
+	} else {
+		packer.pack32(pixels + 0, rLo, gLo, bLo);
+		packer.pack32(pixels + 2, rHi, gHi, bHi);
+		count = 4;
+	}
+
+	for (int i = 0; i < count; i++)
+		_mm_storeu_si128((__m128i *)dstPtr + i, pixels[i]);
+}
+
+/**
+ * Multiply the absolute chroma values by factor / 2^(16 - preShift), then
+ * apply the sign again. This truncates towards zero like the int16 casts
+ * in the YUVToRGBLookup constructor. The factors used below give exactly
+ * the same values as the color tables for all 256 chroma values.
+ */
+#define SCALE_CHROMA(abs, sign, preShift, factor) \
+	_mm_sub_epi16(_mm_xor_si128(_mm_mulhi_epu16(_mm_slli_epi16(abs, preShift), _mm_set1_epi16((int16)factor)), sign), sign)
+
+/**
+ * Convert as many 16 pixel wide columns of a pair of rows as possible.
+ *
+ * @return the number of pixel pairs converted
+ */
+template<typename PixelInt>
+static int convertRowPairSSE2(byte *dstPtr, int dstPitch, const PixelPackerSSE2 &packer, const byte *ySrc, const byte *uSrc, const byte *vSrc, int halfWidth, int yPitch) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias = _mm_set1_epi16(128);
+
+	// Leave exotic 32 bit formats to the lookup tables
+	if (sizeof(PixelInt) == 4 && !packer.split32)
+		return 0;
+
+	int w = 0;
+	for (; w + 8 <= halfWidth; w += 8, ySrc += 16, uSrc += 8, vSrc += 8, dstPtr += 16 * sizeof(PixelInt)) {
+		const __m128i cr = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)vSrc), zero), bias);
+		const __m128i cb = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)uSrc), zero), bias);
+		const __m128i crSign = _mm_cmplt_epi16(cr, zero);
+		const __m128i cbSign = _mm_cmplt_epi16(cb, zero);
+		const __m128i crAbs = _mm_sub_epi16(_mm_xor_si128(cr, crSign), crSign);
+		const __m128i cbAbs = _mm_sub_epi16(_mm_xor_si128(cb, cbSign), cbSign);
+
+		const __m128i r = SCALE_CHROMA(crAbs, crSign, 7, 717);
+		const __m128i g = _mm_sub_epi16(_mm_sub_epi16(zero, SCALE_CHROMA(crAbs, crSign, 6, 731)), SCALE_CHROMA(cbAbs, cbSign, 3, 2821));
+		const __m128i b = SCALE_CHROMA(cbAbs, cbSign, 2, 29055);
+
+		convertRowSSE2<PixelInt>(dstPtr, packer, ySrc, r, g, b);
+		convertRowSSE2<PixelInt>(dstPtr + dstPitch, packer, ySrc + yPitch, r, g, b);
+	}
+
+	return w;
+}
+
+#undef SCALE_CHROMA
+
+#endif
+
 template<typename PixelInt>
 void convertYUV420ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
 	int halfHeight = yHeight >> 1;
@@ -210,30 +380,48 @@ void convertYUV420ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 	const int16 *Cb_b_tab = Cb_g_tab + 256;
 	const uint32 *rgbToPix = lookup->_rgbToPix;
 
+#ifdef YUV_USE_SSE2
+	const PixelPackerSSE2 packer(lookup->_format);
+#endif
+
 	for (int h = 0; h < halfHeight; h++) {
-		for (int w = 0; w < halfWidth; w++) {
+		byte *dst = dstPtr;
+		const byte *y = ySrc;
+		const byte *u = uSrc;
+		const byte *v = vSrc;
+		int w = 0;
+
+#ifdef YUV_USE_SSE2
+		w = convertRowPairSSE2<PixelInt>(dst, dstPitch, packer, y, u, v, halfWidth, yPitch);
+		dst += w * 2 * sizeof(PixelInt);
+		y += w * 2;
+		u += w;
+		v += w;
+#endif
+
+		for (; w < halfWidth; w++) {
 			register const uint32 *L;
 
-			int16 cr_r  = Cr_r_tab[*vSrc];
-			int16 crb_g = Cr_g_tab[*vSrc] + Cb_g_tab[*uSrc];
-			int16 cb_b  = Cb_b_tab[*uSrc];
-			++uSrc;
-			++vSrc;
-
-			PUT_PIXEL(*ySrc, dstPtr);
-			PUT_PIXEL(*(ySrc + yPitch), dstPtr + dstPitch);
-			ySrc++;
-			dstPtr += sizeof(PixelInt);
-			PUT_PIXEL(*ySrc, dstPtr);
-			PUT_PIXEL(*(ySrc + yPitch), dstPtr + dstPitch);
-			ySrc++;
-			dstPtr += sizeof(PixelInt);
+			int16 cr_r  = Cr_r_tab[*v];
+			int16 crb_g = Cr_g_tab[*v] + Cb_g_tab[*u];
+			int16 cb_b  = Cb_b_tab[*u];
+			++u;
+			++v;
+
+			PUT_PIXEL(*y, dst);
+			PUT_PIXEL(*(y + yPitch), dst + dstPitch);
+			y++;
+			dst += sizeof(PixelInt);
+			PUT_PIXEL(*y, dst);
+			PUT_PIXEL(*(y + yPitch), dst + dstPitch);
+			y++;
+			dst += sizeof(PixelInt);
 		}
 
-		dstPtr += dstPitch;
-		ySrc += (yPitch << 1) - yWidth;
-		uSrc += uvPitch - halfWidth;
-		vSrc += uvPitch - halfWidth;
+		dstPtr += dstPitch * 2;
+		ySrc += yPitch << 1;
+		uSrc += uvPitch;
+		vSrc += uvPitch;
 	}
 }
 
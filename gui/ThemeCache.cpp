@@ -0,0 +1,450 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/fs.h"
+#include "common/md5.h"
+#include "common/system.h"
+
+#include "graphics/VectorRenderer.h"
+
+#include "gui/ThemeCache.h"
+#include "gui/ThemeEval.h"
+#include "gui/ThemeParser.h"
+
+namespace GUI {
+
+enum {
+	kThemeCacheMagic = MKTAG('T', 'H', 'M', 'C'),
+
+	// Increase this whenever the recorded calls change
+	kThemeCacheVersion = 1
+};
+
+ThemeCache::ThemeCache(ThemeEngine *theme, const Common::String &fileName, const byte key[kKeySize])
+	: _theme(theme), _fileName(fileName), _recording(DisposeAfterUse::YES), _data(0), _dataSize(0) {
+	memcpy(_key, key, kKeySize);
+}
+
+ThemeCache::~ThemeCache() {
+	free(_data);
+}
+
+void ThemeCache::writeString(const Common::String &str) {
+	_recording.writeUint16LE(str.size());
+	_recording.write(str.c_str(), str.size());
+}
+
+Common::String ThemeCache::readString(Common::ReadStream &stream) {
+	Common::String str;
+	for (uint16 size = stream.readUint16LE(); size > 0 && !stream.eos(); --size)
+		str += (char)stream.readByte();
+	return str;
+}
+
+Common::FSNode ThemeCache::getCacheFile() const {
+	const Common::String cachePath = g_system->getCachePath();
+	if (cachePath.empty())
+		return Common::FSNode();
+
+	return Common::FSNode(cachePath).getChild(_fileName);
+}
+
+bool ThemeCache::save() {
+	Common::WriteStream *file = getCacheFile().createWriteStream();
+	if (!file)
+		return false;
+
+	_recording.writeByte(kOpEnd);
+
+	// A checksum of the recorded calls guards against damaged files
+	Common::MemoryReadStream recording(_recording.getData(), _recording.size());
+	byte digest[16];
+	Common::computeStreamMD5(recording, digest);
+
+	file->writeUint32BE(kThemeCacheMagic);
+	file->writeUint32LE(kThemeCacheVersion);
+	file->write(_key, kKeySize);
+	file->writeUint32LE(_recording.size());
+	file->write(digest, sizeof(digest));
+	file->write(_recording.getData(), _recording.size());
+	file->finalize();
+
+	const bool success = !file->err();
+	delete file;
+	return success;
+}
+
+bool ThemeCache::load() {
+	const Common::FSNode node = getCacheFile();
+	if (!node.exists())
+		return false;
+
+	Common::SeekableReadStream *file = node.createReadStream();
+	if (!file)
+		return false;
+
+	byte key[kKeySize];
+	byte digest[16];
+	bool valid = file->readUint32BE() == kThemeCacheMagic && file->readUint32LE() == kThemeCacheVersion;
+	valid = valid && file->read(key, kKeySize) == kKeySize && !memcmp(key, _key, kKeySize);
+
+	const uint32 size = file->readUint32LE();
+	valid = valid && file->read(digest, sizeof(digest)) == sizeof(digest) && size > 0;
+
+	byte *data = 0;
+	if (valid) {
+		data = (byte *)malloc(size);
+		valid = data && file->read(data, size) == size;
+	}
+	delete file;
+
+	if (valid) {
+		Common::MemoryReadStream stream(data, size);
+		byte check[16];
+		valid = Common::computeStreamMD5(stream, check) && !memcmp(check, digest, sizeof(digest));
+	}
+
+	if (!valid) {
+		free(data);
+		return false;
+	}
+
+	free(_data);
+	_data = data;
+	_dataSize = size;
+	return true;
+}
+
+bool ThemeCache::replay() {
+	Common::MemoryReadStream stream(_data, _dataSize);
+
+	while (true) {
+		const Op op = (Op)stream.readByte();
+		if (stream.eos())
+			return false;
+		if (op == kOpEnd)
+			return true;
+		if (!replayOp(op, stream))
+			return false;
+	}
+}
+
+bool ThemeCache::replayOp(Op op, Common::SeekableReadStream &stream) {
+	ThemeEval *eval = _theme->getEvaluator();
+
+	switch (op) {
+	case kOpFont: {
+		const TextData textId = (TextData)stream.readSint32LE();
+		const Common::String file = readString(stream);
+		const Common::String scalableFile = readString(stream);
+		const int pointsize = stream.readSint32LE();
+		return _theme->addFont(textId, file, scalableFile, pointsize);
+	}
+
+	case kOpTextColor: {
+		const TextColor colorId = (TextColor)stream.readSint32LE();
+		const int r = stream.readSint32LE();
+		const int g = stream.readSint32LE();
+		const int b = stream.readSint32LE();
+		return _theme->addTextColor(colorId, r, g, b);
+	}
+
+	case kOpBitmap:
+		return _theme->addBitmap(readString(stream));
+
+	case kOpCursor: {
+		const Common::String filename = readString(stream);
+		const int hotspotX = stream.readSint32LE();
+		const int hotspotY = stream.readSint32LE();
+		const int scale = stream.readSint32LE();
+		return _theme->createCursor(filename, hotspotX, hotspotY, scale);
+	}
+
+	case kOpTextData: {
+		const Common::String drawDataId = readString(stream);
+		const TextData textId = (TextData)stream.readSint32LE();
+		const TextColor colorId = (TextColor)stream.readSint32LE();
+		const Graphics::TextAlign alignH = (Graphics::TextAlign)stream.readSint32LE();
+		const ThemeEngine::TextAlignVertical alignV = (ThemeEngine::TextAlignVertical)stream.readSint32LE();
+		return _theme->addTextData(drawDataId, textId, colorId, alignH, alignV);
+	}
+
+	case kOpDrawData: {
+		const Common::String data = readString(stream);
+		const bool cached = stream.readByte() != 0;
+		return _theme->addDrawData(data, cached);
+	}
+
+	case kOpDrawStep: {
+		const Common::String drawDataId = readString(stream);
+		if (_theme->parseDrawDataId(drawDataId) == -1)
+			return false;
+
+		Graphics::DrawStep step;
+		Graphics::DrawStep::Color *colors[] = { &step.fgColor, &step.bgColor, &step.gradColor1, &step.gradColor2, &step.bevelColor };
+		for (int i = 0; i < ARRAYSIZE(colors); ++i) {
+			colors[i]->r = stream.readByte();
+			colors[i]->g = stream.readByte();
+			colors[i]->b = stream.readByte();
+			colors[i]->set = stream.readByte() != 0;
+		}
+
+		step.autoWidth = stream.readByte() != 0;
+		step.autoHeight = stream.readByte() != 0;
+		step.x = stream.readSint16LE();
+		step.y = stream.readSint16LE();
+		step.w = stream.readSint16LE();
+		step.h = stream.readSint16LE();
+		step.padding.top = stream.readSint16LE();
+		step.padding.left = stream.readSint16LE();
+		step.padding.bottom = stream.readSint16LE();
+		step.padding.right = stream.readSint16LE();
+		step.xAlign = (Graphics::DrawStep::VectorAlignment)stream.readByte();
+		step.yAlign = (Graphics::DrawStep::VectorAlignment)stream.readByte();
+		step.shadow = stream.readByte();
+		step.stroke = stream.readByte();
+		step.factor = stream.readByte();
+		step.radius = stream.readByte();
+		step.bevel = stream.readByte();
+		step.fillMode = stream.readByte();
+		step.extraData = stream.readUint32LE();
+		step.scale = stream.readUint32LE();
+
+		step.drawingCall = ThemeParser::getDrawingFunctionCallback(readString(stream));
+		if (!step.drawingCall)
+			return false;
+
+		const Common::String bitmap = readString(stream);
+		step.blitSrc = 0;
+		if (!bitmap.empty()) {
+			step.blitSrc = _theme->getBitmap(bitmap);
+			if (!step.blitSrc)
+				return false;
+		}
+
+		_theme->addDrawStep(drawDataId, step);
+		return true;
+	}
+
+	case kOpVar: {
+		const Common::String name = readString(stream);
+		eval->setVar(name, stream.readSint32LE());
+		return true;
+	}
+
+	case kOpDialog: {
+		const Common::String name = readString(stream);
+		const Common::String overlays = readString(stream);
+		const bool enabled = stream.readByte() != 0;
+		const int inset = stream.readSint32LE();
+		eval->addDialog(name, overlays, enabled, inset);
+		return true;
+	}
+
+	case kOpLayout: {
+		const ThemeLayout::LayoutType type = (ThemeLayout::LayoutType)stream.readSint32LE();
+		const int spacing = stream.readSint32LE();
+		const bool center = stream.readByte() != 0;
+		eval->addLayout(type, spacing, center);
+		return true;
+	}
+
+	case kOpWidget: {
+		const Common::String name = readString(stream);
+		const int w = stream.readSint32LE();
+		const int h = stream.readSint32LE();
+		const Common::String type = readString(stream);
+		const bool enabled = stream.readByte() != 0;
+		const Graphics::TextAlign align = (Graphics::TextAlign)stream.readSint32LE();
+		eval->addWidget(name, w, h, type, enabled, align);
+		return true;
+	}
+
+	case kOpImportedLayout:
+		return eval->addImportedLayout(readString(stream));
+
+	case kOpSpace:
+		eval->addSpace(stream.readSint32LE());
+		return true;
+
+	case kOpPadding: {
+		const int16 l = stream.readSint16LE();
+		const int16 r = stream.readSint16LE();
+		const int16 t = stream.readSint16LE();
+		const int16 b = stream.readSint16LE();
+		eval->addPadding(l, r, t, b);
+		return true;
+	}
+
+	case kOpCloseLayout:
+		eval->closeLayout();
+		return true;
+
+	case kOpCloseDialog:
+		eval->closeDialog();
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+void ThemeCache::recordFont(TextData textId, const Common::String &file, const Common::String &scalableFile, int pointsize) {
+	_recording.writeByte(kOpFont);
+	_recording.writeSint32LE(textId);
+	writeString(file);
+	writeString(scalableFile);
+	_recording.writeSint32LE(pointsize);
+}
+
+void ThemeCache::recordTextColor(TextColor colorId, int r, int g, int b) {
+	_recording.writeByte(kOpTextColor);
+	_recording.writeSint32LE(colorId);
+	_recording.writeSint32LE(r);
+	_recording.writeSint32LE(g);
+	_recording.writeSint32LE(b);
+}
+
+void ThemeCache::recordBitmap(const Common::String &filename) {
+	_recording.writeByte(kOpBitmap);
+	writeString(filename);
+}
+
+void ThemeCache::recordCursor(const Common::String &filename, int hotspotX, int hotspotY, int scale) {
+	_recording.writeByte(kOpCursor);
+	writeString(filename);
+	_recording.writeSint32LE(hotspotX);
+	_recording.writeSint32LE(hotspotY);
+	_recording.writeSint32LE(scale);
+}
+
+void ThemeCache::recordTextData(const Common::String &drawDataId, TextData textId, TextColor colorId, Graphics::TextAlign alignH, ThemeEngine::TextAlignVertical alignV) {
+	_recording.writeByte(kOpTextData);
+	writeString(drawDataId);
+	_recording.writeSint32LE(textId);
+	_recording.writeSint32LE(colorId);
+	_recording.writeSint32LE(alignH);
+	_recording.writeSint32LE(alignV);
+}
+
+void ThemeCache::recordDrawData(const Common::String &data, bool cached) {
+	_recording.writeByte(kOpDrawData);
+	writeString(data);
+	_recording.writeByte(cached);
+}
+
+void ThemeCache::recordDrawStep(const Common::String &drawDataId, const Graphics::DrawStep &step, const Common::String &bitmap) {
+	_recording.writeByte(kOpDrawStep);
+	writeString(drawDataId);
+
+	const Graphics::DrawStep::Color *colors[] = { &step.fgColor, &step.bgColor, &step.gradColor1, &step.gradColor2, &step.bevelColor };
+	for (int i = 0; i < ARRAYSIZE(colors); ++i) {
+		_recording.writeByte(colors[i]->r);
+		_recording.writeByte(colors[i]->g);
+		_recording.writeByte(colors[i]->b);
+		_recording.writeByte(colors[i]->set);
+	}
+
+	_recording.writeByte(step.autoWidth);
+	_recording.writeByte(step.autoHeight);
+	_recording.writeSint16LE(step.x);
+	_recording.writeSint16LE(step.y);
+	_recording.writeSint16LE(step.w);
+	_recording.writeSint16LE(step.h);
+	_recording.writeSint16LE(step.padding.top);
+	_recording.writeSint16LE(step.padding.left);
+	_recording.writeSint16LE(step.padding.bottom);
+	_recording.writeSint16LE(step.padding.right);
+	_recording.writeByte(step.xAlign);
+	_recording.writeByte(step.yAlign);
+	_recording.writeByte(step.shadow);
+	_recording.writeByte(step.stroke);
+	_recording.writeByte(step.factor);
+	_recording.writeByte(step.radius);
+	_recording.writeByte(step.bevel);
+	_recording.writeByte(step.fillMode);
+	_recording.writeUint32LE(step.extraData);
+	_recording.writeUint32LE(step.scale);
+
+	const char *function = ThemeParser::getDrawingFunctionName(step.drawingCall);
+	writeString(function ? function : "");
+	writeString(bitmap);
+}
+
+void ThemeCache::recordVar(const Common::String &name, int val) {
+	_recording.writeByte(kOpVar);
+	writeString(name);
+	_recording.writeSint32LE(val);
+}
+
+void ThemeCache::recordDialog(const Common::String &name, const Common::String &overlays, bool enabled, int inset) {
+	_recording.writeByte(kOpDialog);
+	writeString(name);
+	writeString(overlays);
+	_recording.writeByte(enabled);
+	_recording.writeSint32LE(inset);
+}
+
+void ThemeCache::recordLayout(ThemeLayout::LayoutType type, int spacing, bool center) {
+	_recording.writeByte(kOpLayout);
+	_recording.writeSint32LE(type);
+	_recording.writeSint32LE(spacing);
+	_recording.writeByte(center);
+}
+
+void ThemeCache::recordWidget(const Common::String &name, int w, int h, const Common::String &type, bool enabled, Graphics::TextAlign align) {
+	_recording.writeByte(kOpWidget);
+	writeString(name);
+	_recording.writeSint32LE(w);
+	_recording.writeSint32LE(h);
+	writeString(type);
+	_recording.writeByte(enabled);
+	_recording.writeSint32LE(align);
+}
+
+void ThemeCache::recordImportedLayout(const Common::String &name) {
+	_recording.writeByte(kOpImportedLayout);
+	writeString(name);
+}
+
+void ThemeCache::recordSpace(int size) {
+	_recording.writeByte(kOpSpace);
+	_recording.writeSint32LE(size);
+}
+
+void ThemeCache::recordPadding(int16 l, int16 r, int16 t, int16 b) {
+	_recording.writeByte(kOpPadding);
+	_recording.writeSint16LE(l);
+	_recording.writeSint16LE(r);
+	_recording.writeSint16LE(t);
+	_recording.writeSint16LE(b);
+}
+
+void ThemeCache::recordCloseLayout() {
+	_recording.writeByte(kOpCloseLayout);
+}
+
+void ThemeCache::recordCloseDialog() {
+	_recording.writeByte(kOpCloseDialog);
+}
+
+} // End of namespace GUI
@@ -0,0 +1,127 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GUI_THEME_CACHE_H
+#define GUI_THEME_CACHE_H
+
+#include "common/scummsys.h"
+#include "common/fs.h"
+#include "common/memstream.h"
+#include "common/str.h"
+
+#include "gui/ThemeEngine.h"
+#include "gui/ThemeLayout.h"
+
+namespace GUI {
+
+/**
+ * Compiled form of the STX files of a theme.
+ *
+ * While the STX files are parsed, the ThemeEngine and ThemeEval calls
+ * made by the parser are recorded. The recording is stored in the cache
+ * directory of the backend, see OSystem::getCachePath(), together with a
+ * key identifying the parsed sources. The next time the same theme is
+ * loaded it is replayed instead of parsing the XML again.
+ */
+class ThemeCache {
+public:
+	enum {
+		kKeySize = 16
+	};
+
+	ThemeCache(ThemeEngine *theme, const Common::String &fileName, const byte key[kKeySize]);
+	~ThemeCache();
+
+	/**
+	 * Load the cache file, if it exists and matches the key.
+	 * @return false if the cache is missing, stale or damaged
+	 */
+	bool load();
+
+	/**
+	 * Replay the calls stored in the loaded cache file.
+	 * @return false if one of the calls failed
+	 */
+	bool replay();
+
+	/** Write the calls recorded so far to the cache file. */
+	bool save();
+
+	void recordFont(TextData textId, const Common::String &file, const Common::String &scalableFile, int pointsize);
+	void recordTextColor(TextColor colorId, int r, int g, int b);
+	void recordBitmap(const Common::String &filename);
+	void recordCursor(const Common::String &filename, int hotspotX, int hotspotY, int scale);
+	void recordTextData(const Common::String &drawDataId, TextData textId, TextColor colorId, Graphics::TextAlign alignH, ThemeEngine::TextAlignVertical alignV);
+	void recordDrawData(const Common::String &data, bool cached);
+	void recordDrawStep(const Common::String &drawDataId, const Graphics::DrawStep &step, const Common::String &bitmap);
+
+	void recordVar(const Common::String &name, int val);
+	void recordDialog(const Common::String &name, const Common::String &overlays, bool enabled, int inset);
+	void recordLayout(ThemeLayout::LayoutType type, int spacing, bool center);
+	void recordWidget(const Common::String &name, int w, int h, const Common::String &type, bool enabled, Graphics::TextAlign align);
+	void recordImportedLayout(const Common::String &name);
+	void recordSpace(int size);
+	void recordPadding(int16 l, int16 r, int16 t, int16 b);
+	void recordCloseLayout();
+	void recordCloseDialog();
+
+private:
+	enum Op {
+		kOpEnd,
+		kOpFont,
+		kOpTextColor,
+		kOpBitmap,
+		kOpCursor,
+		kOpTextData,
+		kOpDrawData,
+		kOpDrawStep,
+		kOpVar,
+		kOpDialog,
+		kOpLayout,
+		kOpWidget,
+		kOpImportedLayout,
+		kOpSpace,
+		kOpPadding,
+		kOpCloseLayout,
+		kOpCloseDialog
+	};
+
+	ThemeEngine *_theme;
+	Common::String _fileName;
+	byte _key[kKeySize];
+
+	Common::MemoryWriteStreamDynamic _recording;
+
+	byte *_data;
+	uint32 _dataSize;
+
+	Common::FSNode getCacheFile() const;
+
+	void writeString(const Common::String &str);
+	static Common::String readString(Common::ReadStream &stream);
+
+	bool replayOp(Op op, Common::SeekableReadStream &stream);
+};
+
+} // End of namespace GUI
+
+#endif
@@ -24,10 +24,14 @@
 #include "common/config-manager.h"
 #include "common/file.h"
 #include "common/fs.h"
+#include "common/md5.h"
+#include "common/memstream.h"
 #include "common/unzip.h"
 #include "common/tokenizer.h"
 #include "common/translation.h"
 
+#include "base/version.h"
+
 #include "graphics/cursorman.h"
 #include "graphics/fontman.h"
 #include "graphics/imagedec.h"
@@ -37,6 +41,7 @@
 #include "graphics/fonts/ttf.h"
 
 #include "gui/widget.h"
+#include "gui/ThemeCache.h"
 #include "gui/ThemeEngine.h"
 #include "gui/ThemeEval.h"
 #include "gui/ThemeParser.h"
@@ -219,11 +224,8 @@ void ThemeItemDrawData::drawSelf(bool draw, bool restore) {
 	if (restore)
 		_engine->restoreBackground(extendedRect);
 
-	if (draw) {
-		Common::List<Graphics::DrawStep>::const_iterator step;
-		for (step = _data->_steps.begin(); step != _data->_steps.end(); ++step)
-			_engine->renderer()->drawStep(_area, *step, _dynamicData);
-	}
+	if (draw)
+		_engine->drawWidget(_data, _area, _dynamicData, extendedRect);
 
 	_engine->addDirtyRect(extendedRect);
 }
@@ -263,11 +265,12 @@ ThemeEngine::ThemeEngine(Common::String id, GraphicsMode mode) :
 	_system(0), _vectorRenderer(0),
 	_buffering(false), _bytesPerPixel(0),  _graphicsMode(kGfxDisabled),
 	_font(0), _initOk(false), _themeOk(false), _enabled(false), _themeFiles(),
-	_cursor(0) {
+	_cursor(0), _widgetCacheSize(0), _widgetCacheHits(0), _widgetCacheMisses(0) {
 
 	_system = g_system;
 	_parser = new ThemeParser(this);
 	_themeEval = new GUI::ThemeEval();
+	_themeCache = 0;
 
 	_useCursor = false;
 
@@ -302,6 +305,8 @@ ThemeEngine::ThemeEngine(Common::String id, GraphicsMode mode) :
 }
 
 ThemeEngine::~ThemeEngine() {
+	clearWidgetCache();
+
 	delete _vectorRenderer;
 	_vectorRenderer = 0;
 	_screen.free();
@@ -511,6 +516,8 @@ void ThemeEngine::setGraphicsMode(GraphicsMode mode) {
 	delete _vectorRenderer;
 	_vectorRenderer = Graphics::createRenderer(mode);
 	_vectorRenderer->setSurface(&_screen);
+
+	clearWidgetCache();
 }
 
 void WidgetDrawData::calcBackgroundOffset() {
@@ -532,12 +539,117 @@ void ThemeEngine::restoreBackground(Common::Rect r) {
 	_vectorRenderer->blitSurface(&_backBuffer, r);
 }
 
+static void copyRectFromSurface(byte *dst, const Graphics::Surface *surface, const Common::Rect &r) {
+	const uint rowSize = r.width() * surface->format.bytesPerPixel;
+	for (int y = r.top; y < r.bottom; ++y, dst += rowSize)
+		memcpy(dst, surface->getBasePtr(r.left, y), rowSize);
+}
+
+static void copyRectToSurface(Graphics::Surface *surface, const Common::Rect &r, const byte *src) {
+	const uint rowSize = r.width() * surface->format.bytesPerPixel;
+	for (int y = r.top; y < r.bottom; ++y, src += rowSize)
+		memcpy(surface->getBasePtr(r.left, y), src, rowSize);
+}
+
+static bool compareRectToSurface(const Graphics::Surface *surface, const Common::Rect &r, const byte *src) {
+	const uint rowSize = r.width() * surface->format.bytesPerPixel;
+	for (int y = r.top; y < r.bottom; ++y, src += rowSize) {
+		if (memcmp(surface->getBasePtr(r.left, y), src, rowSize))
+			return false;
+	}
+	return true;
+}
+
+void ThemeEngine::drawWidget(const WidgetDrawData *data, const Common::Rect &area, uint32 dynamicData, const Common::Rect &extendedRect) {
+	Graphics::Surface *surface = _vectorRenderer->getActiveSurface();
+
+	Common::Rect rect = extendedRect;
+	rect.clip(surface->w, surface->h);
+	const uint32 size = rect.width() * rect.height() * surface->format.bytesPerPixel;
+
+	if (rect.isEmpty() || size > kWidgetCacheMaxEntrySize || data->_steps.empty()) {
+		Common::List<Graphics::DrawStep>::const_iterator step;
+		for (step = data->_steps.begin(); step != data->_steps.end(); ++step)
+			_vectorRenderer->drawStep(area, *step, dynamicData);
+		return;
+	}
+
+	// Shadows and rounded corners are blended with the background, so the
+	// rendered pixels can only be reused on the same background
+	Common::Rect relativeRect = rect;
+	relativeRect.translate(-area.left, -area.top);
+
+	for (Common::List<CachedWidget *>::iterator i = _widgetCache.begin(); i != _widgetCache.end(); ++i) {
+		CachedWidget *widget = *i;
+		if (widget->data == data && widget->dynamicData == dynamicData
+		        && widget->width == area.width() && widget->height == area.height()
+		        && widget->rect == relativeRect && compareRectToSurface(surface, rect, widget->background)) {
+			copyRectToSurface(surface, rect, widget->pixels);
+
+			_widgetCache.erase(i);
+			_widgetCache.push_front(widget);
+			_widgetCacheHits++;
+			return;
+		}
+	}
+
+	CachedWidget *widget = new CachedWidget;
+	widget->data = data;
+	widget->dynamicData = dynamicData;
+	widget->width = area.width();
+	widget->height = area.height();
+	widget->rect = relativeRect;
+	widget->size = size;
+	widget->background = new byte[size];
+	widget->pixels = new byte[size];
+	copyRectFromSurface(widget->background, surface, rect);
+
+	Common::List<Graphics::DrawStep>::const_iterator step;
+	for (step = data->_steps.begin(); step != data->_steps.end(); ++step)
+		_vectorRenderer->drawStep(area, *step, dynamicData);
+
+	copyRectFromSurface(widget->pixels, surface, rect);
+	_widgetCache.push_front(widget);
+	_widgetCacheSize += size * 2;
+	_widgetCacheMisses++;
+
+	// Drop the least recently used widgets
+	while (_widgetCacheSize > kWidgetCacheMaxSize) {
+		CachedWidget *last = _widgetCache.back();
+		_widgetCache.pop_back();
+		_widgetCacheSize -= last->size * 2;
+		delete[] last->background;
+		delete[] last->pixels;
+		delete last;
+	}
+}
+
+void ThemeEngine::clearWidgetCache() {
+	for (Common::List<CachedWidget *>::iterator i = _widgetCache.begin(); i != _widgetCache.end(); ++i) {
+		delete[] (*i)->background;
+		delete[] (*i)->pixels;
+		delete *i;
+	}
+	_widgetCache.clear();
+	_widgetCacheSize = 0;
+}
+
 
 
 /**********************************************************
  * Theme elements management
  *********************************************************/
 void ThemeEngine::addDrawStep(const Common::String &drawDataId, const Graphics::DrawStep &step) {
+	if (_themeCache) {
+		// The bitmap is recorded by name, as it gets loaded again on replay
+		Common::String bitmap;
+		for (ImagesMap::const_iterator i = _bitmaps.begin(); i != _bitmaps.end(); ++i) {
+			if (step.blitSrc && i->_value == step.blitSrc)
+				bitmap = i->_key;
+		}
+		_themeCache->recordDrawStep(drawDataId, step, bitmap);
+	}
+
 	DrawData id = parseDrawDataId(drawDataId);
 
 	assert(_widgets[id] != 0);
@@ -545,6 +657,9 @@ void ThemeEngine::addDrawStep(const Common::String &drawDataId, const Graphics::
 }
 
 bool ThemeEngine::addTextData(const Common::String &drawDataId, TextData textId, TextColor colorId, Graphics::TextAlign alignH, TextAlignVertical alignV) {
+	if (_themeCache)
+		_themeCache->recordTextData(drawDataId, textId, colorId, alignH, alignV);
+
 	DrawData id = parseDrawDataId(drawDataId);
 
 	if (id == -1 || textId == -1 || colorId == kTextColorMAX || !_widgets[id])
@@ -559,6 +674,9 @@ bool ThemeEngine::addTextData(const Common::String &drawDataId, TextData textId,
 }
 
 bool ThemeEngine::addFont(TextData textId, const Common::String &file, const Common::String &scalableFile, const int pointsize) {
+	if (_themeCache)
+		_themeCache->recordFont(textId, file, scalableFile, pointsize);
+
 	if (textId == -1)
 		return false;
 
@@ -599,6 +717,9 @@ bool ThemeEngine::addFont(TextData textId, const Common::String &file, const Com
 }
 
 bool ThemeEngine::addTextColor(TextColor colorId, int r, int g, int b) {
+	if (_themeCache)
+		_themeCache->recordTextColor(colorId, r, g, b);
+
 	if (colorId >= kTextColorMAX)
 		return false;
 
@@ -615,6 +736,9 @@ bool ThemeEngine::addTextColor(TextColor colorId, int r, int g, int b) {
 }
 
 bool ThemeEngine::addBitmap(const Common::String &filename) {
+	if (_themeCache)
+		_themeCache->recordBitmap(filename);
+
 	// Nothing has to be done if the bitmap already has been loaded.
 	Graphics::Surface *surf = _bitmaps[filename];
 	if (surf)
@@ -641,6 +765,9 @@ bool ThemeEngine::addBitmap(const Common::String &filename) {
 }
 
 bool ThemeEngine::addDrawData(const Common::String &data, bool cached) {
+	if (_themeCache)
+		_themeCache->recordDrawData(data, cached);
+
 	DrawData id = parseDrawDataId(data);
 
 	if (id == -1)
@@ -664,6 +791,7 @@ void ThemeEngine::loadTheme(const Common::String &themeId) {
 	unloadTheme();
 
 	debug(6, "Loading theme %s", themeId.c_str());
+	const uint32 startTime = _system->getMillis();
 
 	if (themeId == "builtin") {
 		_themeOk = loadDefaultXML();
@@ -677,6 +805,8 @@ void ThemeEngine::loadTheme(const Common::String &themeId) {
 		return;
 	}
 
+	debug(2, "Loaded theme '%s' in %d ms", themeId.c_str(), _system->getMillis() - startTime);
+
 	for (int i = 0; i < kDrawDataMAX; ++i) {
 		if (_widgets[i] == 0) {
 			warning("Missing data asset: '%s'", kDrawDataDefaults[i].name);
@@ -687,8 +817,8 @@ void ThemeEngine::loadTheme(const Common::String &themeId) {
 }
 
 void ThemeEngine::unloadTheme() {
-	if (!_themeOk)
-		return;
+	// Also called for partially loaded themes, so do not check _themeOk
+	clearWidgetCache();
 
 	for (int i = 0; i < kDrawDataMAX; ++i) {
 		delete _widgets[i];
@@ -720,17 +850,18 @@ bool ThemeEngine::loadDefaultXML() {
 #include "themes/default.inc"
 	    ;
 
-	if (!_parser->loadBuffer((const byte *)defaultXML, strlen(defaultXML)))
-		return false;
-
 	_themeName = "ScummVM Classic Theme (Builtin Version)";
 	_themeId = "builtin";
 	_themeFile.clear();
 
-	bool result = _parser->parse();
-	_parser->close();
+	Common::Array<ThemeSource> sources;
+	ThemeSource source;
+	source.name = "builtin";
+	source.data = (const byte *)defaultXML;
+	source.size = strlen(defaultXML);
+	sources.push_back(source);
 
-	return result;
+	return loadThemeSources(sources);
 #else
 	warning("The built-in theme is not enabled in the current build. Please load an external theme");
 	return false;
@@ -767,28 +898,107 @@ bool ThemeEngine::loadThemeXML(const Common::String &themeId) {
 	}
 
 	//
-	// Loop over all STX files, load and parse them
+	// Read all STX files, then load them
 	//
+	Common::Array<ThemeSource> sources;
+	bool result = true;
 	for (Common::ArchiveMemberList::iterator i = members.begin(); i != members.end(); ++i) {
 		assert((*i)->getName().hasSuffix(".stx"));
 
-		if (_parser->loadStream((*i)->createReadStream()) == false) {
-			warning("Failed to load STX file '%s'", (*i)->getDisplayName().c_str());
-			_parser->close();
-			return false;
+		Common::SeekableReadStream *stream = (*i)->createReadStream();
+		ThemeSource source;
+		source.name = (*i)->getDisplayName();
+		source.size = stream ? stream->size() : 0;
+
+		byte *data = (byte *)malloc(source.size);
+		source.data = data;
+		if (!stream || (source.size && (!data || stream->read(data, source.size) != source.size))) {
+			warning("Failed to load STX file '%s'", source.name.c_str());
+			free(data);
+			result = false;
+		} else {
+			sources.push_back(source);
 		}
+		delete stream;
 
-		if (_parser->parse() == false) {
-			warning("Failed to parse STX file '%s'", (*i)->getDisplayName().c_str());
-			_parser->close();
-			return false;
+		if (!result)
+			break;
+	}
+
+	if (result)
+		result = loadThemeSources(sources);
+
+	for (uint i = 0; i < sources.size(); ++i)
+		free(const_cast<byte *>(sources[i].data));
+
+	if (!result)
+		return false;
+
+	assert(!_themeName.empty());
+	return true;
+}
+
+bool ThemeEngine::loadThemeSources(const Common::Array<ThemeSource> &sources) {
+	// The cache is keyed on the sources, on the overlay size which the
+	// layouts depend on, and on the ScummVM version which parsed them
+	Common::MemoryWriteStreamDynamic keyData(DisposeAfterUse::YES);
+	keyData.writeString(gScummVMFullVersion);
+	keyData.writeUint16LE(_system->getOverlayWidth());
+	keyData.writeUint16LE(_system->getOverlayHeight());
+	for (uint i = 0; i < sources.size(); ++i) {
+		Common::MemoryReadStream stream(sources[i].data, sources[i].size);
+		byte digest[16];
+		Common::computeStreamMD5(stream, digest);
+		keyData.write(digest, sizeof(digest));
+	}
+
+	Common::MemoryReadStream keyStream(keyData.getData(), keyData.size());
+	byte key[ThemeCache::kKeySize];
+	Common::computeStreamMD5(keyStream, key);
+
+	Common::String cacheName = "theme-";
+	for (const char *c = _themeId.c_str(); *c; ++c) {
+		if (Common::isAlnum(*c) || *c == '-' || *c == '_')
+			cacheName += *c;
+	}
+	cacheName += Common::String::format("-%dx%d.cache", _system->getOverlayWidth(), _system->getOverlayHeight());
+
+	ThemeCache cache(this, cacheName, key);
+	if (cache.load()) {
+		debug(2, "Replaying theme cache '%s'", cacheName.c_str());
+		if (cache.replay())
+			return true;
+
+		// Throw away what the cache has set up so far and parse the
+		// sources instead, which also replaces the cache file
+		warning("Failed to replay theme cache '%s'", cacheName.c_str());
+		unloadTheme();
+	}
+
+	// Record the parsed data while parsing the STX files
+	_themeCache = &cache;
+	_themeEval->setThemeCache(&cache);
+
+	bool result = true;
+	for (uint i = 0; i < sources.size() && result; ++i) {
+		if (_parser->loadBuffer(sources[i].data, sources[i].size) == false) {
+			warning("Failed to load STX file '%s'", sources[i].name.c_str());
+			result = false;
+		} else if (_parser->parse() == false) {
+			warning("Failed to parse STX file '%s'", sources[i].name.c_str());
+			result = false;
 		}
 
 		_parser->close();
 	}
 
-	assert(!_themeName.empty());
-	return true;
+	_themeCache = 0;
+	_themeEval->setThemeCache(0);
+
+	if (result && !cache.save())
+		debug(2, "Failed to write theme cache '%s'", cacheName.c_str());
+
+	return result;
 }
 
 
@@ -1277,6 +1487,9 @@ void ThemeEngine::openDialog(bool doBuffer, ShadingStyle style) {
 }
 
 bool ThemeEngine::createCursor(const Common::String &filename, int hotspotX, int hotspotY, int scale) {
+	if (_themeCache)
+		_themeCache->recordCursor(filename, hotspotX, hotspotY, scale);
+
 	if (!_system->hasFeature(OSystem::kFeatureCursorPalette))
 		return true;
 
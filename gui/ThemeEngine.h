@@ -24,10 +24,12 @@
 #define GUI_THEME_ENGINE_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
 #include "common/fs.h"
 #include "common/hash-str.h"
 #include "common/hashmap.h"
 #include "common/list.h"
+#include "common/rect.h"
 #include "common/str.h"
 
 #include "graphics/surface.h"
@@ -39,10 +41,6 @@
 
 class OSystem;
 
-namespace Common {
-struct Rect;
-}
-
 namespace Graphics {
 struct DrawStep;
 class VectorRenderer;
@@ -55,6 +53,7 @@ struct TextDrawData;
 struct TextColorData;
 class Dialog;
 class GuiObject;
+class ThemeCache;
 class ThemeEval;
 class ThemeItem;
 class ThemeParser;
@@ -504,6 +503,30 @@ public:
 	 */
 	void restoreBackground(Common::Rect r);
 
+	/**
+	 * Draws the steps of a DrawData set on the active surface. If the same
+	 * set was drawn before with the same size and dynamic data, on the same
+	 * background, the pixels rendered then are copied instead.
+	 *
+	 * @param data        DrawData set to draw.
+	 * @param area        Area of the widget.
+	 * @param dynamicData Dynamic data of the draw steps.
+	 * @param extendedRect Area the steps may touch, including shadows.
+	 */
+	void drawWidget(const WidgetDrawData *data, const Common::Rect &area, uint32 dynamicData, const Common::Rect &extendedRect);
+
+	/** Drops all widgets from the widget cache. */
+	void clearWidgetCache();
+
+	/**
+	 * Returns how many widgets were copied from the widget cache, and how
+	 * many had to be rendered.
+	 */
+	void getWidgetCacheStats(uint32 &hits, uint32 &misses) const {
+		hits = _widgetCacheHits;
+		misses = _widgetCacheMisses;
+	}
+
 	const Common::String &getThemeName() const { return _themeName; }
 	const Common::String &getThemeId() const { return _themeId; }
 	int getGraphicsMode() const { return _graphicsMode; }
@@ -534,6 +557,19 @@ protected:
 	 */
 	bool loadDefaultXML();
 
+	struct ThemeSource {
+		Common::String name;
+		const byte *data;
+		uint32 size;
+	};
+
+	/**
+	 * Parses the given STX sources, or replays the results of parsing them
+	 * from the theme cache, if they were cached before for the current
+	 * overlay size.
+	 */
+	bool loadThemeSources(const Common::Array<ThemeSource> &sources);
+
 	/**
 	 * Unloads the currently loaded theme so another one can
 	 * be loaded.
@@ -607,6 +643,9 @@ protected:
 	/** Theme getEvaluator (changed from GUI::Eval to add functionality) */
 	GUI::ThemeEval *_themeEval;
 
+	/** Records the parsed theme data while the STX files are parsed, otherwise 0 */
+	GUI::ThemeCache *_themeCache;
+
 	/** Main screen surface. This is blitted straight into the overlay. */
 	Graphics::Surface _screen;
 
@@ -641,6 +680,31 @@ protected:
 
 	ImagesMap _bitmaps;
 	Graphics::PixelFormat _overlayFormat;
+
+	enum {
+		/** Maximum memory used by the widget cache, in bytes */
+		kWidgetCacheMaxSize = 4 * 1024 * 1024,
+
+		/** Widgets with more pixel data than this are not cached */
+		kWidgetCacheMaxEntrySize = 512 * 1024
+	};
+
+	/** A rendered widget, together with the background it was rendered on. */
+	struct CachedWidget {
+		const WidgetDrawData *data;
+		uint32 dynamicData;
+		int16 width, height;	///< Size of the widget area
+		Common::Rect rect;		///< Cached pixels, relative to the widget area
+		uint32 size;			///< Size of each pixel buffer, in bytes
+		byte *background;
+		byte *pixels;
+	};
+
+	/** Cached widgets, the most recently used first */
+	Common::List<CachedWidget *> _widgetCache;
+	uint32 _widgetCacheSize;
+	uint32 _widgetCacheHits;
+	uint32 _widgetCacheMisses;
 #ifdef USE_RGB_COLOR
 	Graphics::PixelFormat _cursorFormat;
 #endif
@@ -20,6 +20,7 @@
  *
  */
 
+#include "gui/ThemeCache.h"
 #include "gui/ThemeEval.h"
 
 #include "graphics/scaler.h"
@@ -50,6 +51,13 @@ void ThemeEval::reset() {
 	_layouts.clear();
 }
 
+void ThemeEval::setVar(const Common::String &name, int val) {
+	if (_themeCache)
+		_themeCache->recordVar(name, val);
+
+	_vars[name] = val;
+}
+
 bool ThemeEval::getWidgetData(const Common::String &widget, int16 &x, int16 &y, uint16 &w, uint16 &h) {
 	Common::StringTokenizer tokenizer(widget, ".");
 
@@ -81,6 +89,9 @@ Graphics::TextAlign ThemeEval::getWidgetTextHAlign(const Common::String &widget)
 }
 
 void ThemeEval::addWidget(const Common::String &name, int w, int h, const Common::String &type, bool enabled, Graphics::TextAlign align) {
+	if (_themeCache)
+		_themeCache->recordWidget(name, w, h, type, enabled, align);
+
 	int typeW = -1;
 	int typeH = -1;
 	Graphics::TextAlign typeAlign = Graphics::kTextAlignInvalid;
@@ -97,10 +108,13 @@ void ThemeEval::addWidget(const Common::String &name, int w, int h, const Common
 								typeAlign == Graphics::kTextAlignInvalid ? align : typeAlign);
 
 	_curLayout.top()->addChild(widget);
-	setVar(_curDialog + "." + name + ".Enabled", enabled ? 1 : 0);
+	_vars[_curDialog + "." + name + ".Enabled"] = enabled ? 1 : 0;
 }
 
 void ThemeEval::addDialog(const Common::String &name, const Common::String &overlays, bool enabled, int inset) {
+	if (_themeCache)
+		_themeCache->recordDialog(name, overlays, enabled, inset);
+
 	int16 x, y;
 	uint16 w, h;
 
@@ -131,10 +145,13 @@ void ThemeEval::addDialog(const Common::String &name, const Common::String &over
 
 	_curLayout.push(layout);
 	_curDialog = name;
-	setVar(name + ".Enabled", enabled ? 1 : 0);
+	_vars[name + ".Enabled"] = enabled ? 1 : 0;
 }
 
 void ThemeEval::addLayout(ThemeLayout::LayoutType type, int spacing, bool center) {
+	if (_themeCache)
+		_themeCache->recordLayout(type, spacing, center);
+
 	ThemeLayout *layout = 0;
 
 	if (spacing == -1)
@@ -156,11 +173,17 @@ void ThemeEval::addLayout(ThemeLayout::LayoutType type, int spacing, bool center
 }
 
 void ThemeEval::addSpace(int size) {
+	if (_themeCache)
+		_themeCache->recordSpace(size);
+
 	ThemeLayout *space = new ThemeLayoutSpacing(_curLayout.top(), size);
 	_curLayout.top()->addChild(space);
 }
 
 bool ThemeEval::addImportedLayout(const Common::String &name) {
+	if (_themeCache)
+		_themeCache->recordImportedLayout(name);
+
 	if (!_layouts.contains(name))
 		return false;
 
@@ -168,4 +191,26 @@ bool ThemeEval::addImportedLayout(const Common::String &name) {
 	return true;
 }
 
+void ThemeEval::addPadding(int16 l, int16 r, int16 t, int16 b) {
+	if (_themeCache)
+		_themeCache->recordPadding(l, r, t, b);
+
+	_curLayout.top()->setPadding(l, r, t, b);
+}
+
+void ThemeEval::closeLayout() {
+	if (_themeCache)
+		_themeCache->recordCloseLayout();
+
+	_curLayout.pop();
+}
+
+void ThemeEval::closeDialog() {
+	if (_themeCache)
+		_themeCache->recordCloseDialog();
+
+	_curLayout.pop()->reflowLayout();
+	_curDialog.clear();
+}
+
 } // End of namespace GUI
@@ -35,13 +35,15 @@
 
 namespace GUI {
 
+class ThemeCache;
+
 class ThemeEval {
 
 	typedef Common::HashMap<Common::String, int> VariablesMap;
 	typedef Common::HashMap<Common::String, ThemeLayout *> LayoutsMap;
 
 public:
-	ThemeEval() {
+	ThemeEval() : _themeCache(0) {
 		buildBuiltinVars();
 	}
 
@@ -70,7 +72,7 @@ public:
 		return def;
 	}
 
-	void setVar(const Common::String &name, int val) { _vars[name] = val; }
+	void setVar(const Common::String &name, int val);
 
 	bool hasVar(const Common::String &name) { return _vars.contains(name) || _builtin.contains(name); }
 
@@ -80,10 +82,10 @@ public:
 	bool addImportedLayout(const Common::String &name);
 	void addSpace(int size);
 
-	void addPadding(int16 l, int16 r, int16 t, int16 b) { _curLayout.top()->setPadding(l, r, t, b); }
+	void addPadding(int16 l, int16 r, int16 t, int16 b);
 
-	void closeLayout() { _curLayout.pop(); }
-	void closeDialog() { _curLayout.pop()->reflowLayout(); _curDialog.clear(); }
+	void closeLayout();
+	void closeDialog();
 
 	bool getWidgetData(const Common::String &widget, int16 &x, int16 &y, uint16 &w, uint16 &h);
 
@@ -97,6 +99,9 @@ public:
 
 	void reset();
 
+	/** Set the cache to record the changes to the layouts in, or 0. */
+	void setThemeCache(ThemeCache *cache) { _themeCache = cache; }
+
 private:
 	VariablesMap _vars;
 	VariablesMap _builtin;
@@ -104,6 +109,8 @@ private:
 	LayoutsMap _layouts;
 	Common::Stack<ThemeLayout *> _curLayout;
 	Common::String _curDialog;
+
+	ThemeCache *_themeCache;
 };
 
 } // End of namespace GUI
@@ -26,6 +26,8 @@
 #include "common/scummsys.h"
 #include "common/xmlparser.h"
 
+#include "graphics/VectorRenderer.h"
+
 namespace GUI {
 
 class ThemeEngine;
@@ -47,6 +49,13 @@ public:
 		return true;
 	}
 
+	/**
+	 * Map the name of a drawing function, as used in the "func" property
+	 * of draw steps, to the function, and back.
+	 */
+	static Graphics::DrawingFunctionCallback getDrawingFunctionCallback(const Common::String &name);
+	static const char *getDrawingFunctionName(Graphics::DrawingFunctionCallback callback);
+
 protected:
 	ThemeEngine *_theme;
 
@@ -53,7 +53,7 @@ enum {
 
 // Constructor
 GuiManager::GuiManager() : _redrawStatus(kRedrawDisabled), _stateIsSaved(false),
-    _cursorAnimateCounter(0), _cursorAnimateTimer(0) {
+    _runLoopCount(0), _cursorAnimateCounter(0), _cursorAnimateTimer(0) {
 	_theme = 0;
 	_useStdCursor = false;
 
@@ -259,6 +259,8 @@ void GuiManager::runLoop() {
 	if (activeDialog == 0)
 		return;
 
+	_runLoopCount++;
+
 	if (!_stateIsSaved) {
 		saveState();
 		_theme->enable();
@@ -283,7 +285,15 @@ void GuiManager::runLoop() {
 
 	bool tooltipCheck = false;
 
+	// Frame time statistics
+	uint32 frameCount = 0, frameTime = 0, frameTimeMax = 0;
+	uint32 cacheHitsStart, cacheMissesStart;
+	_theme->getWidgetCacheStats(cacheHitsStart, cacheMissesStart);
+
 	while (!_dialogStack.empty() && activeDialog == getTopDialog() && !eventMan->shouldQuit()) {
+		const uint32 frameStart = _system->getMillis();
+		const uint32 runLoopCount = _runLoopCount;
+
 		redraw();
 
 		// Don't "tickle" the dialog until the theme has had a chance
@@ -376,6 +386,13 @@ void GuiManager::runLoop() {
 			}
 		}
 
+		if (runLoopCount == _runLoopCount) {
+			const uint32 duration = _system->getMillis() - frameStart;
+			frameCount++;
+			frameTime += duration;
+			frameTimeMax = MAX(frameTimeMax, duration);
+		}
+
 		if (tooltipCheck && _lastMousePosition.time + kTooltipDelay < _system->getMillis()) {
 			Widget *wdg = activeDialog->findWidget(_lastMousePosition.x, _lastMousePosition.y);
 			if (wdg && wdg->getTooltip()) {
@@ -401,6 +418,13 @@ void GuiManager::runLoop() {
 	if (eventMan->shouldQuit() && activeDialog == getTopDialog())
 		getTopDialog()->close();
 
+	if (frameCount) {
+		uint32 cacheHits, cacheMisses;
+		_theme->getWidgetCacheStats(cacheHits, cacheMisses);
+		debug(3, "GUI: %d frames, %d ms on average, %d ms at most; %d widgets from cache, %d rendered",
+		      frameCount, frameTime / frameCount, frameTimeMax, cacheHits - cacheHitsStart, cacheMisses - cacheMissesStart);
+	}
+
 	if (didSaveState) {
 		_theme->disable();
 		restoreState();
@@ -114,6 +114,10 @@ protected:
 
 	bool		_useStdCursor;
 
+	// Number of run loops started, used to leave frames during which a
+	// nested run loop was active out of the frame time statistics
+	uint32		_runLoopCount;
+
 	// position and time of last mouse click (used to detect double clicks)
 	struct {
 		int16 x, y;	// Position of mouse when the click occurred
@@ -19,6 +19,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
+#include "engines/advancedDetector.h"
 #include "engines/metaengine.h"
 #include "common/algorithm.h"
 #include "common/config-manager.h"
@@ -62,6 +63,7 @@ MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 	_dirsScanned(0),
 	_oldGamesCount(0),
 	_dirTotal(0),
+	_hashCache(new ADHashCacheScope()),
 	_okButton(0),
 	_dirProgressText(0),
 	_gameProgressText(0) {
@@ -131,6 +133,10 @@ struct GameDescLess {
 };
 
 
+MassAddDialog::~MassAddDialog() {
+	delete _hashCache;
+}
+
 void MassAddDialog::handleCommand(CommandSender *sender, uint32 cmd, uint32 data) {
 #if defined(USE_TASKBAR)
 	// Remove progress bar and count from taskbar
@@ -252,6 +258,9 @@ void MassAddDialog::handleTickle() {
 	Common::String buf;
 
 	if (_scanStack.empty()) {
+		delete _hashCache;
+		_hashCache = 0;
+
 		// Enable the OK button
 		_okButton->setEnabled(true);
 
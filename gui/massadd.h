@@ -28,6 +28,8 @@
 #include "common/stack.h"
 #include "common/str.h"
 
+class ADHashCacheScope;
+
 namespace GUI {
 
 class StaticTextWidget;
@@ -36,6 +38,7 @@ class MassAddDialog : public Dialog {
 	typedef Common::Array<Common::String> StringArray;
 public:
 	MassAddDialog(const Common::FSNode &startDir);
+	~MassAddDialog();
 
 	//void open();
 	void handleCommand(CommandSender *sender, uint32 cmd, uint32 data);
@@ -62,6 +65,13 @@ private:
 	int _oldGamesCount;
 	int _dirTotal;
 
+	/**
+	 * Keeps the file hashes of the detectors until the scan is complete,
+	 * since the directories scanned overlap with the subdirectories some
+	 * engines look into.
+	 */
+	ADHashCacheScope *_hashCache;
+
 	Widget *_okButton;
 	StaticTextWidget *_dirProgressText;
 	StaticTextWidget *_gameProgressText;
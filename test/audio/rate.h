@@ -0,0 +1,296 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiostream.h"
+#include "audio/mixer.h"
+#include "audio/rate.h"
+#include "audio/decoders/raw.h"
+
+#include "common/endian.h"
+#include "common/memstream.h"
+
+class RateConverterTestSuite : public CxxTest::TestSuite
+{
+private:
+	static Audio::AudioStream *makeStream(const int16 *samples, int numSamples, int rate, bool isStereo) {
+		byte *data = (byte *)malloc(numSamples * 2);
+		for (int i = 0; i < numSamples; ++i)
+			WRITE_LE_UINT16(data + i * 2, samples[i]);
+
+		Common::SeekableReadStream *stream = new Common::MemoryReadStream(data, numSamples * 2, DisposeAfterUse::YES);
+		return Audio::makeRawStream(stream, rate, Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN | (isStereo ? Audio::FLAG_STEREO : 0));
+	}
+
+	static int16 *createSamples(int numSamples) {
+		int16 *samples = new int16[numSamples];
+		uint32 seed = 0x12345678;
+		for (int i = 0; i < numSamples; ++i) {
+			seed = seed * 1103515245 + 12345;
+			samples[i] = (int16)(seed >> 16);
+		}
+		// Make sure the extremes are covered, too
+		samples[0] = -32768;
+		samples[1] = 32767;
+		return samples;
+	}
+
+	/**
+	 * Mix input frames into output with the same rules as the converters
+	 * use, i.e. scale, round towards zero and clip.
+	 */
+	static void referenceMix(int16 *out, const int16 *in, int frames, bool isStereo, bool reverseStereo, int volL, int volR) {
+		for (int i = 0; i < frames; ++i) {
+			const int in0 = isStereo ? in[i * 2] : in[i];
+			const int in1 = isStereo ? in[i * 2 + 1] : in0;
+			Audio::clampedAdd(out[i * 2 + (reverseStereo ? 1 : 0)], (in0 * volL) / Audio::Mixer::kMaxMixerVolume);
+			Audio::clampedAdd(out[i * 2 + (reverseStereo ? 0 : 1)], (in1 * volR) / Audio::Mixer::kMaxMixerVolume);
+		}
+	}
+
+	/**
+	 * Mix the given samples with a converter for equal rates into an output
+	 * buffer starting out with createSamples() noise.
+	 */
+	static int16 *copyMix(const int16 *samples, int frames, bool isStereo, bool reverseStereo, int volL, int volR) {
+		int16 *output = createSamples(frames * 2);
+
+		Audio::AudioStream *s = makeStream(samples, frames * (isStereo ? 2 : 1), 22050, isStereo);
+		Audio::RateConverter *conv = Audio::makeRateConverter(22050, 22050, isStereo, reverseStereo);
+		TS_ASSERT_EQUALS(conv->flow(*s, output, frames, volL, volR), frames);
+
+		delete conv;
+		delete s;
+		return output;
+	}
+
+public:
+	void test_copy_mono() {
+		const int frames = 1001;
+		int16 *samples = createSamples(frames);
+
+		// Start from non-silent output so clipping on accumulation is tested
+		int16 *expected = createSamples(frames * 2);
+		referenceMix(expected, samples, frames, false, false, 256, 256);
+
+		int16 *output = copyMix(samples, frames, false, false, 256, 256);
+		TS_ASSERT_EQUALS(memcmp(expected, output, frames * 2 * sizeof(int16)), 0);
+
+		delete[] output;
+		delete[] expected;
+		delete[] samples;
+	}
+
+	void test_copy_mono_volume() {
+		const int frames = 1001;
+		int16 *samples = createSamples(frames);
+
+		int16 *expected = createSamples(frames * 2);
+		referenceMix(expected, samples, frames, false, false, 17, 200);
+
+		int16 *output = copyMix(samples, frames, false, false, 17, 200);
+		TS_ASSERT_EQUALS(memcmp(expected, output, frames * 2 * sizeof(int16)), 0);
+
+		delete[] output;
+		delete[] expected;
+		delete[] samples;
+	}
+
+	void test_copy_stereo() {
+		const int frames = 1003;
+		int16 *samples = createSamples(frames * 2);
+
+		int16 *expected = createSamples(frames * 2);
+		referenceMix(expected, samples, frames, true, false, 256, 256);
+
+		int16 *output = copyMix(samples, frames, true, false, 256, 256);
+		TS_ASSERT_EQUALS(memcmp(expected, output, frames * 2 * sizeof(int16)), 0);
+
+		delete[] output;
+		delete[] expected;
+		delete[] samples;
+	}
+
+	void test_copy_stereo_volume() {
+		const int frames = 1003;
+		int16 *samples = createSamples(frames * 2);
+
+		int16 *expected = createSamples(frames * 2);
+		referenceMix(expected, samples, frames, true, false, 0, 129);
+
+		int16 *output = copyMix(samples, frames, true, false, 0, 129);
+		TS_ASSERT_EQUALS(memcmp(expected, output, frames * 2 * sizeof(int16)), 0);
+
+		delete[] output;
+		delete[] expected;
+		delete[] samples;
+	}
+
+	void test_copy_reverse_stereo() {
+		const int frames = 1002;
+		int16 *samples = createSamples(frames * 2);
+
+		int16 *expected = createSamples(frames * 2);
+		referenceMix(expected, samples, frames, true, true, 256, 255);
+
+		int16 *output = copyMix(samples, frames, true, true, 256, 255);
+		TS_ASSERT_EQUALS(memcmp(expected, output, frames * 2 * sizeof(int16)), 0);
+
+		delete[] output;
+		delete[] expected;
+		delete[] samples;
+	}
+
+	void test_copy_reverse_stereo_volume() {
+		const int frames = 1002;
+		int16 *samples = createSamples(frames * 2);
+
+		int16 *expected = createSamples(frames * 2);
+		referenceMix(expected, samples, frames, true, true, 90, 1);
+
+		int16 *output = copyMix(samples, frames, true, true, 90, 1);
+		TS_ASSERT_EQUALS(memcmp(expected, output, frames * 2 * sizeof(int16)), 0);
+
+		delete[] output;
+		delete[] expected;
+		delete[] samples;
+	}
+
+	void test_simple_mono() {
+		const int frames = 777;
+		int16 *samples = createSamples(frames * 2);
+
+		// Halving the rate picks every second sample, starting with the second
+		int16 *decimated = new int16[frames];
+		for (int i = 0; i < frames; ++i)
+			decimated[i] = samples[i * 2 + 1];
+
+		int16 *expected = new int16[frames * 2];
+		int16 *output = new int16[frames * 2];
+		memset(expected, 0, frames * 2 * sizeof(int16));
+		memset(output, 0, frames * 2 * sizeof(int16));
+		referenceMix(expected, decimated, frames, false, false, 200, 100);
+
+		Audio::AudioStream *s = makeStream(samples, frames * 2, 44100, false);
+		Audio::RateConverter *conv = Audio::makeRateConverter(44100, 22050, false);
+
+		TS_ASSERT_EQUALS(conv->flow(*s, output, frames, 200, 100), frames);
+		TS_ASSERT_EQUALS(memcmp(expected, output, frames * 2 * sizeof(int16)), 0);
+
+		delete conv;
+		delete s;
+		delete[] output;
+		delete[] expected;
+		delete[] decimated;
+		delete[] samples;
+	}
+
+	void test_sinc_constant() {
+		const int frames = 2000;
+		int16 *samples = new int16[frames];
+		for (int i = 0; i < frames; ++i)
+			samples[i] = 10000;
+
+		int16 *output = new int16[frames * 4];
+		memset(output, 0, frames * 4 * sizeof(int16));
+
+		Audio::AudioStream *s = makeStream(samples, frames, 22050, false);
+		Audio::RateConverter *conv = Audio::makeRateConverter(22050, 44100, false, false, Audio::kRateConverterQualityMedium);
+
+		TS_ASSERT_EQUALS(conv->flow(*s, output, frames * 2, 256, 256), frames * 2);
+
+		// Away from the start and the end, a constant signal stays constant,
+		// except for the rounding of the filter coefficients
+		for (int i = 64; i < frames * 2 - 64; ++i) {
+			TS_ASSERT_LESS_THAN(ABS(output[i * 2] - 10000), 16);
+			TS_ASSERT_EQUALS(output[i * 2], output[i * 2 + 1]);
+		}
+
+		delete conv;
+		delete s;
+		delete[] output;
+		delete[] samples;
+	}
+
+	void test_sinc_length() {
+		const int frames = 1000;
+		int16 *samples = createSamples(frames * 2);
+
+		// ceil(1000 * 48000 / 22050) output frames for 1000 input frames
+		const int expected = 2177;
+		int16 *output = new int16[expected * 4];
+		memset(output, 0, expected * 4 * sizeof(int16));
+
+		Audio::AudioStream *s = makeStream(samples, frames * 2, 22050, true);
+		Audio::RateConverter *conv = Audio::makeRateConverter(22050, 48000, true, false, Audio::kRateConverterQualityHigh);
+
+		// Ask for more than there is
+		TS_ASSERT_EQUALS(conv->flow(*s, output, expected * 2, 256, 256), expected);
+		TS_ASSERT(conv->isDrained());
+
+		delete conv;
+		delete s;
+		delete[] output;
+		delete[] samples;
+	}
+
+	void test_sinc_flush() {
+		const int frames = 1000;
+		const int expected = 2177;
+		int16 *samples = createSamples(frames);
+
+		// Convert everything in one go
+		int16 *reference = new int16[(expected + 100) * 2];
+		memset(reference, 0, (expected + 100) * 2 * sizeof(int16));
+
+		Audio::AudioStream *s = makeStream(samples, frames, 22050, false);
+		Audio::RateConverter *conv = Audio::makeRateConverter(22050, 48000, false, false, Audio::kRateConverterQualityMedium);
+		TS_ASSERT_EQUALS(conv->flow(*s, reference, expected + 100, 256, 256), expected);
+		delete conv;
+		delete s;
+
+		// Stop calling flow() once the input is used up, as the mixer does,
+		// and get the rest of the output with drain()
+		int16 *output = new int16[(expected + 100) * 2];
+		memset(output, 0, (expected + 100) * 2 * sizeof(int16));
+
+		s = makeStream(samples, frames, 22050, false);
+		conv = Audio::makeRateConverter(22050, 48000, false, false, Audio::kRateConverterQualityMedium);
+
+		int done = 0;
+		while (!s->endOfData() && done < expected)
+			done += conv->flow(*s, output + done * 2, 100, 256, 256);
+
+		TS_ASSERT_LESS_THAN(done, expected);
+		TS_ASSERT(!conv->isDrained());
+
+		for (int i = 0; i < 100 && !conv->isDrained() && done <= expected; i++)
+			done += conv->drain(output + done * 2, 100, 256, 256);
+
+		TS_ASSERT(conv->isDrained());
+		TS_ASSERT_EQUALS(done, expected);
+		TS_ASSERT_EQUALS(memcmp(reference, output, expected * 2 * sizeof(int16)), 0);
+
+		delete conv;
+		delete s;
+		delete[] output;
+		delete[] reference;
+		delete[] samples;
+	}
+
+	void test_sinc_fallback() {
+		// Downsampling by a factor the sinc filter can't buffer falls back
+		// to the linear converter
+		const int frames = 25600;
+		int16 *samples = createSamples(frames);
+		int16 output[200];
+		memset(output, 0, sizeof(output));
+
+		Audio::AudioStream *s = makeStream(samples, frames, 25600, false);
+		Audio::RateConverter *conv = Audio::makeRateConverter(25600, 99, false, false, Audio::kRateConverterQualityHigh);
+
+		TS_ASSERT_EQUALS(conv->flow(*s, output, 50, 256, 256), 50);
+
+		delete conv;
+		delete s;
+		delete[] samples;
+	}
+};
@@ -0,0 +1,235 @@
+#include <cxxtest/TestSuite.h>
+
+#include "backends/timer/default/default-timer.h"
+
+class TimerQueueTestSuite : public CxxTest::TestSuite
+{
+	private:
+	/**
+	 * A timer queue running on a clock which only advances when told to.
+	 */
+	class FakeClockQueue : public DefaultTimerQueue {
+	public:
+		uint32 now;
+
+		FakeClockQueue() : now(0) {}
+
+	protected:
+		virtual uint32 getMillis() const { return now; }
+	};
+
+	struct Counter {
+		FakeClockQueue *queue;
+		int count;
+		uint32 cost;	// milliseconds each call takes
+		DefaultTimerQueue::TimerProc proc;
+		int *log;
+		int id;
+		bool removeSelf;
+	};
+
+	static void initCounter(Counter &counter, FakeClockQueue *queue, int id, int *log = 0) {
+		memset(&counter, 0, sizeof(counter));
+		counter.queue = queue;
+		counter.id = id;
+		counter.log = log;
+	}
+
+	static void countProc(void *refCon) {
+		Counter *counter = (Counter *)refCon;
+		counter->count++;
+		counter->queue->now += counter->cost;
+		if (counter->log) {
+			int *entry = counter->log;
+			while (*entry)
+				entry++;
+			*entry = counter->id;
+		}
+		if (counter->removeSelf)
+			counter->queue->remove(counter->proc);
+	}
+
+	static void countProc2(void *refCon) {
+		countProc(refCon);
+	}
+
+	static void countProc3(void *refCon) {
+		countProc(refCon);
+	}
+
+	static void runUntil(FakeClockQueue &queue, uint32 time) {
+		while (queue.now < time) {
+			queue.now++;
+			queue.fire();
+		}
+	}
+
+	public:
+	void test_fire_counts() {
+		FakeClockQueue queue;
+		Counter a, b, c;
+		initCounter(a, &queue, 1);
+		initCounter(b, &queue, 2);
+		initCounter(c, &queue, 3);
+
+		queue.install(countProc, 10000, &a, "a");
+		queue.install(countProc2, 3000, &b, "b");
+		queue.install(countProc3, 1500, &c, "c");
+		TS_ASSERT_EQUALS(queue.size(), 3u);
+
+		// Timers fire once their fire time has passed; sub-millisecond
+		// intervals must not accumulate any drift
+		runUntil(queue, 3000);
+		TS_ASSERT_EQUALS(a.count, 299);
+		TS_ASSERT_EQUALS(b.count, 999);
+		TS_ASSERT_EQUALS(c.count, 1999);
+
+		DefaultTimerQueue::Stats stats;
+		TS_ASSERT(queue.getStats("C", stats));
+		TS_ASSERT_EQUALS(stats.fires, 1999u);
+		TS_ASSERT_EQUALS(stats.lateFires[0], 1999u);
+		TS_ASSERT_EQUALS(stats.maxLateness, 0u);
+		TS_ASSERT(!queue.getStats("d", stats));
+	}
+
+	void test_order() {
+		FakeClockQueue queue;
+		int log[16];
+		memset(log, 0, sizeof(log));
+
+		Counter a, b, c;
+		initCounter(a, &queue, 1, log);
+		initCounter(b, &queue, 2, log);
+		initCounter(c, &queue, 3, log);
+
+		queue.install(countProc, 5000, &a, "a");
+		queue.install(countProc2, 2000, &b, "b");
+		queue.install(countProc3, 5000, &c, "c");
+
+		// Due timers fire by fire time, and in installation order on ties
+		queue.now = 6;
+		queue.fire();
+		static const int expected[] = { 2, 2, 1, 3, 0 };
+		for (int i = 0; i < ARRAYSIZE(expected); i++)
+			TS_ASSERT_EQUALS(log[i], expected[i]);
+	}
+
+	void test_catch_up() {
+		FakeClockQueue queue;
+		Counter a, b;
+		initCounter(a, &queue, 1);
+		initCounter(b, &queue, 2);
+
+		queue.install(countProc, 10000, &a, "a");
+		runUntil(queue, 100);
+		TS_ASSERT_EQUALS(a.count, 9);
+
+		// By default, all missed periods are made up for at once
+		queue.now = 200;
+		queue.fire();
+		TS_ASSERT_EQUALS(a.count, 19);
+
+		DefaultTimerQueue::Stats stats;
+		TS_ASSERT(queue.getStats("a", stats));
+		TS_ASSERT_EQUALS(stats.maxLateness, 99u);
+		TS_ASSERT_EQUALS(stats.lateFires[DefaultTimerQueue::kLateBuckets - 1], 9u);
+		TS_ASSERT_EQUALS(stats.resyncs, 0u);
+
+		// With a limit, the timer is rescheduled from the current time
+		queue.setMaxCatchUp(2);
+		queue.now = 300;
+		queue.fire();
+		TS_ASSERT_EQUALS(a.count, 20);
+		runUntil(queue, 310);
+		TS_ASSERT_EQUALS(a.count, 20);
+		runUntil(queue, 311);
+		TS_ASSERT_EQUALS(a.count, 21);
+
+		// ... but not when it is only a few periods late
+		queue.now = 332;
+		queue.fire();
+		TS_ASSERT_EQUALS(a.count, 23);
+
+		TS_ASSERT(queue.getStats("a", stats));
+		TS_ASSERT_EQUALS(stats.resyncs, 1u);
+
+		queue.resetStats();
+		TS_ASSERT(queue.getStats("a", stats));
+		TS_ASSERT_EQUALS(stats.fires, 0u);
+	}
+
+	void test_remove() {
+		FakeClockQueue queue;
+		Counter a, b, c;
+		initCounter(a, &queue, 1);
+		initCounter(b, &queue, 2);
+		initCounter(c, &queue, 3);
+		c.cost = 2;
+		c.proc = countProc3;
+		c.removeSelf = true;
+
+		queue.install(countProc, 4000, &a, "a");
+		queue.install(countProc2, 7000, &b, "b");
+		queue.install(countProc3, 3000, &c, "c");
+
+		// The callback taking time is accounted for, and removes itself
+		runUntil(queue, 4);
+		TS_ASSERT_EQUALS(c.count, 1);
+		TS_ASSERT_EQUALS(queue.size(), 2u);
+
+		queue.remove(countProc);
+		TS_ASSERT_EQUALS(queue.size(), 1u);
+		runUntil(queue, 100);
+		TS_ASSERT_EQUALS(a.count, 0);
+		TS_ASSERT_EQUALS(b.count, 14);
+		TS_ASSERT_EQUALS(c.count, 1);
+
+		DefaultTimerQueue::Stats stats;
+		TS_ASSERT(queue.getStats("b", stats));
+		TS_ASSERT_EQUALS(stats.totalDuration, 0u);
+
+		// Timers installed later take their place in the schedule
+		queue.install(countProc, 1000, &a, "a");
+		runUntil(queue, 110);
+		TS_ASSERT_EQUALS(a.count, 9);
+		TS_ASSERT_EQUALS(b.count, 15);
+	}
+
+	void test_remove_all_instances() {
+		FakeClockQueue queue;
+		Counter a, b;
+		initCounter(a, &queue, 1);
+		initCounter(b, &queue, 2);
+
+		// Removing the first instance of countProc at heap index 3 moves
+		// the second one from the end of the heap up to index 1, before
+		// the position reached by the search
+		static const uint32 intervals[] = { 1000, 5000, 3000, 10000, 20000, 30000, 4000 };
+		for (int i = 0; i < ARRAYSIZE(intervals); i++) {
+			const bool isA = (intervals[i] == 10000 || intervals[i] == 4000);
+			queue.install(isA ? countProc : countProc2, intervals[i], isA ? &a : &b, "t");
+		}
+
+		queue.remove(countProc);
+		TS_ASSERT_EQUALS(queue.size(), 5u);
+		runUntil(queue, 20);
+		TS_ASSERT_EQUALS(a.count, 0);
+	}
+
+	void test_duration() {
+		FakeClockQueue queue;
+		Counter a;
+		initCounter(a, &queue, 1);
+		a.cost = 3;
+
+		queue.install(countProc, 10000, &a, "a");
+		runUntil(queue, 50);
+
+		// Calls at 11, 21, 31 and 41
+		DefaultTimerQueue::Stats stats;
+		TS_ASSERT(queue.getStats("a", stats));
+		TS_ASSERT_EQUALS(stats.fires, 4u);
+		TS_ASSERT_EQUALS(stats.totalDuration, 12u);
+		TS_ASSERT_EQUALS(stats.maxDuration, 3u);
+	}
+};
@@ -0,0 +1,199 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/bitstream.h"
+#include "common/memstream.h"
+
+class BitStreamTestSuite : public CxxTest::TestSuite
+{
+	private:
+	static void fillData(byte *data, int size) {
+		uint32 seed = 0xBADC0DE;
+		for (int i = 0; i < size; i++) {
+			seed = seed * 1103515245 + 12345;
+			data[i] = (byte)(seed >> 16);
+		}
+	}
+
+	/**
+	 * Read the same data once with getBits() and once bit by bit with
+	 * getBit(), in chunks of all possible sizes, and compare.
+	 */
+	static void compareGetBits(Common::BitStream &bits, Common::BitStream &single) {
+		for (uint8 n = 1; n <= 32; n++) {
+			uint32 expected = 0;
+			for (uint8 i = 0; i < n; i++) {
+				if (single.isMSBFirst())
+					expected = (expected << 1) | single.getBit();
+				else
+					expected |= single.getBit() << i;
+			}
+
+			TS_ASSERT_EQUALS(bits.peekBits(n), expected);
+			TS_ASSERT_EQUALS(bits.getBits(n), expected);
+			TS_ASSERT_EQUALS(bits.pos(), single.pos());
+		}
+	}
+
+	public:
+	void test_get_bits_8msb() {
+		byte data[160];
+		fillData(data, sizeof(data));
+
+		Common::MemoryReadStream ms1(data, sizeof(data));
+		Common::MemoryReadStream ms2(data, sizeof(data));
+		Common::BitStream8MSB bits(ms1);
+		Common::BitStream8MSB single(ms2);
+		compareGetBits(bits, single);
+	}
+
+	void test_get_bits_8lsb() {
+		byte data[160];
+		fillData(data, sizeof(data));
+
+		Common::MemoryReadStream ms1(data, sizeof(data));
+		Common::MemoryReadStream ms2(data, sizeof(data));
+		Common::BitStream8LSB bits(ms1);
+		Common::BitStream8LSB single(ms2);
+		compareGetBits(bits, single);
+	}
+
+	void test_get_bits_16lemsb() {
+		byte data[160];
+		fillData(data, sizeof(data));
+
+		Common::MemoryReadStream ms1(data, sizeof(data));
+		Common::MemoryReadStream ms2(data, sizeof(data));
+		Common::BitStream16LEMSB bits(ms1);
+		Common::BitStream16LEMSB single(ms2);
+		compareGetBits(bits, single);
+	}
+
+	void test_get_bits_16belsb() {
+		byte data[160];
+		fillData(data, sizeof(data));
+
+		Common::MemoryReadStream ms1(data, sizeof(data));
+		Common::MemoryReadStream ms2(data, sizeof(data));
+		Common::BitStream16BELSB bits(ms1);
+		Common::BitStream16BELSB single(ms2);
+		compareGetBits(bits, single);
+	}
+
+	void test_get_bits_32lemsb() {
+		byte data[160];
+		fillData(data, sizeof(data));
+
+		Common::MemoryReadStream ms1(data, sizeof(data));
+		Common::MemoryReadStream ms2(data, sizeof(data));
+		Common::BitStream32LEMSB bits(ms1);
+		Common::BitStream32LEMSB single(ms2);
+		compareGetBits(bits, single);
+	}
+
+	void test_get_bits_32lelsb() {
+		byte data[160];
+		fillData(data, sizeof(data));
+
+		Common::MemoryReadStream ms1(data, sizeof(data));
+		Common::MemoryReadStream ms2(data, sizeof(data));
+		Common::BitStream32LELSB bits(ms1);
+		Common::BitStream32LELSB single(ms2);
+		compareGetBits(bits, single);
+	}
+
+	void test_get_bits_32bemsb() {
+		byte data[160];
+		fillData(data, sizeof(data));
+
+		Common::MemoryReadStream ms1(data, sizeof(data));
+		Common::MemoryReadStream ms2(data, sizeof(data));
+		Common::BitStream32BEMSB bits(ms1);
+		Common::BitStream32BEMSB single(ms2);
+		compareGetBits(bits, single);
+	}
+
+	void test_msb_first() {
+		byte contents[] = { 0x80, 0x00, 0x00, 0x00 };
+
+		Common::MemoryReadStream ms1(contents, sizeof(contents));
+		Common::BitStream8MSB msb8(ms1);
+		TS_ASSERT(msb8.isMSBFirst());
+		TS_ASSERT_EQUALS(msb8.getBits(1), 1u);
+
+		Common::MemoryReadStream ms2(contents, sizeof(contents));
+		Common::BitStream8LSB lsb8(ms2);
+		TS_ASSERT(!lsb8.isMSBFirst());
+		TS_ASSERT_EQUALS(lsb8.getBits(8), 0x80u);
+
+		Common::MemoryReadStream ms3(contents, sizeof(contents));
+		Common::BitStream16BEMSB msb16(ms3);
+		TS_ASSERT(msb16.isMSBFirst());
+		TS_ASSERT_EQUALS(msb16.getBits(1), 1u);
+
+		Common::MemoryReadStream ms4(contents, sizeof(contents));
+		Common::BitStream32LELSB lsb32(ms4);
+		TS_ASSERT(!lsb32.isMSBFirst());
+		TS_ASSERT_EQUALS(lsb32.getBits(8), 0x80u);
+	}
+
+	void test_get_bits_order() {
+		byte contents[] = { 0x53, 0xA1 };
+
+		Common::MemoryReadStream ms1(contents, sizeof(contents));
+		Common::BitStream8MSB msb(ms1);
+		TS_ASSERT_EQUALS(msb.getBits(4), 0x5u);
+		TS_ASSERT_EQUALS(msb.getBits(8), 0x3Au);
+		TS_ASSERT_EQUALS(msb.getBits(4), 0x1u);
+
+		Common::MemoryReadStream ms2(contents, sizeof(contents));
+		Common::BitStream8LSB lsb(ms2);
+		TS_ASSERT_EQUALS(lsb.getBits(4), 0x3u);
+		TS_ASSERT_EQUALS(lsb.getBits(8), 0x15u);
+		TS_ASSERT_EQUALS(lsb.getBits(4), 0xAu);
+	}
+
+	void test_skip() {
+		byte data[64];
+		fillData(data, sizeof(data));
+
+		Common::MemoryReadStream ms1(data, sizeof(data));
+		Common::MemoryReadStream ms2(data, sizeof(data));
+		Common::BitStream32LELSB bits(ms1);
+		Common::BitStream32LELSB single(ms2);
+
+		bits.skip(77);
+		for (int i = 0; i < 77; i++)
+			single.getBit();
+
+		TS_ASSERT_EQUALS(bits.pos(), 77u);
+		TS_ASSERT_EQUALS(bits.getBits(20), single.getBits(20));
+
+		bits.skip(64);
+		single.skip(32);
+		single.skip(32);
+
+		TS_ASSERT_EQUALS(bits.pos(), single.pos());
+		TS_ASSERT_EQUALS(bits.getBits(32), single.getBits(32));
+	}
+
+	void test_peek_bits_end() {
+		byte contents[] = { 0x53, 0xA1 };
+
+		// Peeking up to the very end of the stream, from within a value
+		Common::MemoryReadStream ms1(contents, sizeof(contents));
+		Common::BitStream8MSB msb(ms1);
+		msb.skip(4);
+		TS_ASSERT_EQUALS(msb.peekBits(12), 0x3A1u);
+		TS_ASSERT_EQUALS(msb.pos(), 4u);
+		msb.skip(8);
+		TS_ASSERT_EQUALS(msb.peekBits(4), 0x1u);
+		TS_ASSERT_EQUALS(msb.pos(), 12u);
+
+		Common::MemoryReadStream ms2(contents, sizeof(contents));
+		Common::BitStream8LSB lsb(ms2);
+		lsb.skip(4);
+		TS_ASSERT_EQUALS(lsb.peekBits(12), 0xA15u);
+		TS_ASSERT_EQUALS(lsb.getBits(12), 0xA15u);
+		TS_ASSERT(lsb.eos());
+	}
+};
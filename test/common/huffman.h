@@ -0,0 +1,221 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/bitstream.h"
+#include "common/huffman.h"
+#include "common/memstream.h"
+
+class HuffmanTestSuite : public CxxTest::TestSuite
+{
+	private:
+	enum {
+		kCodeCount = 24
+	};
+
+	uint32 _codes[kCodeCount];
+	uint8 _lengths[kCodeCount];
+
+	/**
+	 * Writes codes to a buffer, in the bit order a bitstream will hand them
+	 * out again.
+	 */
+	class BitWriter {
+		byte *_data;
+		uint32 _pos;
+		bool _msbFirst;
+
+	public:
+		BitWriter(byte *data, bool msbFirst) : _data(data), _pos(0), _msbFirst(msbFirst) {}
+
+		void putBit(uint32 bit) {
+			if (bit)
+				_data[_pos >> 3] |= _msbFirst ? (0x80 >> (_pos & 7)) : (1 << (_pos & 7));
+			_pos++;
+		}
+
+		void putCode(uint32 code, uint8 length) {
+			for (uint8 i = 0; i < length; i++)
+				putBit(_msbFirst ? ((code >> (length - 1 - i)) & 1) : ((code >> i) & 1));
+		}
+
+		uint32 pos() const { return _pos; }
+	};
+
+	/**
+	 * Sets up a canonical prefix code with lengths from 2 up to 17 bits,
+	 * so that the decoder needs more than one level of lookup tables. For
+	 * LSB first bitstreams, the codes are reversed, so that they stay prefix
+	 * free in the order the bits are read in.
+	 */
+	void createCodes(bool msbFirst) {
+		static const uint8 lengths[kCodeCount] = {
+			2, 3, 3, 4, 4, 5, 5, 6, 7, 8, 9, 9, 10, 11, 11, 12, 13, 14, 15, 16, 17, 17, 17, 17
+		};
+
+		uint32 code = 0;
+		uint8 lastLength = lengths[0];
+
+		for (int i = 0; i < kCodeCount; i++) {
+			code <<= lengths[i] - lastLength;
+			lastLength = lengths[i];
+
+			uint32 c = code;
+			if (!msbFirst) {
+				c = 0;
+				for (uint8 j = 0; j < lengths[i]; j++)
+					c |= ((code >> j) & 1) << (lengths[i] - 1 - j);
+			}
+
+			// Shuffle the codes around, so that they aren't sorted by length
+			const int index = (i * 7) % kCodeCount;
+			_codes[index] = c;
+			_lengths[index] = lengths[i];
+
+			code++;
+		}
+	}
+
+	enum {
+		kSymbolCount = 2000
+	};
+
+	/**
+	 * Encodes a pseudo random sequence of codes. Returns the number of bytes
+	 * up to the end of the 32-bit value holding the last code, so that the
+	 * decoder has to deal with streams ending before its lookup width.
+	 */
+	uint32 encode(byte *data, bool msbFirst, int *indices, uint32 &bitCount) {
+		memset(data, 0, kSymbolCount * 4);
+
+		BitWriter writer(data, msbFirst);
+		uint32 seed = 0x1234;
+		for (int i = 0; i < kSymbolCount; i++) {
+			seed = seed * 1103515245 + 12345;
+			indices[i] = (seed >> 16) % kCodeCount;
+			writer.putCode(_codes[indices[i]], _lengths[indices[i]]);
+		}
+
+		bitCount = writer.pos();
+		return ((bitCount + 31) / 32) * 4;
+	}
+
+	public:
+	void test_decode_8msb() {
+		createCodes(true);
+		Common::Huffman huffman(0, kCodeCount, _codes, _lengths);
+
+		byte data[kSymbolCount * 4];
+		int indices[kSymbolCount];
+		uint32 bitCount;
+		Common::MemoryReadStream ms(data, encode(data, true, indices, bitCount));
+		Common::BitStream8MSB bits(ms);
+
+		for (int i = 0; i < kSymbolCount; i++)
+			TS_ASSERT_EQUALS(huffman.getSymbol(bits), (uint32)indices[i]);
+		TS_ASSERT_EQUALS(bits.pos(), bitCount);
+	}
+
+	void test_decode_16bemsb() {
+		createCodes(true);
+		Common::Huffman huffman(0, kCodeCount, _codes, _lengths);
+
+		byte data[kSymbolCount * 4];
+		int indices[kSymbolCount];
+		uint32 bitCount;
+		Common::MemoryReadStream ms(data, encode(data, true, indices, bitCount));
+		Common::BitStream16BEMSB bits(ms);
+
+		for (int i = 0; i < kSymbolCount; i++)
+			TS_ASSERT_EQUALS(huffman.getSymbol(bits), (uint32)indices[i]);
+		TS_ASSERT_EQUALS(bits.pos(), bitCount);
+	}
+
+	void test_decode_8lsb() {
+		createCodes(false);
+		Common::Huffman huffman(0, kCodeCount, _codes, _lengths);
+
+		byte data[kSymbolCount * 4];
+		int indices[kSymbolCount];
+		uint32 bitCount;
+		Common::MemoryReadStream ms(data, encode(data, false, indices, bitCount));
+		Common::BitStream8LSB bits(ms);
+
+		for (int i = 0; i < kSymbolCount; i++)
+			TS_ASSERT_EQUALS(huffman.getSymbol(bits), (uint32)indices[i]);
+		TS_ASSERT_EQUALS(bits.pos(), bitCount);
+	}
+
+	void test_decode_32lelsb() {
+		createCodes(false);
+		Common::Huffman huffman(0, kCodeCount, _codes, _lengths);
+
+		byte data[kSymbolCount * 4];
+		int indices[kSymbolCount];
+		uint32 bitCount;
+		Common::MemoryReadStream ms(data, encode(data, false, indices, bitCount));
+		Common::BitStream32LELSB bits(ms);
+
+		for (int i = 0; i < kSymbolCount; i++)
+			TS_ASSERT_EQUALS(huffman.getSymbol(bits), (uint32)indices[i]);
+		TS_ASSERT_EQUALS(bits.pos(), bitCount);
+	}
+
+	void test_decode_symbols() {
+		createCodes(false);
+
+		uint32 symbols[kCodeCount];
+		for (int i = 0; i < kCodeCount; i++)
+			symbols[i] = 1000 + i * 3;
+
+		Common::Huffman huffman(0, kCodeCount, _codes, _lengths, symbols);
+
+		byte data[kSymbolCount * 4];
+		int indices[kSymbolCount];
+		uint32 bitCount;
+		Common::MemoryReadStream ms(data, encode(data, false, indices, bitCount));
+		Common::BitStream32LELSB bits(ms);
+
+		for (int i = 0; i < kSymbolCount; i++)
+			TS_ASSERT_EQUALS(huffman.getSymbol(bits), symbols[indices[i]]);
+		TS_ASSERT_EQUALS(bits.pos(), bitCount);
+	}
+
+	void test_short_stream() {
+		// A 1-bit code, read from a stream shorter than the lookup tables
+		static const uint32 codes[] = { 0, 2, 3 };
+		static const uint8 lengths[] = { 1, 2, 2 };
+		Common::Huffman huffman(0, 3, codes, lengths);
+
+		byte contents[] = { 0x2C };
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+		Common::BitStream8MSB bits(ms);
+
+		TS_ASSERT_EQUALS(huffman.getSymbol(bits), 0u);
+		TS_ASSERT_EQUALS(huffman.getSymbol(bits), 0u);
+		TS_ASSERT_EQUALS(huffman.getSymbol(bits), 1u);
+		TS_ASSERT_EQUALS(huffman.getSymbol(bits), 2u);
+		TS_ASSERT_EQUALS(huffman.getSymbol(bits), 0u);
+		TS_ASSERT_EQUALS(huffman.getSymbol(bits), 0u);
+		TS_ASSERT_EQUALS(bits.pos(), 8u);
+	}
+
+	void test_set_symbols() {
+		static const uint32 codes[] = { 0, 2, 3 };
+		static const uint8 lengths[] = { 1, 2, 2 };
+		static const uint32 symbols[] = { 7, 8, 9 };
+		Common::Huffman huffman(0, 3, codes, lengths);
+
+		byte contents[] = { 0x6C };
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+		Common::BitStream8MSB bits(ms);
+
+		TS_ASSERT_EQUALS(huffman.getSymbol(bits), 0u);
+		TS_ASSERT_EQUALS(huffman.getSymbol(bits), 2u);
+
+		huffman.setSymbols(symbols);
+		TS_ASSERT_EQUALS(huffman.getSymbol(bits), 7u);
+		TS_ASSERT_EQUALS(huffman.getSymbol(bits), 9u);
+
+		huffman.setSymbols();
+		TS_ASSERT_EQUALS(huffman.getSymbol(bits), 0u);
+	}
+};
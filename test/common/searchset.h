@@ -0,0 +1,185 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/memstream.h"
+#include "common/str-array.h"
+
+class SearchSetTestSuite : public CxxTest::TestSuite
+{
+	private:
+	/**
+	 * An archive holding a fixed set of one byte files. Reading a file
+	 * returns the id of the archive.
+	 */
+	class TestArchive : public Common::Archive {
+		Common::StringArray _files;
+		byte _id;
+
+	public:
+		TestArchive(byte id) : _id(id) {}
+
+		void addFile(const Common::String &name) { _files.push_back(name); }
+
+		void removeFile(const Common::String &name) {
+			for (uint i = 0; i < _files.size(); i++)
+				if (_files[i].equalsIgnoreCase(name))
+					_files.remove_at(i--);
+		}
+
+		virtual bool hasFile(const Common::String &name) const {
+			for (uint i = 0; i < _files.size(); i++)
+				if (_files[i].equalsIgnoreCase(name))
+					return true;
+			return false;
+		}
+
+		virtual int listMembers(Common::ArchiveMemberList &list) const {
+			for (uint i = 0; i < _files.size(); i++)
+				list.push_back(Common::ArchiveMemberPtr(new Common::GenericArchiveMember(_files[i], this)));
+			return _files.size();
+		}
+
+		virtual const Common::ArchiveMemberPtr getMember(const Common::String &name) const {
+			if (!hasFile(name))
+				return Common::ArchiveMemberPtr();
+			return Common::ArchiveMemberPtr(new Common::GenericArchiveMember(name, this));
+		}
+
+		virtual Common::SeekableReadStream *createReadStreamForMember(const Common::String &name) const {
+			if (!hasFile(name))
+				return 0;
+			return new Common::MemoryReadStream(&_id, 1);
+		}
+	};
+
+	static int readId(const Common::SearchSet &set, const Common::String &name) {
+		Common::SeekableReadStream *stream = set.createReadStreamForMember(name);
+		if (!stream)
+			return -1;
+		int id = stream->readByte();
+		delete stream;
+		return id;
+	}
+
+	/**
+	 * Adds "low" with priority 0, holding shared.dat and low.dat, and "high"
+	 * with priority 10, holding shared.dat. Returns the "low" archive.
+	 */
+	static TestArchive *addArchives(Common::SearchSet &set) {
+		TestArchive *low = new TestArchive(1);
+		low->addFile("shared.dat");
+		low->addFile("low.dat");
+		set.add("low", low, 0);
+
+		TestArchive *high = new TestArchive(2);
+		high->addFile("shared.dat");
+		set.add("high", high, 10);
+
+		return low;
+	}
+
+	public:
+	void test_lookup() {
+		Common::SearchSet set;
+		addArchives(set);
+
+		TS_ASSERT(set.hasFile("low.dat"));
+		TS_ASSERT(!set.hasFile("missing.dat"));
+		TS_ASSERT_EQUALS(readId(set, "shared.dat"), 2);
+		TS_ASSERT_EQUALS(readId(set, "SHARED.DAT"), 2);
+		TS_ASSERT_EQUALS(readId(set, "low.dat"), 1);
+		TS_ASSERT_EQUALS(readId(set, "missing.dat"), -1);
+	}
+
+	void test_lookup_name_index() {
+		Common::SearchSet set;
+		set.setUseNameIndex(true);
+		addArchives(set);
+
+		// Look everything up twice, the second time through the index
+		for (int i = 0; i < 2; i++) {
+			TS_ASSERT(set.hasFile("low.dat"));
+			TS_ASSERT(!set.hasFile("missing.dat"));
+			TS_ASSERT_EQUALS(readId(set, "shared.dat"), 2);
+			TS_ASSERT_EQUALS(readId(set, "SHARED.DAT"), 2);
+			TS_ASSERT_EQUALS(readId(set, "low.dat"), 1);
+			TS_ASSERT_EQUALS(readId(set, "missing.dat"), -1);
+		}
+	}
+
+	void test_set_priority() {
+		Common::SearchSet set;
+		addArchives(set);
+
+		set.setPriority("low", 20);
+		TS_ASSERT_EQUALS(readId(set, "shared.dat"), 1);
+		TS_ASSERT(set.getMember("shared.dat") != 0);
+	}
+
+	void test_set_priority_name_index() {
+		Common::SearchSet set;
+		set.setUseNameIndex(true);
+		addArchives(set);
+
+		TS_ASSERT_EQUALS(readId(set, "shared.dat"), 2);
+		set.setPriority("low", 20);
+		TS_ASSERT_EQUALS(readId(set, "shared.dat"), 1);
+		TS_ASSERT(set.getMember("shared.dat") != 0);
+	}
+
+	void test_add_name_index() {
+		Common::SearchSet set;
+		set.setUseNameIndex(true);
+		addArchives(set);
+
+		TS_ASSERT_EQUALS(readId(set, "shared.dat"), 2);
+		TS_ASSERT_EQUALS(readId(set, "missing.dat"), -1);
+
+		TestArchive *top = new TestArchive(3);
+		top->addFile("shared.dat");
+		top->addFile("missing.dat");
+		set.add("top", top, 30);
+		TS_ASSERT_EQUALS(readId(set, "shared.dat"), 3);
+		TS_ASSERT_EQUALS(readId(set, "missing.dat"), 3);
+	}
+
+	void test_remove_name_index() {
+		Common::SearchSet set;
+		set.setUseNameIndex(true);
+		addArchives(set);
+
+		TS_ASSERT_EQUALS(readId(set, "low.dat"), 1);
+		TS_ASSERT_EQUALS(readId(set, "shared.dat"), 2);
+
+		set.remove("high");
+		TS_ASSERT_EQUALS(readId(set, "shared.dat"), 1);
+		set.remove("low");
+		TS_ASSERT(!set.hasFile("low.dat"));
+		TS_ASSERT_EQUALS(readId(set, "low.dat"), -1);
+	}
+
+	void test_name_index_file_gone() {
+		Common::SearchSet set;
+		set.setUseNameIndex(true);
+		TestArchive *low = addArchives(set);
+
+		// A file that disappears from the archive it was found in must not
+		// be reported by the index any more
+		TS_ASSERT(set.hasFile("low.dat"));
+		low->removeFile("low.dat");
+		TS_ASSERT(!set.hasFile("low.dat"));
+		TS_ASSERT(set.getMember("low.dat") == 0);
+		TS_ASSERT_EQUALS(readId(set, "low.dat"), -1);
+	}
+
+	void test_clear() {
+		Common::SearchSet set;
+		set.setUseNameIndex(true);
+		addArchives(set);
+
+		TS_ASSERT(set.hasFile("shared.dat"));
+		set.clear();
+		TS_ASSERT(!set.hasFile("shared.dat"));
+		TS_ASSERT_EQUALS(readId(set, "shared.dat"), -1);
+	}
+};
@@ -0,0 +1,132 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memstream.h"
+#include "common/zlib.h"
+
+class ZlibTestSuite : public CxxTest::TestSuite
+{
+	private:
+	enum {
+		// Large enough to span several decompressor checkpoints
+		kDataSize = 1300 * 1000,
+		// Large enough for the checkpoints to be thinned out
+		kLargeDataSize = 10 * 1024 * 1024
+	};
+
+	/**
+	 * Fills the buffer with pseudo random data from a small alphabet, so
+	 * that it compresses, but not into nothing.
+	 */
+	static void fillData(byte *data, uint32 size) {
+		uint32 seed = 0xC0FFEE;
+		for (uint32 i = 0; i < size; i++) {
+			seed = seed * 1103515245 + 12345;
+			data[i] = 'a' + ((seed >> 16) & 15);
+		}
+	}
+
+	static Common::SeekableReadStream *compressData(const byte *data, uint32 size) {
+		Common::MemoryWriteStreamDynamic *mem = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::NO);
+		Common::WriteStream *out = Common::wrapCompressedWriteStream(mem);
+		out->write(data, size);
+		out->finalize();
+
+		byte *compressed = mem->getData();
+		const uint32 compressedSize = mem->size();
+		delete out;
+
+		return Common::wrapCompressedReadStream(new Common::MemoryReadStream(compressed, compressedSize, DisposeAfterUse::YES));
+	}
+
+	static bool checkRead(Common::SeekableReadStream &s, const byte *data, uint32 pos, uint32 len) {
+		byte buf[64];
+		assert(len <= sizeof(buf));
+		if (s.read(buf, len) != len || (uint32)s.pos() != pos + len)
+			return false;
+		return !memcmp(buf, data + pos, len);
+	}
+
+	public:
+	void test_sequential_read() {
+		byte *data = new byte[kDataSize];
+		fillData(data, kDataSize);
+		Common::SeekableReadStream *s = compressData(data, kDataSize);
+
+		TS_ASSERT_EQUALS(s->size(), (int32)kDataSize);
+
+		byte *buf = new byte[kDataSize];
+		TS_ASSERT_EQUALS(s->read(buf, kDataSize), (uint32)kDataSize);
+		TS_ASSERT_EQUALS(memcmp(buf, data, kDataSize), 0);
+		TS_ASSERT(!s->eos());
+
+		TS_ASSERT_EQUALS(s->read(buf, 1), 0u);
+		TS_ASSERT(s->eos());
+		TS_ASSERT(!s->err());
+
+		delete[] buf;
+		delete s;
+		delete[] data;
+	}
+
+	void test_seek_across_checkpoints() {
+		byte *data = new byte[kDataSize];
+		fillData(data, kDataSize);
+		Common::SeekableReadStream *s = compressData(data, kDataSize);
+
+		// Seek forward into unread data, then back and forth over it
+		static const uint32 positions[] = {
+			1000 * 1000, 5, 262143, 262144, 262145, 1299950, 524288 + 17,
+			0, 800 * 1000, 800 * 1000 - 40, 262100, 1100 * 1000, 3
+		};
+
+		for (uint i = 0; i < ARRAYSIZE(positions); i++) {
+			TS_ASSERT(s->seek(positions[i], SEEK_SET));
+			TS_ASSERT_EQUALS((uint32)s->pos(), positions[i]);
+			TS_ASSERT(checkRead(*s, data, positions[i], 50));
+		}
+
+		// Relative seeks, including ones ending in the same checkpoint
+		// interval
+		TS_ASSERT(s->seek(900 * 1000, SEEK_SET));
+		TS_ASSERT(s->seek(-300 * 1000, SEEK_CUR));
+		TS_ASSERT(checkRead(*s, data, 600 * 1000, 64));
+		TS_ASSERT(s->seek(-64, SEEK_CUR));
+		TS_ASSERT(checkRead(*s, data, 600 * 1000, 64));
+		TS_ASSERT(s->seek(400 * 1000, SEEK_CUR));
+		TS_ASSERT(checkRead(*s, data, 1000 * 1000 + 64, 64));
+
+		// Reading past the end after a seek
+		byte buf[64];
+		TS_ASSERT(s->seek(kDataSize - 10, SEEK_SET));
+		TS_ASSERT_EQUALS(s->read(buf, sizeof(buf)), 10u);
+		TS_ASSERT(s->eos());
+		TS_ASSERT(s->seek(123456, SEEK_SET));
+		TS_ASSERT(!s->eos());
+		TS_ASSERT(checkRead(*s, data, 123456, 64));
+		TS_ASSERT(!s->err());
+
+		delete s;
+		delete[] data;
+	}
+
+	void test_seek_many_checkpoints() {
+		byte *data = new byte[kLargeDataSize];
+		fillData(data, kLargeDataSize);
+		Common::SeekableReadStream *s = compressData(data, kLargeDataSize);
+
+		static const uint32 positions[] = {
+			100, 0, 9 * 1024 * 1024 + 1, 8 * 1024 * 1024 - 1, 256 * 1024, 10 * 1024 * 1024 - 64,
+			512 * 1024 + 3, 33 * 256 * 1024, 31 * 256 * 1024 + 7, 3 * 1024 * 1024, 1
+		};
+
+		for (uint i = 0; i < ARRAYSIZE(positions); i++) {
+			TS_ASSERT(s->seek(positions[i], SEEK_SET));
+			TS_ASSERT_EQUALS((uint32)s->pos(), positions[i]);
+			TS_ASSERT(checkRead(*s, data, positions[i], 64));
+		}
+		TS_ASSERT(!s->err());
+
+		delete s;
+		delete[] data;
+	}
+};
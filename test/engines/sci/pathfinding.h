@@ -0,0 +1,353 @@
+#include <cxxtest/TestSuite.h>
+
+#include "engines/sci/engine/pathfinding.h"
+
+// Polygon sets are given as a list of polygons, each consisting of its type,
+// the number of points and the points themselves, terminated by -1
+
+// A floor with some furniture on it
+static const int16 roomFloor[] = {
+	Sci::POLY_CONTAINED_ACCESS, 6, 0, 120, 60, 100, 260, 100, 319, 120, 319, 189, 0, 189,
+	Sci::POLY_BARRED_ACCESS, 4, 100, 130, 160, 130, 160, 150, 100, 150,
+	Sci::POLY_BARRED_ACCESS, 3, 220, 140, 240, 170, 200, 170,
+	Sci::POLY_BARRED_ACCESS, 5, 30, 140, 60, 135, 75, 160, 50, 175, 25, 165,
+	-1
+};
+
+// A concave obstacle, with a pocket that is closed off by a second polygon
+static const int16 roomPocket[] = {
+	Sci::POLY_BARRED_ACCESS, 8, 80, 40, 240, 40, 240, 150, 200, 150, 200, 80, 120, 80, 120, 150, 80, 150,
+	Sci::POLY_NEAREST_ACCESS, 4, 260, 20, 300, 20, 300, 60, 260, 60,
+	Sci::POLY_TOTAL_ACCESS, 4, 10, 10, 50, 10, 50, 50, 10, 50,
+	-1
+};
+
+static const int16 roomClosedPocket[] = {
+	Sci::POLY_BARRED_ACCESS, 8, 80, 40, 240, 40, 240, 150, 200, 150, 200, 80, 120, 80, 120, 150, 80, 150,
+	Sci::POLY_BARRED_ACCESS, 4, 70, 145, 250, 145, 250, 160, 70, 160,
+	-1
+};
+
+// Obstacles along the screen border, where paths get a penalty
+static const int16 roomBorder[] = {
+	Sci::POLY_BARRED_ACCESS, 4, 0, 0, 319, 0, 319, 30, 0, 30,
+	Sci::POLY_BARRED_ACCESS, 4, 0, 100, 40, 100, 40, 189, 0, 189,
+	Sci::POLY_BARRED_ACCESS, 4, 280, 60, 319, 60, 319, 189, 280, 189,
+	Sci::POLY_BARRED_ACCESS, 4, 120, 90, 200, 90, 200, 189, 120, 189,
+	-1
+};
+
+class PathfindingTestSuite : public CxxTest::TestSuite
+{
+	/**
+	 * Creates a pathfinding state the way kAvoidPath does with optimization
+	 * level 1, or returns NULL if the start or end point can't be fixed up.
+	 */
+	static Sci::PathfindingState *createState(const int16 *polygons, const Common::Point &start, const Common::Point &end,
+		Common::Array<int16> &cachedPolygons, Common::Array<byte> &cachedVisibility) {
+		Sci::PathfindingState *s = new Sci::PathfindingState(320, 190);
+
+		while (*polygons != -1) {
+			Sci::Polygon *polygon = new Sci::Polygon(*polygons++);
+			const int count = *polygons++;
+
+			for (int i = 0; i < count; i++, polygons += 2)
+				polygon->vertices.insertHead(new Sci::Vertex(Common::Point(polygons[0], polygons[1])));
+
+			Sci::fix_vertex_order(polygon);
+			s->polygons.push_back(polygon);
+		}
+
+		Common::Point *newStart = Sci::fixup_start_point(s, start);
+		Common::Point *newEnd = newStart ? Sci::fixup_end_point(s, end) : 0;
+
+		if (!newEnd) {
+			delete newStart;
+			delete s;
+			return 0;
+		}
+
+		Sci::setup_search(s, *newStart, *newEnd, cachedPolygons, cachedVisibility);
+
+		delete newStart;
+		delete newEnd;
+		return s;
+	}
+
+	/**
+	 * Returns the path kAvoidPath would output for a searched state.
+	 */
+	static Common::Array<Common::Point> getPath(Sci::PathfindingState *s) {
+		Common::Array<Common::Point> path;
+
+		if (s->_prependPoint)
+			path.push_back(*s->_prependPoint);
+
+		if (!s->vertex_end->path_prev) {
+			if (!s->_prependPoint)
+				path.push_back(s->vertex_start->v);
+			path.push_back(s->vertex_start->v);
+			return path;
+		}
+
+		for (Sci::Vertex *vertex = s->vertex_end; vertex; vertex = vertex->path_prev)
+			path.insert_at(s->_prependPoint ? 1 : 0, vertex->v);
+
+		if (s->_appendPoint)
+			path.push_back(*s->_appendPoint);
+
+		return path;
+	}
+
+	static bool listContains(const Sci::VertexList &list, Sci::Vertex *vertex) {
+		for (Sci::VertexList::const_iterator it = list.begin(); it != list.end(); ++it) {
+			if (*it == vertex)
+				return true;
+		}
+		return false;
+	}
+
+	/**
+	 * The visibility test used before the visibility cache was added.
+	 */
+	static Sci::VertexList *referenceVisibleVertices(Sci::PathfindingState *s, Sci::Vertex *vertex_cur) {
+		Sci::VertexList *visVerts = new Sci::VertexList();
+
+		for (int i = 0; i < s->vertices; i++) {
+			Sci::Vertex *vertex = s->vertex_index[i];
+
+			if ((vertex == vertex_cur) || (Sci::inside(vertex->v, vertex_cur)) || (Sci::inside(vertex_cur->v, vertex)))
+				continue;
+
+			int j;
+			for (j = 0; j < s->vertices; j++) {
+				Sci::Vertex *edge = s->vertex_index[j];
+				if (VERTEX_HAS_EDGES(edge)) {
+					if (Sci::between(vertex_cur->v, vertex->v, edge->v)) {
+						if ((Sci::inside(vertex_cur->v, edge)) || (Sci::inside(vertex->v, edge)))
+							break;
+						continue;
+					}
+
+					if (Sci::intersect_proper(vertex_cur->v, vertex->v, edge->v, CLIST_NEXT(edge)->v))
+						break;
+				}
+			}
+
+			if (j == s->vertices)
+				visVerts->push_front(vertex);
+		}
+
+		return visVerts;
+	}
+
+	/**
+	 * The A* search with list based open and closed sets used before the
+	 * open set was turned into a heap.
+	 */
+	static void referenceAStar(Sci::PathfindingState *s) {
+		Sci::VertexList closedSet;
+		Sci::VertexList openSet;
+
+		openSet.push_front(s->vertex_start);
+		s->vertex_start->costG = 0;
+		s->vertex_start->costF = (uint32)sqrt((float)s->vertex_start->v.sqrDist(s->vertex_end->v));
+
+		while (!openSet.empty()) {
+			Sci::VertexList::iterator vertex_min_it = openSet.end();
+			Sci::Vertex *vertex_min = 0;
+			uint32 min = HUGE_DISTANCE;
+
+			for (Sci::VertexList::iterator it = openSet.begin(); it != openSet.end(); ++it) {
+				Sci::Vertex *vertex = *it;
+				if (vertex->costF < min) {
+					vertex_min_it = it;
+					vertex_min = *vertex_min_it;
+					min = vertex->costF;
+				}
+			}
+
+			if (vertex_min == s->vertex_end)
+				break;
+
+			closedSet.push_front(vertex_min);
+			openSet.erase(vertex_min_it);
+
+			Sci::VertexList *visVerts = referenceVisibleVertices(s, vertex_min);
+
+			for (Sci::VertexList::iterator it = visVerts->begin(); it != visVerts->end(); ++it) {
+				Sci::Vertex *vertex = *it;
+
+				if (listContains(closedSet, vertex))
+					continue;
+
+				if (!listContains(openSet, vertex))
+					openSet.push_front(vertex);
+
+				uint32 new_dist = vertex_min->costG + (uint32)sqrt((float)vertex_min->v.sqrDist(vertex->v));
+
+				if (s->pointOnScreenBorder(vertex->v))
+					new_dist += 10000;
+
+				if (new_dist < vertex->costG) {
+					vertex->costG = new_dist;
+					vertex->costF = vertex->costG + (uint32)sqrt((float)vertex->v.sqrDist(s->vertex_end->v));
+					vertex->path_prev = vertex_min;
+				}
+			}
+
+			delete visVerts;
+		}
+	}
+
+	/**
+	 * Checks that AStar() returns the same path as the reference search,
+	 * using the given visibility cache. Returns the path length.
+	 */
+	static uint comparePaths(const int16 *polygons, const Common::Point &start, const Common::Point &end,
+		Common::Array<int16> &cachedPolygons, Common::Array<byte> &cachedVisibility) {
+		Common::Array<int16> noPolygons;
+		Common::Array<byte> noVisibility;
+
+		Sci::PathfindingState *reference = createState(polygons, start, end, noPolygons, noVisibility);
+		Sci::PathfindingState *s = createState(polygons, start, end, cachedPolygons, cachedVisibility);
+
+		TS_ASSERT_EQUALS(reference == 0, s == 0);
+		if (!reference || !s) {
+			delete reference;
+			delete s;
+			return 0;
+		}
+
+		referenceAStar(reference);
+		Sci::AStar(s);
+
+		Common::Array<Common::Point> expected = getPath(reference);
+		Common::Array<Common::Point> path = getPath(s);
+
+		TS_ASSERT_EQUALS(path.size(), expected.size());
+		for (uint i = 0; i < MIN(path.size(), expected.size()); i++) {
+			TS_ASSERT_EQUALS(path[i].x, expected[i].x);
+			TS_ASSERT_EQUALS(path[i].y, expected[i].y);
+		}
+
+		delete reference;
+		delete s;
+		return path.size();
+	}
+
+	public:
+	void test_floor() {
+		Common::Array<int16> cachedPolygons;
+		Common::Array<byte> cachedVisibility;
+
+		TS_ASSERT_LESS_THAN(2u, comparePaths(roomFloor, Common::Point(20, 180), Common::Point(300, 110), cachedPolygons, cachedVisibility));
+		TS_ASSERT_LESS_THAN(2u, comparePaths(roomFloor, Common::Point(130, 160), Common::Point(130, 110), cachedPolygons, cachedVisibility));
+		TS_ASSERT_LESS_THAN(2u, comparePaths(roomFloor, Common::Point(300, 180), Common::Point(40, 125), cachedPolygons, cachedVisibility));
+		// Start inside the table, end inside the pillar
+		comparePaths(roomFloor, Common::Point(120, 140), Common::Point(250, 180), cachedPolygons, cachedVisibility);
+		comparePaths(roomFloor, Common::Point(10, 150), Common::Point(220, 160), cachedPolygons, cachedVisibility);
+		// End outside of the floor
+		comparePaths(roomFloor, Common::Point(250, 185), Common::Point(50, 50), cachedPolygons, cachedVisibility);
+	}
+
+	void test_floor_cold_cache() {
+		// The same paths, with the visibility cache reset for every search
+		Common::Array<int16> cachedPolygons;
+		Common::Array<byte> cachedVisibility;
+
+		comparePaths(roomFloor, Common::Point(300, 180), Common::Point(40, 125), cachedPolygons, cachedVisibility);
+		cachedPolygons.clear();
+		comparePaths(roomFloor, Common::Point(20, 180), Common::Point(300, 110), cachedPolygons, cachedVisibility);
+		cachedPolygons.clear();
+		comparePaths(roomFloor, Common::Point(130, 160), Common::Point(130, 110), cachedPolygons, cachedVisibility);
+	}
+
+	void test_pocket() {
+		Common::Array<int16> cachedPolygons;
+		Common::Array<byte> cachedVisibility;
+
+		TS_ASSERT_LESS_THAN(2u, comparePaths(roomPocket, Common::Point(160, 120), Common::Point(160, 20), cachedPolygons, cachedVisibility));
+		// End inside the near-point access polygon
+		TS_ASSERT_LESS_THAN(2u, comparePaths(roomPocket, Common::Point(160, 120), Common::Point(280, 40), cachedPolygons, cachedVisibility));
+		// Start inside the totally accessible polygon, which removes it
+		comparePaths(roomPocket, Common::Point(30, 30), Common::Point(300, 180), cachedPolygons, cachedVisibility);
+		// Start on an edge of the obstacle, which bypasses the cache
+		comparePaths(roomPocket, Common::Point(100, 40), Common::Point(160, 170), cachedPolygons, cachedVisibility);
+		comparePaths(roomPocket, Common::Point(160, 170), Common::Point(240, 100), cachedPolygons, cachedVisibility);
+	}
+
+	void test_closed_pocket() {
+		Common::Array<int16> cachedPolygons;
+		Common::Array<byte> cachedVisibility;
+
+		// The end point can't be reached from inside the pocket
+		comparePaths(roomClosedPocket, Common::Point(160, 120), Common::Point(160, 20), cachedPolygons, cachedVisibility);
+		comparePaths(roomClosedPocket, Common::Point(160, 120), Common::Point(150, 100), cachedPolygons, cachedVisibility);
+		comparePaths(roomClosedPocket, Common::Point(10, 10), Common::Point(300, 180), cachedPolygons, cachedVisibility);
+	}
+
+	void test_screen_border() {
+		Common::Array<int16> cachedPolygons;
+		Common::Array<byte> cachedVisibility;
+
+		TS_ASSERT_LESS_THAN(2u, comparePaths(roomBorder, Common::Point(60, 180), Common::Point(250, 180), cachedPolygons, cachedVisibility));
+		comparePaths(roomBorder, Common::Point(300, 40), Common::Point(20, 50), cachedPolygons, cachedVisibility);
+		comparePaths(roomBorder, Common::Point(0, 50), Common::Point(319, 40), cachedPolygons, cachedVisibility);
+	}
+
+	void test_random_obstacles() {
+		// Many overlapping obstacles, searched for many paths with the same
+		// visibility cache
+		uint32 seed = 1;
+
+		for (int set = 0; set < 8; set++) {
+			Common::Array<int16> polygons;
+
+			for (int i = 0; i < 15; i++) {
+				seed = seed * 1103515245 + 12345;
+				const int16 x = (seed >> 16) % 280;
+				seed = seed * 1103515245 + 12345;
+				const int16 y = (seed >> 16) % 160;
+				seed = seed * 1103515245 + 12345;
+				const int16 w = 5 + (seed >> 16) % 40;
+				seed = seed * 1103515245 + 12345;
+				const int16 h = 5 + (seed >> 16) % 30;
+
+				polygons.push_back(Sci::POLY_BARRED_ACCESS);
+				if (i & 1) {
+					polygons.push_back(3);
+					polygons.push_back(x);
+					polygons.push_back(y);
+					polygons.push_back(x + w);
+					polygons.push_back(y + h);
+					polygons.push_back(x);
+					polygons.push_back(y + h);
+				} else {
+					polygons.push_back(4);
+					polygons.push_back(x);
+					polygons.push_back(y);
+					polygons.push_back(x + w);
+					polygons.push_back(y);
+					polygons.push_back(x + w);
+					polygons.push_back(y + h);
+					polygons.push_back(x);
+					polygons.push_back(y + h);
+				}
+			}
+			polygons.push_back(-1);
+
+			Common::Array<int16> cachedPolygons;
+			Common::Array<byte> cachedVisibility;
+
+			for (int i = 0; i < 20; i++) {
+				seed = seed * 1103515245 + 12345;
+				const Common::Point start((seed >> 16) % 320, (seed >> 8) % 190);
+				seed = seed * 1103515245 + 12345;
+				const Common::Point end((seed >> 16) % 320, (seed >> 8) % 190);
+
+				comparePaths(polygons.begin(), start, end, cachedPolygons, cachedVisibility);
+			}
+		}
+	}
+};
@@ -5,8 +5,13 @@
 #
 ######################################################################
 
-TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h
-TEST_LIBS    := audio/libaudio.a common/libcommon.a
+TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h $(srcdir)/test/backends/*.h
+TEST_LIBS    := audio/libaudio.a backends/timer/default/default-timer.o common/libcommon.a
+
+ifdef ENABLE_SCI
+TESTS        += $(srcdir)/test/engines/sci/*.h
+TEST_LIBS    := engines/sci/libsci.a $(TEST_LIBS)
+endif
 
 #
 TEST_FLAGS   := --runner=StdioPrinter --no-std --no-eh --include=$(srcdir)/test/cxxtest_mingw.h
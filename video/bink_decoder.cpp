@@ -45,6 +45,11 @@
 #include "video/binkdata.h"
 #include "video/bink_decoder.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define BINK_USE_SSE2
+#endif
+
 static const uint32 kBIKfID = MKTAG('B', 'I', 'K', 'f');
 static const uint32 kBIKgID = MKTAG('B', 'I', 'K', 'g');
 static const uint32 kBIKhID = MKTAG('B', 'I', 'K', 'h');
@@ -768,6 +773,30 @@ uint32 BinkDecoder::readBundleCount(VideoFrame &video, Bundle &bundle) {
 	return n;
 }
 
+/**
+ * Add an 8x8 block of residues to the destination pixels. Like the scalar
+ * loop, the sums wrap around instead of being clipped.
+ */
+static inline void addBlock(byte *dest, uint32 pitch, const int16 *block) {
+#ifdef BINK_USE_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i mask = _mm_set1_epi16(0xFF);
+
+	for (int i = 0; i < 8; i++, dest += pitch, block += 8) {
+		__m128i pixels = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)dest), zero);
+
+		pixels = _mm_add_epi16(pixels, _mm_loadu_si128((const __m128i *)block));
+		pixels = _mm_and_si128(pixels, mask);
+
+		_mm_storel_epi64((__m128i *)dest, _mm_packus_epi16(pixels, zero));
+	}
+#else
+	for (int i = 0; i < 8; i++, dest += pitch, block += 8)
+		for (int j = 0; j < 8; j++)
+			dest[j] += block[j];
+#endif
+}
+
 void BinkDecoder::blockSkip(DecodeContext &ctx) {
 	byte *dest = ctx.dest;
 	byte *prev = ctx.prev;
@@ -963,11 +992,7 @@ void BinkDecoder::blockResidue(DecodeContext &ctx) {
 
 	readResidue(*ctx.video, block, v);
 
-	byte  *dst = ctx.dest;
-	int16 *src = block;
-	for (int i = 0; i < 8; i++, dst += ctx.pitch, src += 8)
-		for (int j = 0; j < 8; j++)
-			dst[j] += src[j];
+	addBlock(ctx.dest, ctx.pitch, block);
 }
 
 void BinkDecoder::blockIntra(DecodeContext &ctx) {
@@ -1600,6 +1625,146 @@ void BinkDecoder::floatToInt16Interleave(int16 *dst, const float **src, uint32 l
 #define MUNGE_ROW(x) (((x) + 0x7F)>>8)
 #define IDCT_ROW(dest,src) IDCT_TRANSFORM(dest,0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7,MUNGE_ROW,src)
 
+#ifdef BINK_USE_SSE2
+
+/** Transpose an 8x8 matrix of 16 bit values, given as eight rows. */
+static inline void transpose8x8(__m128i *r) {
+	const __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+	const __m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+	const __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+	const __m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+	const __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+	const __m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+	const __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+	const __m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+
+	const __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+	const __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+	const __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+	const __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+	const __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+	const __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+	const __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+	const __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+	r[0] = _mm_unpacklo_epi64(b0, b4);
+	r[1] = _mm_unpackhi_epi64(b0, b4);
+	r[2] = _mm_unpacklo_epi64(b1, b5);
+	r[3] = _mm_unpackhi_epi64(b1, b5);
+	r[4] = _mm_unpacklo_epi64(b2, b6);
+	r[5] = _mm_unpackhi_epi64(b2, b6);
+	r[6] = _mm_unpacklo_epi64(b3, b7);
+	r[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+/** A pair of 16 bit factors for _mm_madd_epi16(), x for the lower value. */
+static inline __m128i pairFactors(int16 x, int16 y) {
+	return _mm_set_epi16(y, x, y, x, y, x, y, x);
+}
+
+/**
+ * IDCT_TRANSFORM on four lanes. The inputs are interleaved in pairs, so that
+ * every product can be formed with _mm_madd_epi16() in full 32 bit
+ * precision, exactly like the int arithmetic of the scalar code.
+ */
+static inline void IDCTTransformSSE2(__m128i *out, __m128i p04, __m128i p26, __m128i p53, __m128i p17, bool isRow) {
+	const __m128i a0 = _mm_madd_epi16(p04, pairFactors(1,  1));
+	const __m128i a1 = _mm_madd_epi16(p04, pairFactors(1, -1));
+	const __m128i a2 = _mm_madd_epi16(p26, pairFactors(1,  1));
+	const __m128i a3 = _mm_srai_epi32(_mm_madd_epi16(p26, pairFactors(A1, -A1)), 11);
+	const __m128i a4 = _mm_madd_epi16(p53, pairFactors(1,  1));
+	const __m128i a6 = _mm_madd_epi16(p17, pairFactors(1,  1));
+
+	const __m128i b0 = _mm_add_epi32(a4, a6);
+	const __m128i b1 = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(p53, pairFactors(A3, -A3)),
+	                                                _mm_madd_epi16(p17, pairFactors(A3, -A3))), 11);
+	const __m128i b2 = _mm_add_epi32(_mm_sub_epi32(_mm_srai_epi32(_mm_madd_epi16(p53, pairFactors(A4, -A4)), 11), b0), b1);
+	const __m128i b3 = _mm_sub_epi32(_mm_srai_epi32(_mm_sub_epi32(_mm_madd_epi16(p17, pairFactors(A1, A1)),
+	                                                              _mm_madd_epi16(p53, pairFactors(A1, A1))), 11), b2);
+	const __m128i b4 = _mm_sub_epi32(_mm_add_epi32(_mm_srai_epi32(_mm_madd_epi16(p17, pairFactors(A2, -A2)), 11), b3), b1);
+
+	const __m128i a02 = _mm_add_epi32(a0, a2);
+	const __m128i a0m2 = _mm_sub_epi32(a0, a2);
+	const __m128i a13m2 = _mm_sub_epi32(_mm_add_epi32(a1, a3), a2);
+	const __m128i a1m32 = _mm_add_epi32(_mm_sub_epi32(a1, a3), a2);
+
+	out[0] = _mm_add_epi32(a02, b0);
+	out[1] = _mm_add_epi32(a13m2, b2);
+	out[2] = _mm_add_epi32(a1m32, b3);
+	out[3] = _mm_sub_epi32(a0m2, b4);
+	out[4] = _mm_add_epi32(a0m2, b4);
+	out[5] = _mm_sub_epi32(a1m32, b3);
+	out[6] = _mm_sub_epi32(a13m2, b2);
+	out[7] = _mm_sub_epi32(a02, b0);
+
+	if (isRow) {
+		const __m128i round = _mm_set1_epi32(0x7F);
+		for (int i = 0; i < 8; i++)
+			out[i] = _mm_srai_epi32(_mm_add_epi32(out[i], round), 8);
+	}
+}
+
+/** Truncate eight 32 bit values to 16 bit, like a store into an int16. */
+static inline __m128i truncateToInt16(__m128i lo, __m128i hi) {
+	lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+	hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+	return _mm_packs_epi32(lo, hi);
+}
+
+/**
+ * One IDCT pass over eight lanes. in[k] holds the k-th input of every lane,
+ * out[k] receives the k-th output of every lane.
+ */
+static inline void IDCTPassSSE2(__m128i *out, const __m128i *in, bool isRow) {
+	__m128i lo[8], hi[8];
+
+	IDCTTransformSSE2(lo, _mm_unpacklo_epi16(in[0], in[4]), _mm_unpacklo_epi16(in[2], in[6]),
+	                      _mm_unpacklo_epi16(in[5], in[3]), _mm_unpacklo_epi16(in[1], in[7]), isRow);
+	IDCTTransformSSE2(hi, _mm_unpackhi_epi16(in[0], in[4]), _mm_unpackhi_epi16(in[2], in[6]),
+	                      _mm_unpackhi_epi16(in[5], in[3]), _mm_unpackhi_epi16(in[1], in[7]), isRow);
+
+	for (int i = 0; i < 8; i++)
+		out[i] = truncateToInt16(lo[i], hi[i]);
+}
+
+/**
+ * The complete IDCT of a block. The columns are transformed in parallel,
+ * then the rows, with a transpose before and after the row pass. The
+ * result rows are returned in rows, bit exact to the scalar IDCT.
+ */
+static inline void IDCTSSE2(__m128i *rows, const int16 *block) {
+	__m128i in[8], temp[8];
+
+	for (int i = 0; i < 8; i++)
+		in[i] = _mm_loadu_si128((const __m128i *)(block + 8 * i));
+
+	IDCTPassSSE2(temp, in, false);
+	transpose8x8(temp);
+	IDCTPassSSE2(rows, temp, true);
+	transpose8x8(rows);
+}
+
+void BinkDecoder::IDCT(int16 *block) {
+	__m128i rows[8];
+	IDCTSSE2(rows, block);
+
+	for (int i = 0; i < 8; i++)
+		_mm_storeu_si128((__m128i *)(block + 8 * i), rows[i]);
+}
+
+void BinkDecoder::IDCTPut(DecodeContext &ctx, int16 *block) {
+	__m128i rows[8];
+	IDCTSSE2(rows, block);
+
+	// Storing into a byte keeps the lower 8 bits, like the scalar code
+	const __m128i mask = _mm_set1_epi16(0xFF);
+	byte *dest = ctx.dest;
+	for (int i = 0; i < 8; i++, dest += ctx.pitch)
+		_mm_storel_epi64((__m128i *)dest, _mm_packus_epi16(_mm_and_si128(rows[i], mask), mask));
+}
+
+#else
+
 static inline void IDCTCol(int16 *dest, const int16 *src)
 {
 	if ((src[8] | src[16] | src[24] | src[32] | src[40] | src[48] | src[56]) == 0) {
@@ -1627,16 +1792,6 @@ void BinkDecoder::IDCT(int16 *block) {
 	}
 }
 
-void BinkDecoder::IDCTAdd(DecodeContext &ctx, int16 *block) {
-	int i, j;
-
-	IDCT(block);
-	byte *dest = ctx.dest;
-	for (i = 0; i < 8; i++, dest += ctx.pitch, block += 8)
-		for (j = 0; j < 8; j++)
-			 dest[j] += block[j];
-}
-
 void BinkDecoder::IDCTPut(DecodeContext &ctx, int16 *block) {
 	int i;
 	int16 temp[64];
@@ -1647,4 +1802,11 @@ void BinkDecoder::IDCTPut(DecodeContext &ctx, int16 *block) {
 	}
 }
 
+#endif
+
+void BinkDecoder::IDCTAdd(DecodeContext &ctx, int16 *block) {
+	IDCT(block);
+	addBlock(ctx.dest, ctx.pitch, block);
+}
+
 } // End of namespace Video
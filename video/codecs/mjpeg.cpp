@@ -54,18 +54,24 @@ const Graphics::Surface *JPEGDecoder::decodeImage(Common::SeekableReadStream* st
 		return 0;
 	}
 
+	// The frames have the size of the JPEG components, like the surfaces
+	// returned by JPEG::getSurface()
+	const Graphics::Surface *yComponent = _jpeg->getComponent(1);
+
 	if (!_surface) {
 		_surface = new Graphics::Surface();
-		_surface->create(_jpeg->getWidth(), _jpeg->getHeight(), _pixelFormat);
+		_surface->create(yComponent->w, yComponent->h, _pixelFormat);
+	} else if (_surface->w != yComponent->w || _surface->h != yComponent->h) {
+		_surface->free();
+		_surface->create(yComponent->w, yComponent->h, _pixelFormat);
 	}
 
-	Graphics::Surface *frame = _jpeg->getSurface(_pixelFormat);
-	assert(frame);
-
-	_surface->copyFrom(*frame);
-
-	frame->free();
-	delete frame;
+	// Convert directly into our surface, instead of going through a
+	// temporary one for every frame
+	if (!_jpeg->convertToSurface(_surface)) {
+		warning("Failed to convert JPEG frame");
+		return 0;
+	}
 
 	return _surface;
 }